@@ -0,0 +1,54 @@
+"""Throughput of per-call memory API compared to bulk buffer API.
+
+Put this file next to the project file (it's in import path of server scripts)
+and call it from device `Init` script, e.g.:
+
+    import bulk_benchmark
+    bulk_benchmark.benchmark(mem4x, 5000)
+
+Result is printed into server output window.
+"""
+
+from time import perf_counter
+
+def _percall(mem, count):
+    for i in range(count):
+        mem.setuint16(i, (mem.getuint16(i) + 1) & 0xFFFF)
+
+def _memoryview(mem, count):
+    with mem.buffer(0, count) as buf:
+        regs = buf.memoryview().cast('H') # Note: native byte order, enough to measure throughput
+        for i in range(count):
+            regs[i] = (regs[i] + 1) & 0xFFFF
+
+def _numpy(mem, count):
+    with mem.buffer(0, count) as buf:
+        regs = buf.numpy('uint16')
+        regs += 1
+
+def _view(mem, count):
+    # Note: read-only access without copying, changes still go through buffer
+    regs = mem.view(0, count).cast('H')
+    with mem.buffer(0, count) as buf:
+        out = buf.memoryview().cast('H')
+        for i in range(count):
+            out[i] = (regs[i] + 1) & 0xFFFF
+
+def _measure(name, func, mem, count, cycles):
+    tm = perf_counter()
+    for _ in range(cycles):
+        func(mem, count)
+    tm = perf_counter() - tm
+    print(f"{name:<12}: {cycles/tm:10.1f} cycles/s, {count*cycles/tm:12.0f} regs/s")
+
+def benchmark(mem, count:int=5000, cycles:int=100):
+    """Reads, increments and writes back `count` registers of `mem` (mem3x or mem4x) `cycles` times."""
+    print(f"Benchmark of {count} registers, {cycles} cycles")
+    _measure("per-call"  , _percall   , mem, count, cycles)
+    _measure("memoryview", _memoryview, mem, count, cycles)
+    _measure("view"      , _view      , mem, count, cycles)
+    try:
+        import numpy
+        _measure("numpy", _numpy, mem, count, cycles)
+    except ImportError:
+        print("numpy     : not installed")
@@ -37,6 +37,7 @@ mbClientDeviceRunnable::mbClientDeviceRunnable(mbClientRunDevice *device, Modbus
     m_device = device;
     m_modbusClientPort = modbusClientPort;
     m_modbusClient = new ModbusClient(m_device->unit(), m_modbusClientPort);
+    m_logSourceId = mbClient::LogSourceId(m_device->name());
     createReadMessages();
 }
 
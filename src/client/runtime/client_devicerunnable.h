@@ -51,6 +51,8 @@ public:
 
 public:
     QString name() const;
+    // Note: name of the device is not changed while running, so its log source id is found once
+    inline quint16 logSourceId() const { return m_logSourceId; }
     inline mbClientRunDevice *device() const { return m_device; }
     inline ModbusClient *modbusClient() const { return m_modbusClient; }
     inline mbClientRunMessagePtr currentMessage() const { return m_currentMessage; }
@@ -84,6 +86,7 @@ private:
     ModbusClientPort *m_modbusClientPort;
     ModbusClient *m_modbusClient;
     uint8_t m_byteCount;
+    quint16 m_logSourceId;
 
 private:
     typedef QQueue<mbClientRunMessagePtr> Messages_t;
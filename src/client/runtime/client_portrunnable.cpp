@@ -41,6 +41,7 @@ mbClientPortRunnable::mbClientPortRunnable(mbClientRunPort *port, const Modbus::
 {
     m_state = STATE_PAUSE;
     m_port = port;
+    m_logSourceId = 0;
     m_stat = m_port->statistic();
     m_devices = m_port->devices();
     m_modbusClientPort = Modbus::createClientPort(settings);
@@ -74,6 +75,12 @@ mbClientPortRunnable::~mbClientPortRunnable()
     delete m_modbusClientPort;
 }
 
+void mbClientPortRunnable::setName(const QString &name)
+{
+    setObjectName(name);
+    m_logSourceId = mbClient::LogSourceId(name);
+}
+
 void mbClientPortRunnable::run()
 {
     switch (m_state)
@@ -175,13 +182,13 @@ void mbClientPortRunnable::slotBytesTx(const Modbus::Char */*source*/, const uin
     if (r)
     {
         r->currentMessage()->setBytesTx(bytes);
-        mbClient::LogTx(r->name(), Modbus::bytesToString(buff, size).data());
+        mbClient::LogData(mb::Log_Tx, r->logSourceId(), mbCoreLogRecord::Format_Bytes, buff, size);
     }
     else
     {
         if (m_modbusClientPort->currentClient() == m_modbusClientPort)
             m_currentMessage->setBytesTx(bytes);
-        mbClient::LogTx(name(), Modbus::bytesToString(buff, size).data());
+        mbClient::LogData(mb::Log_Tx, m_logSourceId, mbCoreLogRecord::Format_Bytes, buff, size);
     }
     m_stat.countTx++;
     m_port->setStatCountTx(m_stat.countTx);
@@ -195,13 +202,13 @@ void mbClientPortRunnable::slotBytesRx(const Modbus::Char */*source*/, const uin
     if (r)
     {
         r->currentMessage()->setBytesRx(bytes);
-        mbClient::LogRx(r->name(), Modbus::bytesToString(buff, size).data());
+        mbClient::LogData(mb::Log_Rx, r->logSourceId(), mbCoreLogRecord::Format_Bytes, buff, size);
     }
     else
     {
         if (m_modbusClientPort->currentClient() == m_modbusClientPort)
             m_currentMessage->setBytesRx(bytes);
-        mbClient::LogRx(name(), Modbus::bytesToString(buff, size).data());
+        mbClient::LogData(mb::Log_Rx, m_logSourceId, mbCoreLogRecord::Format_Bytes, buff, size);
     }
     m_stat.countRx++;
     m_port->setStatCountRx(m_stat.countRx);
@@ -215,13 +222,13 @@ void mbClientPortRunnable::slotAsciiTx(const Modbus::Char */*source*/, const uin
     if (r)
     {
         r->currentMessage()->setAsciiTx(bytes);
-        mbClient::LogTx(r->name(), Modbus::asciiToString(buff, size).data());
+        mbClient::LogData(mb::Log_Tx, r->logSourceId(), mbCoreLogRecord::Format_Ascii, buff, size);
     }
     else
     {
         if (m_modbusClientPort->currentClient() == m_modbusClientPort)
             m_currentMessage->setAsciiTx(bytes);
-        mbClient::LogTx(name(), Modbus::asciiToString(buff, size).data());
+        mbClient::LogData(mb::Log_Tx, m_logSourceId, mbCoreLogRecord::Format_Ascii, buff, size);
     }
     m_stat.countTx++;
     m_port->setStatCountTx(m_stat.countTx);
@@ -235,13 +242,13 @@ void mbClientPortRunnable::slotAsciiRx(const Modbus::Char */*source*/, const uin
     if (r)
     {
         r->currentMessage()->setAsciiRx(bytes);
-        mbClient::LogRx(r->name(), Modbus::asciiToString(buff, size).data());
+        mbClient::LogData(mb::Log_Rx, r->logSourceId(), mbCoreLogRecord::Format_Ascii, buff, size);
     }
     else
     {
         if (m_modbusClientPort->currentClient() == m_modbusClientPort)
             m_currentMessage->setAsciiRx(bytes);
-        mbClient::LogRx(name(), Modbus::asciiToString(buff, size).data());
+        mbClient::LogData(mb::Log_Rx, m_logSourceId, mbCoreLogRecord::Format_Ascii, buff, size);
     }
     m_stat.countRx++;
     m_port->setStatCountRx(m_stat.countRx);
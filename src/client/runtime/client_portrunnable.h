@@ -53,7 +53,7 @@ public:
 
 public:
     inline QString name() const { return objectName(); }
-    inline void setName(const QString &name) { setObjectName(name); }
+    void setName(const QString &name);
     
 public:
     void run();
@@ -81,6 +81,7 @@ private:
     QList<mbClientRunDevice*> m_devices;
     mbClientPort::Statistic m_stat;
     mbClientRunMessagePtr m_currentMessage;
+    quint16 m_logSourceId; // Note: id of the port name is cached to avoid its search for every frame
 
 private:
     typedef QList<mbClientDeviceRunnable*> Runnables_t;
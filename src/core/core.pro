@@ -30,3 +30,12 @@ HEADERS +=
 SOURCES +=
 
 LIBS  += -L../../bin -lmodbus
+
+# Note: zlib is optional, without it log file rotation works but rotated files are not compressed
+unix {
+    CONFIG += link_pkgconfig
+    packagesExist(zlib) {
+        PKGCONFIG += zlib
+        DEFINES += MB_LOGFILE_GZIP
+    }
+}
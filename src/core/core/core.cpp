@@ -26,12 +26,14 @@
 
 #include <QApplication>
 #include <QDateTime>
+#include <QTimerEvent>
 
 #include <Modbus.h>
 
 #include "task/core_taskfactoryinfo.h"
 #include "sdk/mbcore_taskfactory.h"
 #include "core_filemanager.h"
+#include "core_logfile.h"
 #include "plugin/core_pluginmanager.h"
 #include "project/core_project.h"
 #include "project/core_dataview.h"
@@ -80,6 +82,13 @@ mbCore::Strings::Strings() :
     settings_logFlags       (QStringLiteral("Log.Flags"         )),
     settings_useTimestamp   (QStringLiteral("Log.UseTimestamp"  )),
     settings_formatDateTime (QStringLiteral("Log.FormatDateTime")),
+    settings_logFileEnable  (QStringLiteral("Log.File.Enable"      )),
+    settings_logFilePath    (QStringLiteral("Log.File.Path"        )),
+    settings_logFileFlags   (QStringLiteral("Log.File.Flags"       )),
+    settings_logFileMaxSize (QStringLiteral("Log.File.MaxSize"     )),
+    settings_logFilePeriod  (QStringLiteral("Log.File.RotatePeriod")),
+    settings_logFileMaxCount(QStringLiteral("Log.File.MaxCount"    )),
+    settings_logFileCompress(QStringLiteral("Log.File.Compress"    )),
     settings_addressNotation(QStringLiteral("AddressNotation"   )),
     settings_columns        (QStringLiteral("DataView.Columns"  ))
 {
@@ -95,7 +104,15 @@ mbCore::Defaults::Defaults() :
     settings_logFlags       (mb::Log_Error|mb::Log_Warning|mb::Log_Info|mb::Log_Tx|mb::Log_Rx),
     settings_useTimestamp   (true),
     settings_formatDateTime (QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz")),
+    settings_logFileEnable  (false),
+    settings_logFilePath    (QString()),
+    settings_logFileFlags   (mb::Log_Error|mb::Log_Warning|mb::Log_Info|mb::Log_Tx|mb::Log_Rx),
+    settings_logFileMaxSize (10),
+    settings_logFilePeriod  (0),
+    settings_logFileMaxCount(10),
+    settings_logFileCompress(false),
     settings_addressNotation(mb::Address::Notation_Modbus),
+    logInterval             (50),
     tray                    (false),
     availableBaudRate       (mb::availableBaudRate   ()),
     availableDataBits       (mb::availableDataBits   ()),
@@ -123,13 +140,23 @@ mbCore::mbCore(const QString &application, QObject *parent) : mbCoreBase(parent)
     m_runtime = nullptr;
     m_ui = nullptr;
     m_project = nullptr;
+    m_logProcessing = false;
+    m_logTimerId = 0;
+    m_logFile = nullptr;
 
-    connect(this, &mbCore::signalLog   , this, &mbCore::logMessageThreadUnsafe);
     connect(this, &mbCore::signalOutput, this, &mbCore::outputMessageThreadUnsafe);
 
     m_settings.logFlags        = d.settings_logFlags       ;
+    m_logMask                  = d.settings_logFlags       ;
     m_settings.useTimestamp    = d.settings_useTimestamp   ;
     m_settings.formatDateTime  = d.settings_formatDateTime ;
+    m_settings.logFileEnable   = d.settings_logFileEnable  ;
+    m_settings.logFilePath     = d.settings_logFilePath    ;
+    m_settings.logFileFlags    = d.settings_logFileFlags   ;
+    m_settings.logFileMaxSize  = d.settings_logFileMaxSize ;
+    m_settings.logFilePeriod   = d.settings_logFilePeriod  ;
+    m_settings.logFileMaxCount = d.settings_logFileMaxCount;
+    m_settings.logFileCompress = d.settings_logFileCompress;
     m_settings.addressNotation = d.settings_addressNotation;
     m_config = new QSettings(s.settings_organization, application, this);
 }
@@ -176,6 +203,7 @@ int mbCore::exec(int argc, char **argv)
     int r;
     if ((r = parseArgs(argc, argv)))
         return r;
+    m_logTimerId = startTimer(Defaults::instance().logInterval);
     //qInstallMessageHandler(coreMessageHandler);
     setColumnNames(availableDataViewColumns());
     bool gui = m_args.value(Arg_Gui, true).toBool();
@@ -188,6 +216,9 @@ int mbCore::exec(int argc, char **argv)
     else
         r = runConsole();
     stop();
+    processLog();
+    delete m_logFile; // Note: all pending records are written before writer thread is finished
+    m_logFile = nullptr;
     return r;
 }
 
@@ -272,6 +303,12 @@ int mbCore::parseArgs(int &argc, char **argv)
                 m_args[Arg_Tray] = false;
                 continue;
             }
+            if (!qstrcmp(argv[i], "-log-file"))
+            {
+                if (++i < argc)
+                    m_args[Arg_LogFile] = QString(argv[i]);
+                continue;
+            }
             std::cerr << "Unknown parameter " << argv[i];
             return 1;
         }
@@ -326,7 +363,7 @@ int mbCore::runConsole()
     }
     else
     {
-        logMessageThreadUnsafe(mb::Log_Error, applicationName(), QStringLiteral("No project defined"));
+        logMessageThreadSafe(mb::Log_Error, applicationName(), QStringLiteral("No project defined"));
     }
     saveCachedSettings();
     return r;
@@ -438,6 +475,13 @@ MBSETTINGS mbCore::cachedSettings() const
     r[s.settings_logFlags       ] = static_cast<uint>(logFlags());
     r[s.settings_useTimestamp   ] = useTimestamp  ();
     r[s.settings_formatDateTime ] = formatDateTime();
+    r[s.settings_logFileEnable  ] = logFileEnable  ();
+    r[s.settings_logFilePath    ] = logFilePath    ();
+    r[s.settings_logFileFlags   ] = static_cast<uint>(logFileFlags());
+    r[s.settings_logFileMaxSize ] = logFileMaxSize ();
+    r[s.settings_logFilePeriod  ] = logFilePeriod  ();
+    r[s.settings_logFileMaxCount] = logFileMaxCount();
+    r[s.settings_logFileCompress] = logFileCompress();
     r[s.settings_addressNotation] = mb::toString(addressNotation());
     r[s.settings_columns        ] = columnNames();
     return r;
@@ -480,6 +524,60 @@ void mbCore::setCachedSettings(const MBSETTINGS &settings)
         setFormatDateTime(v);
     }
 
+    it = settings.find(s.settings_logFileEnable);
+    if (it != end)
+    {
+        bool v = it.value().toBool();
+        setLogFileEnable(v);
+    }
+
+    it = settings.find(s.settings_logFilePath);
+    if (it != end)
+    {
+        QString v = it.value().toString();
+        setLogFilePath(v);
+    }
+
+    it = settings.find(s.settings_logFileFlags);
+    if (it != end)
+    {
+        mb::LogFlag v = static_cast<mb::LogFlag>(it.value().toInt(&ok));
+        if (ok)
+            setLogFileFlags(v);
+    }
+
+    it = settings.find(s.settings_logFileMaxSize);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok && (v >= 0))
+            setLogFileMaxSize(v);
+    }
+
+    it = settings.find(s.settings_logFilePeriod);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok && (v >= 0))
+            setLogFilePeriod(v);
+    }
+
+    it = settings.find(s.settings_logFileMaxCount);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok && (v >= 0))
+            setLogFileMaxCount(v);
+    }
+
+    it = settings.find(s.settings_logFileCompress);
+    if (it != end)
+    {
+        bool v = it.value().toBool();
+        setLogFileCompress(v);
+    }
+    updateLogFile();
+
     it = settings.find(s.settings_addressNotation);
     if (it != end)
     {
@@ -501,10 +599,25 @@ void mbCore::setCachedSettings(const MBSETTINGS &settings)
 
 void mbCore::logMessageThreadSafe(mb::LogFlag flag, const QString &source, const QString &text)
 {
+    quint16 sourceId = m_logBuffer.sourceId(source);
     if (thread() == QThread::currentThread())
-        logMessageThreadUnsafe(flag, source, text);
+    {
+        // Note: records of other threads are processed before, so order of the messages is kept
+        if (!m_logBuffer.push(flag, sourceId, text))
+        {
+            processLog();
+            m_logBuffer.push(flag, sourceId, text);
+        }
+        processLog();
+    }
     else
-        Q_EMIT signalLog(flag, source, text);
+        m_logBuffer.push(flag, sourceId, text); // Note: queue is processed by timer in the main thread
+}
+
+void mbCore::logDataThreadSafe(mb::LogFlag flag, quint16 sourceId, mbCoreLogRecord::Format format, const quint8 *buff, int size)
+{
+    if (m_logBuffer.push(flag, sourceId, format, buff, size) && (thread() == QThread::currentThread()))
+        processLog();
 }
 
 void mbCore::outputMessageThreadSafe(const QString &text)
@@ -515,15 +628,119 @@ void mbCore::outputMessageThreadSafe(const QString &text)
         Q_EMIT signalOutput(text);
 }
 
-void mbCore::logMessageThreadUnsafe(mb::LogFlag flag, const QString &source, const QString &text)
+void mbCore::processLog()
 {
-    if (m_ui)
-        m_ui->logMessage(flag, source, text);
+    const int BatchSize = 1024;
+    // Note: message that is logged (in the main thread) while batch is processed
+    //       stays in the queue and will be taken by the next iteration
+    if (m_logProcessing)
+        return;
+    m_logProcessing = true;
+    for (;;)
+    {
+        // Note: records are compact, so vector grows up to the size of the actual batch instead of reserving the max one
+        m_logRecords.clear();
+        m_logBuffer.pop(m_logRecords, BatchSize);
+        if (quint32 dropped = m_logBuffer.takeDroppedCount())
+        {
+            mbCoreLogRecord r;
+            r.time = m_logBuffer.currentTime();
+            r.flag = mb::Log_Warning;
+            r.source = m_logBuffer.sourceId(applicationName());
+            r.format = mbCoreLogRecord::Format_Text;
+            r.message = QString("%1 log message(s) were dropped because log queue is full").arg(dropped);
+            m_logRecords.append(r);
+        }
+        if (m_logRecords.isEmpty())
+            break;
+        QVector<mbCoreLogRecord> viewRecords;
+        const QVector<mbCoreLogRecord> *records = &m_logRecords;
+        if (m_logMask != m_settings.logFlags)
+        {
+            // Note: queue contains records that are needed for the file only
+            Q_FOREACH (const mbCoreLogRecord &r, m_logRecords)
+            {
+                if (m_settings.logFlags & r.flag)
+                    viewRecords.append(r);
+            }
+            records = &viewRecords;
+        }
+        if (m_ui)
+        {
+            if (records->count())
+                m_ui->logRecords(*records);
+        }
+        else
+        {
+            // Note: console output is written once per batch
+            std::string out;
+            Q_FOREACH (const mbCoreLogRecord &r, *records)
+            {
+                QString msg = QString("%1 '%2' %3: %4\n").arg(QDateTime::fromMSecsSinceEpoch(r.timestamp()).toString(m_settings.formatDateTime),
+                                                              m_logBuffer.sourceName(r.source),
+                                                              mb::toString(r.flag),
+                                                              r.text());
+                out += msg.toStdString();
+            }
+            std::cout << out << std::flush;
+        }
+        if (m_logFile)
+        {
+            m_logFile->write(m_logRecords);
+            // Note: batch is shared with file writer now, so new vector is used for the next batch
+            m_logRecords = QVector<mbCoreLogRecord>();
+        }
+    }
+    m_logProcessing = false;
+}
+
+void mbCore::updateLogMask()
+{
+    m_logMask = m_settings.logFlags;
+    if (m_logFile)
+        m_logMask |= m_logFile->flags();
+}
+
+void mbCore::updateLogFile()
+{
+    QString filePath = m_args.contains(Arg_LogFile) ? m_args.value(Arg_LogFile).toString() : m_settings.logFilePath;
+    if (!(m_settings.logFileEnable || m_args.contains(Arg_LogFile)))
+    {
+        if (m_logFile)
+        {
+            processLog();
+            delete m_logFile;
+            m_logFile = nullptr;
+        }
+        updateLogMask();
+        return;
+    }
+    if (filePath.isEmpty())
+        filePath = applicationName() + QStringLiteral(".log");
+    mbCoreLogFile::Settings s;
+    s.filePath       = filePath;
+    s.flags          = m_settings.logFileFlags;
+    s.maxSize        = static_cast<qint64>(m_settings.logFileMaxSize) * 1024 * 1024;
+    s.rotatePeriod   = m_settings.logFilePeriod * 3600;
+    s.maxCount       = m_settings.logFileMaxCount;
+    s.compress       = m_settings.logFileCompress;
+    s.useTimestamp   = m_settings.useTimestamp;
+    s.formatDateTime = m_settings.formatDateTime;
+    if (m_logFile)
+        m_logFile->setSettings(s);
     else
     {
-        QString msg = QString("%1 %2").arg(QDateTime::currentDateTime().toString(m_settings.formatDateTime), msg);
-        std::cout << msg.toStdString();
+        m_logFile = new mbCoreLogFile(&m_logBuffer, this);
+        m_logFile->setSettings(s);
+        m_logFile->start();
     }
+    updateLogMask();
+}
+
+void mbCore::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_logTimerId)
+        processLog();
 }
 
 void mbCore::outputMessageThreadUnsafe(const QString &text)
@@ -29,6 +29,9 @@
 
 #include <mbcore_base.h>
 #include "core_global.h"
+#include "core_logbuffer.h"
+
+class mbCoreLogFile;
 
 class QCoreApplication;
 
@@ -56,6 +59,13 @@ public:
         const QString settings_logFlags       ;
         const QString settings_useTimestamp   ;
         const QString settings_formatDateTime ;
+        const QString settings_logFileEnable  ;
+        const QString settings_logFilePath    ;
+        const QString settings_logFileFlags   ;
+        const QString settings_logFileMaxSize ;
+        const QString settings_logFilePeriod  ;
+        const QString settings_logFileMaxCount;
+        const QString settings_logFileCompress;
         const QString settings_addressNotation;
         const QString settings_columns        ;
         Strings();
@@ -67,7 +77,15 @@ public:
         const mb::LogFlags        settings_logFlags       ;
         const bool                settings_useTimestamp   ;
         const QString             settings_formatDateTime ;
+        const bool                settings_logFileEnable  ;
+        const QString             settings_logFilePath    ;
+        const mb::LogFlags        settings_logFileFlags   ;
+        const int                 settings_logFileMaxSize ; // megabytes
+        const int                 settings_logFilePeriod  ; // hours
+        const int                 settings_logFileMaxCount;
+        const bool                settings_logFileCompress;
         const mb::AddressNotation settings_addressNotation;
+        const int                 logInterval             ; // period (msec) of log queue processing
         const bool                tray                    ;
         const QVariantList        availableBaudRate       ;
         const QVariantList        availableDataBits       ;
@@ -85,6 +103,7 @@ public:
         Arg_Project,
         Arg_Singleton,
         Arg_Tray,
+        Arg_LogFile,
         ArgCount
     };
 
@@ -106,6 +125,8 @@ public:
     static inline void LogTx     (const QString &source, const QString &text) { s_globalCore->logTx     (source, text); }
     static inline void LogRx     (const QString &source, const QString &text) { s_globalCore->logRx     (source, text); }
     static inline void LogDebug  (const QString &source, const QString &text) { s_globalCore->logDebug  (source, text); }
+    static inline void LogData(mb::LogFlag flag, quint16 sourceId, mbCoreLogRecord::Format format, const quint8 *buff, int size) { s_globalCore->logData(flag, sourceId, format, buff, size); }
+    static inline quint16 LogSourceId(const QString &source) { return s_globalCore->logSourceId(source); }
     static inline void OutputMessage(const QString &text) { s_globalCore->outputMessage(text); }
 
 public:
@@ -132,11 +153,28 @@ public:
 
 public:
     inline mb::LogFlags logFlags() const { return m_settings.logFlags; }
-    inline void setLogFlags(mb::LogFlags logFlags) { m_settings.logFlags = logFlags; }
+    inline void setLogFlags(mb::LogFlags logFlags) { m_settings.logFlags = logFlags; updateLogMask(); }
     inline bool useTimestamp() const { return m_settings.useTimestamp; }
     inline void setUseTimestamp(bool useTimestamp) { m_settings.useTimestamp = useTimestamp; }
     inline QString formatDateTime() const { return m_settings.formatDateTime; }
     inline void setFormatDateTime(const QString& formatDateTime) { m_settings.formatDateTime = formatDateTime; }
+    // Note: settings of the log file are applied by 'updateLogFile()'
+    inline bool logFileEnable() const { return m_settings.logFileEnable; }
+    inline void setLogFileEnable(bool enable) { m_settings.logFileEnable = enable; }
+    inline QString logFilePath() const { return m_settings.logFilePath; }
+    inline void setLogFilePath(const QString &path) { m_settings.logFilePath = path; }
+    inline mb::LogFlags logFileFlags() const { return m_settings.logFileFlags; }
+    inline void setLogFileFlags(mb::LogFlags flags) { m_settings.logFileFlags = flags; }
+    inline int logFileMaxSize() const { return m_settings.logFileMaxSize; }
+    inline void setLogFileMaxSize(int megabytes) { m_settings.logFileMaxSize = megabytes; }
+    inline int logFilePeriod() const { return m_settings.logFilePeriod; }
+    inline void setLogFilePeriod(int hours) { m_settings.logFilePeriod = hours; }
+    inline int logFileMaxCount() const { return m_settings.logFileMaxCount; }
+    inline void setLogFileMaxCount(int count) { m_settings.logFileMaxCount = count; }
+    inline bool logFileCompress() const { return m_settings.logFileCompress; }
+    inline void setLogFileCompress(bool compress) { m_settings.logFileCompress = compress; }
+    // Starts, reconfigures or stops log file writer according to the current settings
+    void updateLogFile();
     inline mb::AddressNotation addressNotation() const { return m_settings.addressNotation; }
     void setAddressNotation(mb::AddressNotation notation);
 
@@ -157,13 +195,17 @@ public: // core base interface
     virtual QWidget* topLevel() const;
 
 public: // log interface
-    inline void logMessage(mb::LogFlag flag, const QString &source, const QString &text) { if (m_settings.logFlags & flag) logMessageThreadSafe(flag, source, text); }
+    inline void logMessage(mb::LogFlag flag, const QString &source, const QString &text) { if (m_logMask & flag) logMessageThreadSafe(flag, source, text); }
     inline void logError  (const QString &source, const QString &text) { logMessage(mb::Log_Error  , source, text); }
     inline void logWarning(const QString &source, const QString &text) { logMessage(mb::Log_Warning, source, text); }
     inline void logInfo   (const QString &source, const QString &text) { logMessage(mb::Log_Info   , source, text); }
     inline void logTx     (const QString &source, const QString &text) { logMessage(mb::Log_Tx     , source, text); }
     inline void logRx     (const QString &source, const QString &text) { logMessage(mb::Log_Rx     , source, text); }
     inline void logDebug  (const QString &source, const QString &text) { logMessage(mb::Log_Debug  , source, text); }
+    // Logs raw data (e.g. Tx/Rx frame) that is converted to text only when log record is displayed
+    inline void logData(mb::LogFlag flag, quint16 sourceId, mbCoreLogRecord::Format format, const quint8 *buff, int size) { if (m_logMask & flag) logDataThreadSafe(flag, sourceId, format, buff, size); }
+    inline quint16 logSourceId(const QString &source) { return m_logBuffer.sourceId(source); }
+    inline mbCoreLogBuffer *logBuffer() { return &m_logBuffer; }
 
 public: // output
     inline void outputMessage(const QString &text) { outputMessageThreadSafe(text); }
@@ -189,7 +231,6 @@ Q_SIGNALS:
     void columnsChanged();
 
 Q_SIGNALS:
-    void signalLog(mb::LogFlag flag, const QString &source, const QString &text);
     void signalOutput(const QString &text);
 
 public:
@@ -212,10 +253,16 @@ protected:
 
 private:
     void logMessageThreadSafe(mb::LogFlag flag, const QString &source, const QString &text);
+    void logDataThreadSafe(mb::LogFlag flag, quint16 sourceId, mbCoreLogRecord::Format format, const quint8 *buff, int size);
     void outputMessageThreadSafe(const QString &text);
 
+    void processLog();
+    void updateLogMask();
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
 private Q_SLOTS:
-    void logMessageThreadUnsafe(mb::LogFlag flag, const QString &source, const QString &text);
     void outputMessageThreadUnsafe(const QString &text);
 
 private:
@@ -236,6 +283,12 @@ protected:
     QCoreApplication* m_app;
     QSettings* m_config;
     QSharedMemory m_shared;
+    mbCoreLogBuffer m_logBuffer;
+    QVector<mbCoreLogRecord> m_logRecords;
+    mbCoreLogFile *m_logFile;
+    mb::LogFlags m_logMask; // flags of the messages that are needed for the view or the file
+    bool m_logProcessing;
+    int m_logTimerId;
 
 protected:
     MBPARAMS m_args;
@@ -245,6 +298,13 @@ protected:
         mb::LogFlags        logFlags       ;
         bool                useTimestamp   ;
         QString             formatDateTime ;
+        bool                logFileEnable  ;
+        QString             logFilePath    ;
+        mb::LogFlags        logFileFlags   ;
+        int                 logFileMaxSize ;
+        int                 logFilePeriod  ;
+        int                 logFileMaxCount;
+        bool                logFileCompress;
         mb::AddressNotation addressNotation;
         QList<int>          columns        ;
     } m_settings;
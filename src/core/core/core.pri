@@ -1,9 +1,13 @@
 HEADERS += \
     $$PWD/core.h \
     $$PWD/core_filemanager.h \
-    $$PWD/core_global.h
+    $$PWD/core_global.h \
+    $$PWD/core_logbuffer.h \
+    $$PWD/core_logfile.h
 
 SOURCES += \
     $$PWD/core.cpp \
     $$PWD/core_filemanager.cpp \
-    $$PWD/core_global.cpp
+    $$PWD/core_global.cpp \
+    $$PWD/core_logbuffer.cpp \
+    $$PWD/core_logfile.cpp
@@ -0,0 +1,197 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_logbuffer.h"
+
+#include <cstring>
+
+#include <QDateTime>
+
+#include <Modbus.h>
+
+QString mbCoreLogRecord::text() const
+{
+    if (format == Format_Text)
+        return message;
+    return toString(static_cast<Format>(format), reinterpret_cast<const quint8*>(data.constData()), data.size());
+}
+
+QString mbCoreLogRecord::toString(Format format, const quint8 *data, int size)
+{
+    switch (format)
+    {
+    case Format_Bytes:
+        return QString::fromStdString(Modbus::bytesToString(data, static_cast<uint16_t>(size)));
+    case Format_Ascii:
+        return QString::fromStdString(Modbus::asciiToString(data, static_cast<uint16_t>(size)));
+    default:
+        return QString::fromUtf8(reinterpret_cast<const char*>(data), size);
+    }
+}
+
+mbCoreLogBuffer::mbCoreLogBuffer(int capacity)
+{
+    quint32 c = 2;
+    while (c < static_cast<quint32>(capacity))
+        c <<= 1;
+    m_mask = c - 1;
+    m_cells = new Cell[c];
+    for (quint32 i = 0; i < c; i++)
+        m_cells[i].seq.store(i, std::memory_order_relaxed);
+    m_pushPos.store(0, std::memory_order_relaxed);
+    m_popPos = 0;
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_startTime = QDateTime::currentMSecsSinceEpoch() * 1000;
+    m_timer.start();
+    m_sources.append(QString()); // Note: id 0 is reserved for empty source
+    m_sourceIds.insert(QString(), 0);
+}
+
+mbCoreLogBuffer::~mbCoreLogBuffer()
+{
+    delete[] m_cells;
+}
+
+qint64 mbCoreLogBuffer::currentTime() const
+{
+    return m_startTime + m_timer.nsecsElapsed() / 1000;
+}
+
+quint16 mbCoreLogBuffer::sourceId(const QString &source)
+{
+    {
+        QReadLocker _(&m_sourcesLock);
+        QHash<QString, quint16>::const_iterator it = m_sourceIds.find(source);
+        if (it != m_sourceIds.end())
+            return it.value();
+    }
+    QWriteLocker _(&m_sourcesLock);
+    QHash<QString, quint16>::const_iterator it = m_sourceIds.find(source);
+    if (it != m_sourceIds.end())
+        return it.value();
+    if (m_sources.count() > 0xFFFF)
+        return 0;
+    quint16 id = static_cast<quint16>(m_sources.count());
+    m_sources.append(source);
+    m_sourceIds.insert(source, id);
+    return id;
+}
+
+QString mbCoreLogBuffer::sourceName(quint16 id) const
+{
+    QReadLocker _(&m_sourcesLock);
+    return m_sources.value(id);
+}
+
+bool mbCoreLogBuffer::push(mb::LogFlag flag, quint16 source, const QString &text)
+{
+    quint32 pos;
+    Cell *cell = beginPush(pos);
+    if (!cell)
+        return false;
+    cell->flag = flag;
+    cell->source = source;
+    cell->format = mbCoreLogRecord::Format_Text;
+    cell->size = 0;
+    cell->message = text;
+    endPush(cell, pos);
+    return true;
+}
+
+bool mbCoreLogBuffer::push(mb::LogFlag flag, quint16 source, mbCoreLogRecord::Format format, const quint8 *data, int size)
+{
+    quint32 pos;
+    Cell *cell = beginPush(pos);
+    if (!cell)
+        return false;
+    if (size > mbCoreLogRecord::MaxDataSize)
+        size = mbCoreLogRecord::MaxDataSize;
+    cell->flag = flag;
+    cell->source = source;
+    cell->format = static_cast<quint8>(format);
+    cell->size = static_cast<quint16>(size);
+    memcpy(cell->data, data, static_cast<size_t>(size));
+    endPush(cell, pos);
+    return true;
+}
+
+int mbCoreLogBuffer::pop(QVector<mbCoreLogRecord> &records, int maxCount)
+{
+    int c = 0;
+    while (c < maxCount)
+    {
+        Cell *cell = &m_cells[m_popPos & m_mask];
+        // Note: cell contains record when its sequence is next after the position
+        if (cell->seq.load(std::memory_order_acquire) != m_popPos + 1)
+            break;
+        mbCoreLogRecord r;
+        r.time = cell->time;
+        r.flag = cell->flag;
+        r.source = cell->source;
+        r.format = cell->format;
+        if (cell->format == mbCoreLogRecord::Format_Text)
+        {
+            r.message = cell->message;
+            cell->message = QString(); // Note: release text in the reader thread
+        }
+        else
+            r.data = QByteArray(reinterpret_cast<const char*>(cell->data), cell->size);
+        records.append(r);
+        // Note: cell becomes free for writer on the next round of the queue
+        cell->seq.store(m_popPos + m_mask + 1, std::memory_order_release);
+        m_popPos++;
+        c++;
+    }
+    return c;
+}
+
+mbCoreLogBuffer::Cell *mbCoreLogBuffer::beginPush(quint32 &pos)
+{
+    pos = m_pushPos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell *cell = &m_cells[pos & m_mask];
+        qint32 diff = static_cast<qint32>(cell->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0)
+        {
+            // Note: cell is free, try to reserve it. 'pos' is updated with the current value on failure
+            if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell->time = currentTime();
+                return cell;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Note: cell still contains record of the previous round, so queue is full
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+            pos = m_pushPos.load(std::memory_order_relaxed);
+    }
+}
+
+void mbCoreLogBuffer::endPush(Cell *cell, quint32 pos)
+{
+    cell->seq.store(pos + 1, std::memory_order_release);
+}
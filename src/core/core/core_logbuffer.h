@@ -0,0 +1,137 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_LOGBUFFER_H
+#define CORE_LOGBUFFER_H
+
+#include <atomic>
+
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QElapsedTimer>
+
+#include <mbcore.h>
+
+// Log record that keeps raw data of the message (e.g. bytes of Tx/Rx frame).
+// Text of the record is formatted only when it is requested by the reader (view, file, export),
+// so writer (I/O thread) doesn't spend time for string conversion of the frame.
+// Record is compact: data is implicitly shared, so record is passed to view and file without copying the frame.
+struct MB_EXPORT mbCoreLogRecord
+{
+    enum Format
+    {
+        Format_Text , // 'message' contains ready text
+        Format_Bytes, // 'data' contains bytes of binary frame (RTU, TCP)
+        Format_Ascii  // 'data' contains bytes of ASCII frame
+    };
+
+    // Max size of stored frame (bytes). Max ASCII frame is 513 bytes, bigger frames are truncated
+    static const int MaxDataSize = 520;
+
+    qint64 time;     // timestamp, microseconds since epoch
+    mb::LogFlag flag;
+    quint16 source;  // id of the source name (see 'mbCoreLogBuffer::sourceId()')
+    quint8 format;   // 'Format' value
+    QString message; // text of 'Format_Text' record
+    QByteArray data; // bytes of the frame
+
+    // Returns text representation of the record (without timestamp, flag and source)
+    QString text() const;
+    // Returns text representation of the raw data of the frame
+    static QString toString(Format format, const quint8 *data, int size);
+    // Returns timestamp of the record in milliseconds since epoch
+    inline mb::Timestamp_t timestamp() const { return time / 1000; }
+};
+
+// Bounded lock-free queue of log records between many writers (any thread) and single reader (main thread).
+// All cells are preallocated with the room for the max frame, so writing a record doesn't allocate memory and never blocks.
+// Reader takes compact records (see 'mbCoreLogRecord') with the frame data of its actual size.
+// Every cell of the queue has sequence number that shows whether the cell is free for writer
+// or contains record for reader, so writers concurrently reserve cells by incrementing the write position only.
+// If queue is full new record is dropped and counted.
+class MB_EXPORT mbCoreLogBuffer
+{
+public:
+    static const int DefaultCapacity = 8192;
+
+public:
+    // Capacity is rounded up to the power of 2
+    explicit mbCoreLogBuffer(int capacity = DefaultCapacity);
+    ~mbCoreLogBuffer();
+
+public:
+    inline int capacity() const { return static_cast<int>(m_mask + 1); }
+    // Returns count of records that were dropped because queue was full and resets the counter
+    inline quint32 takeDroppedCount() { return m_dropped.exchange(0, std::memory_order_relaxed); }
+    // Returns current time (microseconds since epoch). Time is monotonic:
+    // it's calculated from the start time of the buffer and never goes back
+    qint64 currentTime() const;
+
+public:
+    // Returns id of the source name. Id is registered with the first call for the name
+    quint16 sourceId(const QString &source);
+    // Returns name of the source by its id
+    QString sourceName(quint16 id) const;
+
+public:
+    // Puts text message into buffer. Returns 'false' if buffer is full
+    bool push(mb::LogFlag flag, quint16 source, const QString &text);
+    // Puts raw data into buffer. Returns 'false' if buffer is full
+    bool push(mb::LogFlag flag, quint16 source, mbCoreLogRecord::Format format, const quint8 *data, int size);
+    // Takes up to 'maxCount' the oldest records and appends it to 'records'. Returns count of taken records.
+    // Must be called from single (reader) thread only
+    int pop(QVector<mbCoreLogRecord> &records, int maxCount);
+
+private:
+    struct Cell
+    {
+        std::atomic<quint32> seq;
+        qint64 time;
+        mb::LogFlag flag;
+        quint16 source;
+        quint8 format;
+        quint16 size;
+        QString message;
+        quint8 data[mbCoreLogRecord::MaxDataSize];
+    };
+
+private:
+    Cell *beginPush(quint32 &pos);
+    void endPush(Cell *cell, quint32 pos);
+
+private:
+    Q_DISABLE_COPY(mbCoreLogBuffer)
+    qint64 m_startTime;
+    QElapsedTimer m_timer;
+    Cell *m_cells;
+    quint32 m_mask;
+    std::atomic<quint32> m_pushPos;
+    quint32 m_popPos;
+    std::atomic<quint32> m_dropped;
+    mutable QReadWriteLock m_sourcesLock;
+    QHash<QString, quint16> m_sourceIds;
+    QStringList m_sources;
+};
+
+#endif // CORE_LOGBUFFER_H
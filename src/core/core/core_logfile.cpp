@@ -0,0 +1,398 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_logfile.h"
+
+#include <cstring>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRegularExpression>
+
+#ifdef MB_LOGFILE_GZIP
+#include <zlib.h>
+#endif
+
+// Size of the formatted data (bytes) that is collected before it's written into the file
+#define LOGFILE_WRITE_BUFFER_SIZE (1<<20)
+
+// Max count of records that are passed to the writer thread but not written yet
+#define LOGFILE_MAX_PENDING_COUNT (1<<16)
+
+// Size of the chunk (bytes) of the file that is compressed at a time
+#define LOGFILE_COMPRESS_CHUNK_SIZE (1<<16)
+
+// Compresses rotated files one by one in its own low priority thread.
+// File is streamed through zlib by chunks, so file of any size is compressed with constant memory.
+class mbCoreLogCompressor : public QThread
+{
+public:
+    mbCoreLogCompressor() : m_run(true) {}
+    ~mbCoreLogCompressor() { stop(); }
+
+public:
+    // Queues file to be compressed into '<fileName>.gz' and removed
+    void compress(const QString &fileName)
+    {
+        m_mutex.lock();
+        m_files.append(fileName);
+        m_run = true;
+        m_mutex.unlock();
+        m_cond.wakeAll();
+        if (!isRunning())
+            start(QThread::LowestPriority);
+    }
+
+    // Compresses all queued files and finishes the thread
+    void stop()
+    {
+        m_mutex.lock();
+        m_run = false;
+        m_mutex.unlock();
+        m_cond.wakeAll();
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        for (;;)
+        {
+            m_mutex.lock();
+            while (m_run && m_files.isEmpty())
+                m_cond.wait(&m_mutex);
+            if (m_files.isEmpty())
+            {
+                m_mutex.unlock();
+                break;
+            }
+            QString fileName = m_files.takeFirst();
+            m_mutex.unlock();
+            compressFile(fileName);
+        }
+    }
+
+private:
+    // Note: gzip file is written with temporary name, so incomplete file is never taken as rotated one
+    static bool compressFile(const QString &fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        QString gzName = fileName + QStringLiteral(".gz");
+        QFile gzFile(gzName + QStringLiteral(".tmp"));
+        if (!gzFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return false;
+        bool ok = gzip(file, gzFile);
+        file.close();
+        gzFile.close();
+        if (ok)
+            ok = gzFile.rename(gzName);
+        if (ok)
+            file.remove();
+        else
+            gzFile.remove();
+        return ok;
+    }
+
+    // Note: window bits 15+16 makes zlib write gzip header and trailer (CRC-32 and size) around deflate data
+    static bool gzip(QFile &in, QFile &out)
+    {
+#ifdef MB_LOGFILE_GZIP
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+        QByteArray inBuff(LOGFILE_COMPRESS_CHUNK_SIZE, Qt::Uninitialized);
+        QByteArray outBuff(LOGFILE_COMPRESS_CHUNK_SIZE, Qt::Uninitialized);
+        bool ok = true;
+        int r = Z_OK;
+        while (ok && (r != Z_STREAM_END))
+        {
+            qint64 c = in.read(inBuff.data(), inBuff.size());
+            if (c < 0)
+            {
+                ok = false;
+                break;
+            }
+            z.next_in = reinterpret_cast<Bytef*>(inBuff.data());
+            z.avail_in = static_cast<uInt>(c);
+            int flush = (c == 0) ? Z_FINISH : Z_NO_FLUSH;
+            do
+            {
+                z.next_out = reinterpret_cast<Bytef*>(outBuff.data());
+                z.avail_out = static_cast<uInt>(outBuff.size());
+                r = deflate(&z, flush);
+                if (r == Z_STREAM_ERROR)
+                {
+                    ok = false;
+                    break;
+                }
+                qint64 size = outBuff.size() - static_cast<qint64>(z.avail_out);
+                if (size && (out.write(outBuff.constData(), size) != size))
+                {
+                    ok = false;
+                    break;
+                }
+            }
+            while (z.avail_out == 0);
+        }
+        deflateEnd(&z);
+        return ok;
+#else
+        Q_UNUSED(in)
+        Q_UNUSED(out)
+        return false;
+#endif
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QStringList m_files;
+    bool m_run;
+};
+
+mbCoreLogFile::mbCoreLogFile(mbCoreLogBuffer *buffer, QObject *parent) : QThread(parent)
+{
+    m_buffer = buffer;
+    m_compressor = new mbCoreLogCompressor;
+    m_flags = mb::LogFlags();
+    m_settings.flags = mb::LogFlags();
+    m_settings.maxSize = 0;
+    m_settings.rotatePeriod = 0;
+    m_settings.maxCount = 0;
+    m_settings.compress = false;
+    m_settings.useTimestamp = true;
+    m_reopen = false;
+    m_run = true;
+    m_pendingCount = 0;
+    m_dropped = 0;
+    m_fileSize = 0;
+    m_openTime = 0;
+}
+
+mbCoreLogFile::~mbCoreLogFile()
+{
+    stop();
+    delete m_compressor;
+}
+
+bool mbCoreLogFile::isCompressSupported()
+{
+#ifdef MB_LOGFILE_GZIP
+    return true;
+#else
+    return false;
+#endif
+}
+
+mbCoreLogFile::Settings mbCoreLogFile::settings() const
+{
+    QMutexLocker _(&m_mutex);
+    return m_settings;
+}
+
+void mbCoreLogFile::setSettings(const Settings &settings)
+{
+    m_mutex.lock();
+    m_settings = settings;
+    m_flags = settings.flags;
+    m_reopen = true;
+    m_mutex.unlock();
+    m_cond.wakeAll();
+}
+
+void mbCoreLogFile::write(const QVector<mbCoreLogRecord> &records)
+{
+    m_mutex.lock();
+    if (m_pendingCount + records.count() > LOGFILE_MAX_PENDING_COUNT)
+        m_dropped += static_cast<quint32>(records.count());
+    else
+    {
+        m_pending.append(records);
+        m_pendingCount += records.count();
+    }
+    m_mutex.unlock();
+    m_cond.wakeAll();
+}
+
+void mbCoreLogFile::stop()
+{
+    m_mutex.lock();
+    m_run = false;
+    m_mutex.unlock();
+    m_cond.wakeAll();
+    wait();
+    m_compressor->stop();
+}
+
+void mbCoreLogFile::run()
+{
+    m_writeBuffer.reserve(LOGFILE_WRITE_BUFFER_SIZE + 4096);
+    for (;;)
+    {
+        QList<QVector<mbCoreLogRecord> > pending;
+        m_mutex.lock();
+        while (m_run && !m_reopen && m_pending.isEmpty())
+            m_cond.wait(&m_mutex);
+        pending.swap(m_pending);
+        m_pendingCount = 0;
+        bool reopen = m_reopen;
+        if (reopen)
+            m_current = m_settings;
+        m_reopen = false;
+        bool run = m_run;
+        quint32 dropped = m_dropped;
+        m_dropped = 0;
+        m_mutex.unlock();
+
+        if (reopen)
+        {
+            close();
+            open();
+        }
+        Q_FOREACH (const QVector<mbCoreLogRecord> &records, pending)
+        {
+            Q_FOREACH (const mbCoreLogRecord &r, records)
+            {
+                if (m_current.flags & r.flag)
+                {
+                    formatRecord(r);
+                    if (m_writeBuffer.size() >= LOGFILE_WRITE_BUFFER_SIZE)
+                        flush();
+                }
+            }
+        }
+        if (dropped)
+        {
+            mbCoreLogRecord r;
+            r.time = m_buffer->currentTime();
+            r.flag = mb::Log_Warning;
+            r.source = 0;
+            r.format = mbCoreLogRecord::Format_Text;
+            r.message = QString("%1 log message(s) were not written to file because file writer is overloaded").arg(dropped);
+            formatRecord(r);
+        }
+        flush();
+        if (!run)
+            break;
+    }
+    close();
+}
+
+bool mbCoreLogFile::open()
+{
+    if (m_current.filePath.isEmpty())
+        return false;
+    QFileInfo fi(m_current.filePath);
+    QDir().mkpath(fi.absolutePath());
+    m_file.setFileName(fi.absoluteFilePath());
+    // Note: file is unbuffered because data is already collected into large write buffer
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered))
+        return false;
+    m_fileSize = m_file.size();
+    m_openTime = QDateTime::currentMSecsSinceEpoch();
+    return true;
+}
+
+void mbCoreLogFile::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+void mbCoreLogFile::rotate()
+{
+    close();
+    QFileInfo fi(m_current.filePath);
+    QString name = fi.completeBaseName() + QStringLiteral(".") + QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss"));
+    QString suffix = fi.suffix().isEmpty() ? QString() : QStringLiteral(".") + fi.suffix();
+    QDir dir = fi.absoluteDir();
+    QString rotated = dir.absoluteFilePath(name + suffix);
+    // Note: file can be rotated more than once per second
+    for (int i = 1; QFile::exists(rotated) || QFile::exists(rotated + QStringLiteral(".gz")); i++)
+        rotated = dir.absoluteFilePath(QString("%1-%2%3").arg(name).arg(i).arg(suffix));
+    if (QFile::rename(fi.absoluteFilePath(), rotated) && m_current.compress && isCompressSupported())
+        m_compressor->compress(rotated);
+    removeOldFiles();
+    open();
+}
+
+void mbCoreLogFile::removeOldFiles()
+{
+    if (m_current.maxCount <= 0)
+        return;
+    QFileInfo fi(m_current.filePath);
+    QString suffix = fi.suffix().isEmpty() ? QString() : QStringLiteral("\\.") + QRegularExpression::escape(fi.suffix());
+    QRegularExpression re(QString("^%1\\.\\d{8}-\\d{6}(-\\d+)?%2(\\.gz)?$").arg(QRegularExpression::escape(fi.completeBaseName()), suffix));
+    QDir dir = fi.absoluteDir();
+    QStringList rotated;
+    // Note: rotated files are sorted by name which contains time of the rotation
+    Q_FOREACH (const QString &name, dir.entryList(QDir::Files, QDir::Name))
+    {
+        if (re.match(name).hasMatch())
+            rotated.append(name);
+    }
+    for (int i = 0; i < rotated.count() - m_current.maxCount; i++)
+        dir.remove(rotated.at(i));
+}
+
+void mbCoreLogFile::flush()
+{
+    if (m_writeBuffer.isEmpty())
+        return;
+    if (m_file.isOpen())
+    {
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (((m_current.maxSize > 0) && (m_fileSize > 0) && (m_fileSize + m_writeBuffer.size() > m_current.maxSize)) ||
+            ((m_current.rotatePeriod > 0) && (now - m_openTime >= static_cast<qint64>(m_current.rotatePeriod) * 1000)))
+            rotate();
+    }
+    if (m_file.isOpen())
+    {
+        qint64 c = m_file.write(m_writeBuffer);
+        if (c > 0)
+            m_fileSize += c;
+    }
+    m_writeBuffer.resize(0); // Note: reserved capacity is kept
+}
+
+void mbCoreLogFile::formatRecord(const mbCoreLogRecord &record)
+{
+    QString s;
+    if (m_current.useTimestamp)
+    {
+        s = QString("%1 '%2' %3: %4\n").arg(QDateTime::fromMSecsSinceEpoch(record.timestamp()).toString(m_current.formatDateTime),
+                                            m_buffer->sourceName(record.source),
+                                            mb::toString(record.flag),
+                                            record.text());
+    }
+    else
+    {
+        s = QString("'%1' %2: %3\n").arg(m_buffer->sourceName(record.source),
+                                         mb::toString(record.flag),
+                                         record.text());
+    }
+    m_writeBuffer.append(s.toUtf8());
+}
@@ -0,0 +1,108 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_LOGFILE_H
+#define CORE_LOGFILE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+
+#include "core_logbuffer.h"
+
+class mbCoreLogCompressor;
+
+// Log sink that writes log records into text file in dedicated writer thread.
+// Main thread only passes batches of records (implicitly shared, no copy) to the sink,
+// records are formatted and written by writer thread using large write buffer.
+// Current file is rotated when its size exceeds 'maxSize' or it's older than 'rotatePeriod':
+// file is renamed to '<name>.<yyyyMMdd-hhmmss>.<suffix>' (and gzipped if 'compress' is set)
+// and only 'maxCount' of the newest rotated files are kept.
+// Rotated files are gzipped by separate low priority thread, so writer thread isn't blocked by compression.
+class MB_EXPORT mbCoreLogFile : public QThread
+{
+public:
+    struct Settings
+    {
+        QString filePath;
+        mb::LogFlags flags;
+        qint64 maxSize;     // bytes, 0 - no size limit
+        int rotatePeriod;   // seconds, 0 - no time rotation
+        int maxCount;       // count of rotated files to keep, 0 - keep all
+        bool compress;
+        bool useTimestamp;
+        QString formatDateTime;
+    };
+
+public:
+    explicit mbCoreLogFile(mbCoreLogBuffer *buffer, QObject *parent = nullptr);
+    ~mbCoreLogFile();
+
+public:
+    Settings settings() const;
+    // Settings can be changed while writer thread is running, file is reopened with new settings
+    void setSettings(const Settings &settings);
+    inline mb::LogFlags flags() const { return m_flags; }
+    // Returns 'true' if library is built with zlib, so 'compress' setting is supported
+    static bool isCompressSupported();
+
+public:
+    // Passes batch of records to the writer thread. Records with flags that are not set for the sink are ignored.
+    // If writer falls behind and too many records are pending, new batch is dropped
+    void write(const QVector<mbCoreLogRecord> &records);
+    // Writes all pending records, closes file and finishes writer thread
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    bool open();
+    void close();
+    void rotate();
+    void removeOldFiles();
+    void flush();
+    void formatRecord(const mbCoreLogRecord &record);
+
+private:
+    mbCoreLogBuffer *m_buffer;
+    mbCoreLogCompressor *m_compressor;
+    mb::LogFlags m_flags;
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    Settings m_settings;
+    bool m_reopen;
+    bool m_run;
+    QList<QVector<mbCoreLogRecord> > m_pending;
+    int m_pendingCount;
+    quint32 m_dropped;
+
+private: // writer thread data
+    Settings m_current;
+    QFile m_file;
+    qint64 m_fileSize;
+    qint64 m_openTime;
+    QByteArray m_writeBuffer;
+};
+
+#endif // CORE_LOGFILE_H
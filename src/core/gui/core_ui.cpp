@@ -353,9 +353,9 @@ void mbCoreUi::setCachedSettings(const MBSETTINGS &settings)
     m_help->setCachedSettings(settings);
 }
 
-void mbCoreUi::logMessage(mb::LogFlag flag, const QString &source, const QString &text)
+void mbCoreUi::logRecords(const QVector<mbCoreLogRecord> &records)
 {
-    m_logView->logMessage(flag, source, text);
+    m_logView->logRecords(records);
 }
 
 void mbCoreUi::outputMessage(const QString &/*message*/)
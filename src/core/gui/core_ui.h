@@ -99,7 +99,7 @@ public: // settings
     virtual void setCachedSettings(const MBSETTINGS &settings);
 
 public Q_SLOTS:
-    void logMessage(mb::LogFlag flag, const QString &source, const QString &text);
+    void logRecords(const QVector<mbCoreLogRecord> &records);
     virtual void outputMessage(const QString& message);
 
 protected Q_SLOTS:
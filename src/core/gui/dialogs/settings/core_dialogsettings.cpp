@@ -128,6 +128,13 @@ void mbCoreDialogSettings::fillForm(const MBSETTINGS &m)
     m_log->setUseTimestamp  (m.value(sCore.settings_useTimestamp  ).toBool());
     m_log->setFormatDateTime(m.value(sCore.settings_formatDateTime).toString());
     m_log->setLogViewFont   (m.value(sLogView.font).toString());
+    m_log->setLogFileEnable  (m.value(sCore.settings_logFileEnable  ).toBool());
+    m_log->setLogFilePath    (m.value(sCore.settings_logFilePath    ).toString());
+    m_log->setLogFileFlags   (static_cast<mb::LogFlag>(m.value(sCore.settings_logFileFlags).toInt()));
+    m_log->setLogFileMaxSize (m.value(sCore.settings_logFileMaxSize ).toInt());
+    m_log->setLogFilePeriod  (m.value(sCore.settings_logFilePeriod  ).toInt());
+    m_log->setLogFileMaxCount(m.value(sCore.settings_logFileMaxCount).toInt());
+    m_log->setLogFileCompress(m.value(sCore.settings_logFileCompress).toBool());
 
     m_dataView->setColumns(m.value(sCore.settings_columns).toStringList());
 }
@@ -145,6 +152,13 @@ void mbCoreDialogSettings::fillData(MBSETTINGS &m)
     m[sCore.settings_useTimestamp   ] = m_log->useTimestamp();
     m[sCore.settings_formatDateTime ] = m_log->formatDateTime();
     m[sLogView.font                 ] = m_log->logViewFont();
+    m[sCore.settings_logFileEnable  ] = m_log->logFileEnable();
+    m[sCore.settings_logFilePath    ] = m_log->logFilePath();
+    m[sCore.settings_logFileFlags   ] = static_cast<int>(m_log->logFileFlags());
+    m[sCore.settings_logFileMaxSize ] = m_log->logFileMaxSize();
+    m[sCore.settings_logFilePeriod  ] = m_log->logFilePeriod();
+    m[sCore.settings_logFileMaxCount] = m_log->logFileMaxCount();
+    m[sCore.settings_logFileCompress] = m_log->logFileCompress();
 
     m[sCore.settings_columns        ] = m_dataView->getColumns();
 
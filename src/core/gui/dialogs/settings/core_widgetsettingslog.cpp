@@ -2,6 +2,7 @@
 #include "ui_core_widgetsettingslog.h"
 
 #include <core.h>
+#include <core_logfile.h>
 #include <gui/core_ui.h>
 #include <gui/dialogs/core_dialogs.h>
 #include <gui/logview/core_logview.h>
@@ -14,6 +15,12 @@ mbCoreWidgetSettingsLog::mbCoreWidgetSettingsLog(QWidget *parent) :
 
     setLogViewFont(mbCoreLogView::Defaults::instance().font);
     connect(ui->btnFont, &QPushButton::clicked, this, &mbCoreWidgetSettingsLog::slotFont);
+    connect(ui->btnFilePath, &QPushButton::clicked, this, &mbCoreWidgetSettingsLog::slotFilePath);
+    if (!mbCoreLogFile::isCompressSupported())
+    {
+        ui->chbFileCompress->setEnabled(false);
+        ui->chbFileCompress->setToolTip(QStringLiteral("Application is built without zlib"));
+    }
 
 }
 
@@ -77,6 +84,88 @@ void mbCoreWidgetSettingsLog::setLogViewFont(const QString &font)
     setLogViewFont(f);
 }
 
+bool mbCoreWidgetSettingsLog::logFileEnable() const
+{
+    return ui->chbFileEnable->isChecked();
+}
+
+void mbCoreWidgetSettingsLog::setLogFileEnable(bool enable)
+{
+    ui->chbFileEnable->setChecked(enable);
+}
+
+QString mbCoreWidgetSettingsLog::logFilePath() const
+{
+    return ui->lnFilePath->text();
+}
+
+void mbCoreWidgetSettingsLog::setLogFilePath(const QString &path)
+{
+    ui->lnFilePath->setText(path);
+}
+
+mb::LogFlags mbCoreWidgetSettingsLog::logFileFlags() const
+{
+    mb::LogFlags flags = mb::LogFlags();
+    flags = static_cast<mb::LogFlags>(flags | (ui->chbFileError  ->isChecked() * mb::Log_Error   ));
+    flags = static_cast<mb::LogFlags>(flags | (ui->chbFileWarning->isChecked() * mb::Log_Warning ));
+    flags = static_cast<mb::LogFlags>(flags | (ui->chbFileInfo   ->isChecked() * mb::Log_Info    ));
+    flags = static_cast<mb::LogFlags>(flags | (ui->chbFileTx     ->isChecked() * mb::Log_Tx      ));
+    flags = static_cast<mb::LogFlags>(flags | (ui->chbFileRx     ->isChecked() * mb::Log_Rx      ));
+    flags = static_cast<mb::LogFlags>(flags | (ui->chbFileDebug  ->isChecked() * mb::Log_Debug   ));
+    return flags;
+}
+
+void mbCoreWidgetSettingsLog::setLogFileFlags(mb::LogFlags flags)
+{
+    ui->chbFileError  ->setChecked(flags & mb::Log_Error  );
+    ui->chbFileWarning->setChecked(flags & mb::Log_Warning);
+    ui->chbFileInfo   ->setChecked(flags & mb::Log_Info   );
+    ui->chbFileTx     ->setChecked(flags & mb::Log_Tx     );
+    ui->chbFileRx     ->setChecked(flags & mb::Log_Rx     );
+    ui->chbFileDebug  ->setChecked(flags & mb::Log_Debug  );
+}
+
+int mbCoreWidgetSettingsLog::logFileMaxSize() const
+{
+    return ui->spFileMaxSize->value();
+}
+
+void mbCoreWidgetSettingsLog::setLogFileMaxSize(int megabytes)
+{
+    ui->spFileMaxSize->setValue(megabytes);
+}
+
+int mbCoreWidgetSettingsLog::logFilePeriod() const
+{
+    return ui->spFilePeriod->value();
+}
+
+void mbCoreWidgetSettingsLog::setLogFilePeriod(int hours)
+{
+    ui->spFilePeriod->setValue(hours);
+}
+
+int mbCoreWidgetSettingsLog::logFileMaxCount() const
+{
+    return ui->spFileMaxCount->value();
+}
+
+void mbCoreWidgetSettingsLog::setLogFileMaxCount(int count)
+{
+    ui->spFileMaxCount->setValue(count);
+}
+
+bool mbCoreWidgetSettingsLog::logFileCompress() const
+{
+    return ui->chbFileCompress->isChecked();
+}
+
+void mbCoreWidgetSettingsLog::setLogFileCompress(bool compress)
+{
+    ui->chbFileCompress->setChecked(compress);
+}
+
 QFont mbCoreWidgetSettingsLog::getLogViewFont() const
 {
     QFont f = ui->cmbFontFamily->currentFont();
@@ -99,3 +188,11 @@ void mbCoreWidgetSettingsLog::slotFont()
         setLogViewFont(f);
     }
 }
+
+void mbCoreWidgetSettingsLog::slotFilePath()
+{
+    mbCoreUi *ui = mbCore::globalCore()->coreUi();
+    QString fileName = ui->dialogsCore()->getSaveFileName(ui, QStringLiteral("Log File"), logFilePath(), QStringLiteral("Log files (*.log);;All files (*)"));
+    if (!fileName.isEmpty())
+        setLogFilePath(fileName);
+}
@@ -30,12 +30,34 @@ public: // properties
     QString logViewFont() const;
     void setLogViewFont(const QString &font);
 
+    bool logFileEnable() const;
+    void setLogFileEnable(bool enable);
+
+    QString logFilePath() const;
+    void setLogFilePath(const QString &path);
+
+    mb::LogFlags logFileFlags() const;
+    void setLogFileFlags(mb::LogFlags flags);
+
+    int logFileMaxSize() const;
+    void setLogFileMaxSize(int megabytes);
+
+    int logFilePeriod() const;
+    void setLogFilePeriod(int hours);
+
+    int logFileMaxCount() const;
+    void setLogFileMaxCount(int count);
+
+    bool logFileCompress() const;
+    void setLogFileCompress(bool compress);
+
 protected:
     QFont getLogViewFont() const;
     void setLogViewFont(const QFont &f);
 
 private Q_SLOTS:
     void slotFont();
+    void slotFilePath();
 
 private:
     Ui::mbCoreWidgetSettingsLog *ui;
@@ -25,19 +25,23 @@
 #include <QVBoxLayout>
 #include <QHeaderView>
 #include <QTableView>
-#include <QPlainTextEdit>
+#include <QScrollBar>
 #include <QToolBar>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QTimer>
 #include <QCoreApplication>
 
 #include <core.h>
 #include <gui/core_ui.h>
 #include <gui/dialogs/core_dialogs.h>
 
-//#include "core_logviewmodel.h"
+#include "core_logviewmodel.h"
 
 mbCoreLogView::Strings::Strings() :
     prefix(QStringLiteral("Ui.LogView.")),
-    font(prefix+QStringLiteral("font"))
+    font(prefix+QStringLiteral("font")),
+    capacity(prefix+QStringLiteral("capacity"))
 {
 }
 
@@ -48,7 +52,8 @@ const mbCoreLogView::Strings &mbCoreLogView::Strings::instance()
 }
 
 mbCoreLogView::Defaults::Defaults() :
-    font(QFont("Courier New", 8).toString())
+    font(QFont("Courier New", 8).toString()),
+    capacity(100000)
 {
 }
 
@@ -66,22 +71,20 @@ mbCoreLogView::mbCoreLogView(QWidget *parent)
     m_toolBar->setIconSize(QSize(16,16));
     m_toolBar->setContentsMargins(0,0,0,0);
 
-    //m_view = new QTableView(this);
-    //m_model = new mbCoreLogViewModel(m_view);
-    //m_view->setModel(m_model);
-    //QHeaderView *header;
-    //header = m_view->horizontalHeader();
-    //header->setStretchLastSection(true);
-    //header->hide();
-    //header = m_view->verticalHeader();
-    //header->setSectionResizeMode(QHeaderView::ResizeToContents);
-    //header->hide();
-
-    m_maxSize = 1<<20;
-    m_offset = 0;
-
-    m_view = new QPlainTextEdit(this);
-    m_view->setReadOnly(true);
+    m_view = new QTableView(this);
+    m_model = new mbCoreLogViewModel(Defaults::instance().capacity, m_view);
+    m_view->setModel(m_model);
+    m_view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_view->setShowGrid(false);
+    m_view->setWordWrap(false);
+    QHeaderView *header;
+    header = m_view->horizontalHeader();
+    header->setStretchLastSection(true);
+    header->hide();
+    header = m_view->verticalHeader();
+    // Note: fixed row height, so view doesn't measure every inserted row
+    header->setSectionResizeMode(QHeaderView::Fixed);
+    header->hide();
     setFontString(Defaults::instance().font);
 
     QAction *actionClear = new QAction(m_toolBar);
@@ -96,6 +99,40 @@ mbCoreLogView::mbCoreLogView(QWidget *parent)
     connect(actionExportLog, &QAction::triggered, this, &mbCoreLogView::exportLog);
     m_toolBar->addAction(actionExportLog);
 
+    m_toolBar->addSeparator();
+
+    m_cmbSource = new QComboBox(m_toolBar);
+    m_cmbSource->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_cmbSource->addItem(QCoreApplication::translate("mbCoreLogView", "All sources", nullptr));
+    connect(m_cmbSource, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &mbCoreLogView::slotFilter);
+    m_toolBar->addWidget(m_cmbSource);
+
+    m_cmbCategory = new QComboBox(m_toolBar);
+    m_cmbCategory->addItem(QCoreApplication::translate("mbCoreLogView", "All categories", nullptr), 0);
+    m_cmbCategory->addItem(mb::toString(mb::Log_Error  ), static_cast<int>(mb::Log_Error  ));
+    m_cmbCategory->addItem(mb::toString(mb::Log_Warning), static_cast<int>(mb::Log_Warning));
+    m_cmbCategory->addItem(mb::toString(mb::Log_Info   ), static_cast<int>(mb::Log_Info   ));
+    m_cmbCategory->addItem(mb::toString(mb::Log_Tx     ), static_cast<int>(mb::Log_Tx     ));
+    m_cmbCategory->addItem(mb::toString(mb::Log_Rx     ), static_cast<int>(mb::Log_Rx     ));
+    m_cmbCategory->addItem(mb::toString(mb::Log_Debug  ), static_cast<int>(mb::Log_Debug  ));
+    connect(m_cmbCategory, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &mbCoreLogView::slotFilter);
+    m_toolBar->addWidget(m_cmbCategory);
+
+    m_lnFilter = new QLineEdit(m_toolBar);
+    m_lnFilter->setPlaceholderText(QCoreApplication::translate("mbCoreLogView", "Filter text", nullptr));
+    m_lnFilter->setClearButtonEnabled(true);
+    m_lnFilter->setMaximumWidth(250);
+    m_toolBar->addWidget(m_lnFilter);
+
+    // Note: text search is started when user stops typing, so every key press doesn't restart search
+    m_filterTimer = new QTimer(this);
+    m_filterTimer->setSingleShot(true);
+    m_filterTimer->setInterval(300);
+    connect(m_filterTimer, &QTimer::timeout, this, &mbCoreLogView::slotFilter);
+    connect(m_lnFilter, &QLineEdit::textChanged, m_filterTimer, QOverload<>::of(&QTimer::start));
+    connect(m_lnFilter, &QLineEdit::returnPressed, this, &mbCoreLogView::slotFilter);
+    connect(m_model, &mbCoreLogViewModel::sourcesChanged, this, &mbCoreLogView::slotSourcesChanged);
+
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->setSpacing(0);
     layout->setContentsMargins(0,0,0,0);
@@ -113,14 +150,28 @@ void mbCoreLogView::setFontString(const QString &font)
 {
     QFont f = m_view->font();
     if (f.fromString(font))
+    {
         m_view->setFont(f);
+        m_view->verticalHeader()->setDefaultSectionSize(QFontMetrics(f).height() + 2);
+    }
+}
+
+int mbCoreLogView::capacity() const
+{
+    return m_model->capacity();
+}
+
+void mbCoreLogView::setCapacity(int capacity)
+{
+    m_model->setCapacity(capacity);
 }
 
 MBSETTINGS mbCoreLogView::cachedSettings() const
 {
     const Strings &s = Strings::instance();
     MBSETTINGS r;
-    r[s.font] = this->fontString();
+    r[s.font    ] = this->fontString();
+    r[s.capacity] = this->capacity();
     return r;
 }
 
@@ -130,7 +181,7 @@ void mbCoreLogView::setCachedSettings(const MBSETTINGS &settings)
 
     MBSETTINGS::const_iterator it;
     MBSETTINGS::const_iterator end = settings.end();
-    //bool ok;
+    bool ok;
 
     it = settings.find(s.font);
     if (it != end)
@@ -138,13 +189,19 @@ void mbCoreLogView::setCachedSettings(const MBSETTINGS &settings)
         this->setFontString(it.value().toString());
     }
 
+    it = settings.find(s.capacity);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok && (v > 0))
+            this->setCapacity(v);
+    }
+
 }
 
 void mbCoreLogView::clear()
 {
-    //m_model->clear();
-    m_view->clear();
-    m_offset = 0;
+    m_model->clear();
 }
 
 void mbCoreLogView::exportLog()
@@ -156,45 +213,65 @@ void mbCoreLogView::exportLog()
     QFile file(fileName);
     if (!file.open(QFile::WriteOnly))
         return;
-    file.write(m_view->toPlainText().toUtf8());
+    QString format = m_core->formatDateTime();
+    for (int i = 0; i < m_model->rowCount(); i++)
+    {
+        const mbCoreLogViewModel::Message &m = m_model->message(i);
+        QString s = QString("%1 '%2' %3: %4\n").arg(QDateTime::fromMSecsSinceEpoch(m.timestamp).toString(format),
+                                                   m_model->sourceName(m),
+                                                   mb::toString(m.category),
+                                                   m.text());
+        file.write(s.toUtf8());
+    }
     file.close();
 }
 
-void mbCoreLogView::logMessage(mb::LogFlag flag, const QString &source, const QString &text)
+void mbCoreLogView::slotFilter()
 {
-    //m_model->logMessage(flag, source, text);
-    QString s;
-    if (m_core->useTimestamp())
-    {
-        s = QString("%1 '%2' %3: %4").arg(QDateTime::currentDateTime().toString(m_core->formatDateTime()),
-                                          source,
-                                          mb::toString(flag),
-                                          text);
-    }
-    else
-    {
-        s = QString("'%1' %2: %3").arg(source,
-                                       mb::toString(flag),
-                                       text);
-    }
-    int sz = m_view->document()->characterCount();
-    int linesz = s.size();
-    if ((sz + linesz) > m_maxSize)
+    m_filterTimer->stop();
+    mbCoreLogViewModel::Filter filter;
+    QVariant v = m_cmbSource->currentData();
+    if (v.isValid())
+        filter.sources.append(static_cast<quint16>(v.toUInt()));
+    filter.categories = static_cast<mb::LogFlags>(m_cmbCategory->currentData().toInt());
+    filter.text = m_lnFilter->text();
+    const mbCoreLogViewModel::Filter &current = m_model->filter();
+    if ((filter.sources == current.sources) && (filter.categories == current.categories) && (filter.text == current.text))
+        return;
+    m_model->setFilter(filter);
+}
+
+void mbCoreLogView::slotSourcesChanged()
+{
+    QVariant current = m_cmbSource->currentData();
+    QMap<QString, quint16> names;
+    Q_FOREACH (quint16 id, m_model->sources())
+        names.insert(m_core->logBuffer()->sourceName(id), id);
+    // Note: selected source is kept even if it has no messages anymore
+    if (current.isValid())
     {
-        if (m_offset)
-        {
-            QTextCursor cursor = m_view->textCursor();
-            cursor.setPosition(0); // start of document
-            cursor.setPosition(m_offset, QTextCursor::KeepAnchor); // select until offset
-            cursor.removeSelectedText(); // remove the selection
-            m_offset = sz-m_offset;
-        }
-        else
-            m_view->clear();
+        quint16 id = static_cast<quint16>(current.toUInt());
+        names.insert(m_core->logBuffer()->sourceName(id), id);
     }
-    else if ((sz >= m_maxSize/2) && (m_offset == 0))
+    m_cmbSource->blockSignals(true);
+    m_cmbSource->clear();
+    m_cmbSource->addItem(QCoreApplication::translate("mbCoreLogView", "All sources", nullptr));
+    for (QMap<QString, quint16>::const_iterator it = names.constBegin(); it != names.constEnd(); ++it)
     {
-        m_offset = sz; // remember the point for the future deletion
+        m_cmbSource->addItem(it.key(), it.value());
+        if (current.isValid() && (current.toUInt() == it.value()))
+            m_cmbSource->setCurrentIndex(m_cmbSource->count()-1);
     }
-    m_view->appendPlainText(s);
+    m_cmbSource->blockSignals(false);
+}
+
+void mbCoreLogView::logRecords(const QVector<mbCoreLogRecord> &records)
+{
+    // Note: view follows new records only if it was scrolled to the end
+    QScrollBar *scrollBar = m_view->verticalScrollBar();
+    bool atEnd = scrollBar->value() == scrollBar->maximum();
+    m_view->setColumnHidden(mbCoreLogViewModel::Column_DateTime, !m_core->useTimestamp());
+    m_model->logRecords(records);
+    if (atEnd)
+        m_view->scrollToBottom();
 }
@@ -27,10 +27,13 @@
 #include <mbcore.h>
 
 class QTableView;
-class QPlainTextEdit;
 class QToolBar;
+class QComboBox;
+class QLineEdit;
+class QTimer;
 class mbCore;
-//class mbCoreLogViewModel;
+class mbCoreLogViewModel;
+struct mbCoreLogRecord;
 
 class mbCoreLogView : public QWidget
 {
@@ -41,6 +44,7 @@ public:
     {
         const QString prefix;
         const QString font;
+        const QString capacity;
         Strings();
         static const Strings &instance();
     };
@@ -48,6 +52,7 @@ public:
     struct MB_EXPORT Defaults
     {
         const QString font;
+        const int capacity;
         Defaults();
         static const Defaults &instance();
     };
@@ -58,12 +63,15 @@ public:
 public:
     QString fontString() const;
     void setFontString(const QString &font);
+    // Max count of messages that are kept by the log view
+    int capacity() const;
+    void setCapacity(int capacity);
 
     MBSETTINGS cachedSettings() const;
     void setCachedSettings(const MBSETTINGS &settings);
 
 public:
-    void logMessage(mb::LogFlag flag, const QString &source, const QString &text);
+    void logRecords(const QVector<mbCoreLogRecord> &records);
 
 public Q_SLOTS:
     void clear();
@@ -71,14 +79,19 @@ public Q_SLOTS:
 
 Q_SIGNALS:
 
+private Q_SLOTS:
+    void slotFilter();
+    void slotSourcesChanged();
+
 protected:
     mbCore *m_core;
     QToolBar *m_toolBar;
-    QPlainTextEdit *m_view;
-    int m_maxSize;
-    int m_offset;
-    //QTableView *m_view;
-    //mbCoreLogViewModel *m_model;
+    QTableView *m_view;
+    mbCoreLogViewModel *m_model;
+    QComboBox *m_cmbSource;
+    QComboBox *m_cmbCategory;
+    QLineEdit *m_lnFilter;
+    QTimer *m_filterTimer;
 };
 
 #endif // MBCOREOUTPUT_H
@@ -1,18 +1,48 @@
 #include "core_logviewmodel.h"
 
+#include <algorithm>
+
 #include <QColor>
 #include <QDateTime>
 
-mbCoreLogViewModel::mbCoreLogViewModel(QObject *parent) :
+#include <core.h>
+
+#include "core_logviewsearch.h"
+
+// Posting list is compacted when count of removed numbers at its begin exceeds this value and half of the list
+#define POSTINGLIST_COMPACT_SIZE 4096
+
+QString mbCoreLogViewModel::Message::text() const
+{
+    if (format == mbCoreLogRecord::Format_Text)
+        return QString::fromUtf8(data);
+    return mbCoreLogRecord::toString(static_cast<mbCoreLogRecord::Format>(format), reinterpret_cast<const quint8*>(data.constData()), data.size());
+}
+
+QByteArray mbCoreLogViewModel::Message::lowerText() const
+{
+    return text().toLower().toUtf8();
+}
+
+mbCoreLogViewModel::mbCoreLogViewModel(int capacity, QObject *parent) :
     QAbstractTableModel(parent)
 {
-    m_ptr = 0;
+    m_head = 0;
     m_count = 0;
-    m_buff.resize(1000);
+    m_firstSeq = 0;
+    m_filter.categories = mb::LogFlags();
+    m_filtered = false;
+    m_searching = false;
+    m_rowsBegin = 0;
+    m_buff.resize(qMax(capacity, 1));
+    m_search = new mbCoreLogViewSearch(this);
+    connect(m_search, &QThread::finished, this, &mbCoreLogViewModel::slotSearchFinished);
 }
 
 mbCoreLogViewModel::~mbCoreLogViewModel()
 {
+    m_search->cancel();
+    m_search->wait();
 }
 
 QVariant mbCoreLogViewModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -37,6 +67,8 @@ QVariant mbCoreLogViewModel::headerData(int section, Qt::Orientation orientation
 
 int mbCoreLogViewModel::rowCount(const QModelIndex &/*index*/) const
 {
+    if (m_filtered)
+        return m_rows.count() - m_rowsBegin;
     return m_count;
 }
 
@@ -49,18 +81,18 @@ QVariant mbCoreLogViewModel::data(const QModelIndex &index, int role) const
 {
     int c = index.column();
     int r = index.row();
-    if (r < m_count)
+    if (r < rowCount())
     {
-        int i = getActualIndex(r);
+        int i = rowIndex(r);
         switch (role)
         {
         case Qt::DisplayRole:
             switch(c)
             {
-            case Column_DateTime: return m_buff.at(i).datetime.toString("hh:mm:ss.zzz");
-            case Column_Source  : return m_buff.at(i).source;
+            case Column_DateTime: return QDateTime::fromMSecsSinceEpoch(m_buff.at(i).timestamp).toString(mbCore::globalCore()->formatDateTime());
+            case Column_Source  : return sourceName(m_buff.at(i));
             case Column_Category: return mb::toString(m_buff.at(i).category);
-            case Column_Text    : return m_buff.at(i).text;
+            case Column_Text    : return m_buff.at(i).text();
             }
             break;
         case Qt::BackgroundRole:
@@ -90,38 +122,292 @@ QVariant mbCoreLogViewModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
-void mbCoreLogViewModel::logMessage(mb::LogFlag flag, const QString &source, const QString &text)
+void mbCoreLogViewModel::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 1);
+    if (capacity == m_buff.size())
+        return;
+    beginResetModel();
+    int c = qMin(m_count, capacity);
+    MessageBuffer buff(capacity);
+    for (int i = 0; i < c; i++)
+        buff[i] = m_buff.at(getActualIndex(m_count - c + i));
+    m_buff = buff;
+    m_head = 0;
+    m_firstSeq += m_count - c;
+    m_count = c;
+    rebuildIndex();
+    applyFilter();
+    endResetModel();
+}
+
+QString mbCoreLogViewModel::sourceName(const Message &message) const
+{
+    return mbCore::globalCore()->logBuffer()->sourceName(message.source);
+}
+
+QList<quint16> mbCoreLogViewModel::sources() const
+{
+    QList<quint16> r;
+    for (SourceIndex::const_iterator it = m_sourceIndex.constBegin(); it != m_sourceIndex.constEnd(); ++it)
+    {
+        if (it.value().seqs.count() > it.value().begin)
+            r.append(it.key());
+    }
+    return r;
+}
+
+void mbCoreLogViewModel::logRecords(const QVector<mbCoreLogRecord> &records)
 {
     int sz = m_buff.size();
-    Message message;
-    message.datetime = QDateTime::currentDateTime();
-    message.category = flag;
-    message.source = source;
-    message.text = text;
-    if (m_count < sz)
+    // Note: if batch is bigger than buffer only the last records of the batch are kept
+    int first = qMax(0, records.count() - sz);
+    int c = records.count() - first;
+    if (c == 0)
+        return;
+    int removed = m_count + c - sz;
+    if (removed > 0)
     {
-        beginInsertRows(QModelIndex(), m_count, m_count);
-        m_buff[m_ptr] = message;
+        // Note: removed rows are notified before the model is changed, so views still see the old state
+        qint64 firstSeq = m_firstSeq + removed;
+        int k = m_rowsBegin;
+        if (m_filtered)
+        {
+            // Note: displayed rows of the removed messages are at the begin of the rows
+            while ((k < m_rows.count()) && (m_rows.at(k) < firstSeq))
+                k++;
+            if (k > m_rowsBegin)
+                beginRemoveRows(QModelIndex(), 0, k - m_rowsBegin - 1);
+        }
+        else
+            beginRemoveRows(QModelIndex(), 0, removed - 1);
+        for (int i = 0; i < removed; i++)
+            unindexMessage(m_buff.at(getActualIndex(i)));
+        m_head = (m_head + removed) % sz;
+        m_count -= removed;
+        m_firstSeq = firstSeq;
+        if (m_filtered)
+        {
+            if (k > m_rowsBegin)
+            {
+                m_rowsBegin = k;
+                if ((m_rowsBegin > POSTINGLIST_COMPACT_SIZE) && (m_rowsBegin > m_rows.count() / 2))
+                {
+                    m_rows.remove(0, m_rowsBegin);
+                    m_rowsBegin = 0;
+                }
+                endRemoveRows();
+            }
+            k = 0;
+            while ((k < m_tail.count()) && (m_tail.at(k) < m_firstSeq))
+                k++;
+            m_tail.remove(0, k);
+        }
+        else
+            endRemoveRows();
+    }
+    QVector<qint64> matched;
+    if (!m_filtered)
+        beginInsertRows(QModelIndex(), m_count, m_count + c - 1);
+    for (int i = first; i < records.count(); i++)
+    {
+        const mbCoreLogRecord &r = records.at(i);
+        Message &message = m_buff[getActualIndex(m_count)];
+        message.timestamp = r.timestamp();
+        message.category = r.flag;
+        message.source = r.source;
+        message.format = r.format;
+        if (r.format == mbCoreLogRecord::Format_Text)
+            message.data = r.message.toUtf8();
+        else
+            message.data = r.data; // Note: data is shared with the record, no copy
+        qint64 seq = m_firstSeq + m_count;
+        indexMessage(message, seq);
+        // Note: new messages are checked by the filter here, so filtered view stays live
+        if (m_filtered && matchIndex(message) && matchText(message))
+            matched.append(seq);
         m_count++;
-        endInsertRows();
     }
-    else
+    if (!m_filtered)
+        endInsertRows();
+    else if (matched.count())
     {
-        beginResetModel();
-        m_buff[m_ptr] = message;
-        endResetModel();
-        //beginRemoveRows(QModelIndex(), 0, 0);
-        //endRemoveRows();
-        //beginInsertRows(QModelIndex(), m_count-1, m_count-1);
-        //endInsertRows();
+        if (m_searching)
+            m_tail += matched;
+        else
+        {
+            int rows = rowCount();
+            beginInsertRows(QModelIndex(), rows, rows + matched.count() - 1);
+            m_rows += matched;
+            endInsertRows();
+        }
     }
-    m_ptr = (m_ptr + 1) % sz;
 }
 
 void mbCoreLogViewModel::clear()
 {
     beginResetModel();
+    for (int i = 0; i < m_count; i++)
+    {
+        // Note: release memory of the messages
+        Message &message = m_buff[getActualIndex(i)];
+        message.data = QByteArray();
+    }
+    m_firstSeq += m_count;
+    m_head = 0;
     m_count = 0;
+    rebuildIndex();
+    applyFilter();
     endResetModel();
 }
 
+void mbCoreLogViewModel::setFilter(const Filter &filter)
+{
+    beginResetModel();
+    m_filter = filter;
+    applyFilter();
+    endResetModel();
+}
+
+void mbCoreLogViewModel::slotSearchFinished()
+{
+    // Note: finish of the cancelled search can be received when the next search is already started
+    if (!m_searching || m_search->isRunning())
+        return;
+    beginResetModel();
+    m_rows = m_search->takeResult();
+    m_rowsBegin = static_cast<int>(std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), m_firstSeq) - m_rows.constBegin());
+    m_rows += m_tail;
+    m_tail.clear();
+    m_searching = false;
+    endResetModel();
+    Q_EMIT searchFinished();
+}
+
+void mbCoreLogViewModel::indexMessage(const Message &message, qint64 seq)
+{
+    SourceIndex::iterator it = m_sourceIndex.find(message.source);
+    if (it == m_sourceIndex.end())
+    {
+        m_sourceIndex[message.source].seqs.append(seq);
+        Q_EMIT sourcesChanged();
+    }
+    else
+        it.value().seqs.append(seq);
+    m_categoryIndex[message.category].seqs.append(seq);
+}
+
+void mbCoreLogViewModel::unindexMessage(const Message &message)
+{
+    // Note: removed message is the oldest one, so its number is the first in the posting lists
+    PostingList *lists[2] = { &m_sourceIndex[message.source], &m_categoryIndex[message.category] };
+    for (PostingList *list : lists)
+    {
+        list->begin++;
+        if ((list->begin > POSTINGLIST_COMPACT_SIZE) && (list->begin > list->seqs.count() / 2))
+        {
+            list->seqs.remove(0, list->begin);
+            list->begin = 0;
+        }
+    }
+}
+
+void mbCoreLogViewModel::rebuildIndex()
+{
+    m_sourceIndex.clear();
+    m_categoryIndex.clear();
+    for (int i = 0; i < m_count; i++)
+        indexMessage(m_buff.at(getActualIndex(i)), m_firstSeq + i);
+    Q_EMIT sourcesChanged();
+}
+
+bool mbCoreLogViewModel::matchIndex(const Message &message) const
+{
+    if (m_filter.categories && !(m_filter.categories & message.category))
+        return false;
+    return m_filter.sources.isEmpty() || m_filter.sources.contains(message.source);
+}
+
+bool mbCoreLogViewModel::matchText(const Message &message) const
+{
+    if (m_filter.text.isEmpty())
+        return true;
+    return message.lowerText().contains(m_filterText);
+}
+
+QVector<qint64> mbCoreLogViewModel::candidates() const
+{
+    // Note: posting lists are sorted, so union and intersection are made by single pass merge
+    QVector<qint64> bySource;
+    Q_FOREACH (quint16 source, m_filter.sources)
+    {
+        SourceIndex::const_iterator it = m_sourceIndex.find(source);
+        if (it == m_sourceIndex.end())
+            continue;
+        const PostingList &list = it.value();
+        QVector<qint64> r(bySource.count() + list.seqs.count() - list.begin);
+        QVector<qint64>::iterator end = std::set_union(bySource.constBegin(), bySource.constEnd(), list.seqs.constBegin() + list.begin, list.seqs.constEnd(), r.begin());
+        r.resize(static_cast<int>(end - r.begin()));
+        bySource = r;
+    }
+    QVector<qint64> byCategory;
+    if (m_filter.categories)
+    {
+        for (CategoryIndex::const_iterator it = m_categoryIndex.constBegin(); it != m_categoryIndex.constEnd(); ++it)
+        {
+            if (!(m_filter.categories & it.key()))
+                continue;
+            const PostingList &list = it.value();
+            QVector<qint64> r(byCategory.count() + list.seqs.count() - list.begin);
+            QVector<qint64>::iterator end = std::set_union(byCategory.constBegin(), byCategory.constEnd(), list.seqs.constBegin() + list.begin, list.seqs.constEnd(), r.begin());
+            r.resize(static_cast<int>(end - r.begin()));
+            byCategory = r;
+        }
+    }
+    if (m_filter.sources.isEmpty())
+    {
+        if (m_filter.categories)
+            return byCategory;
+        QVector<qint64> r(m_count);
+        for (int i = 0; i < m_count; i++)
+            r[i] = m_firstSeq + i;
+        return r;
+    }
+    if (!m_filter.categories)
+        return bySource;
+    QVector<qint64> r(qMin(bySource.count(), byCategory.count()));
+    QVector<qint64>::iterator end = std::set_intersection(bySource.constBegin(), bySource.constEnd(), byCategory.constBegin(), byCategory.constEnd(), r.begin());
+    r.resize(static_cast<int>(end - r.begin()));
+    return r;
+}
+
+void mbCoreLogViewModel::applyFilter()
+{
+    if (m_searching)
+    {
+        m_search->cancel();
+        m_search->wait();
+        m_searching = false;
+    }
+    m_filtered = !(m_filter.sources.isEmpty() && !m_filter.categories && m_filter.text.isEmpty());
+    m_filterText = m_filter.text.toLower().toUtf8();
+    m_rows.clear();
+    m_rowsBegin = 0;
+    m_tail.clear();
+    if (!m_filtered)
+        return;
+    QVector<qint64> seqs = candidates();
+    if (m_filter.text.isEmpty())
+    {
+        m_rows = seqs;
+        return;
+    }
+    // Note: search thread gets its own copy of the messages (data is implicitly shared),
+    //       so buffer can be changed while search is in progress
+    QVector<Message> messages;
+    messages.reserve(seqs.count());
+    Q_FOREACH (qint64 seq, seqs)
+        messages.append(m_buff.at(seqIndex(seq)));
+    m_searching = true;
+    m_search->search(seqs, messages, m_filter.text);
+}
@@ -1,11 +1,14 @@
 #ifndef XCHG_MESSAGEBUFFERMODEL_H
 #define XCHG_MESSAGEBUFFERMODEL_H
 
-#include <QDateTime>
 #include <QAbstractTableModel>
+#include <QHash>
 
 #include <mbcore.h>
 
+struct mbCoreLogRecord;
+class mbCoreLogViewSearch;
+
 class mbCoreLogViewModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -20,16 +23,31 @@ public:
         ColumnCount
     };
 
+    // Compact message record: source name is interned and text is formatted only when it's displayed
+    // or searched, so the model can keep millions of messages
     struct Message
     {
-        QDateTime datetime;
+        mb::Timestamp_t timestamp; // milliseconds since epoch
         mb::LogFlag category;
-        QString source;
-        QString text;
+        quint16 source;            // id of the source name (see 'mbCoreLogBuffer::sourceName()')
+        quint8 format;             // 'mbCoreLogRecord::Format' value
+        QByteArray data;           // raw bytes of the frame or UTF-8 text of the message
+
+        QString text() const;
+        // Returns lower case UTF-8 text of the message that is used for case insensitive search
+        QByteArray lowerText() const;
+    };
+
+    // Filter of the displayed messages. Message is displayed if it matches all set conditions
+    struct Filter
+    {
+        QList<quint16> sources;  // ids of the sources to display, empty - all sources
+        mb::LogFlags categories; // categories to display, empty - all categories
+        QString text;            // substring (case insensitive) of the message text, empty - any text
     };
 
 public:
-    explicit mbCoreLogViewModel(QObject *parent = 0);
+    explicit mbCoreLogViewModel(int capacity, QObject *parent = 0);
     ~mbCoreLogViewModel();
 
 public:
@@ -39,17 +57,75 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
 public:
-    void logMessage(mb::LogFlag flag, const QString &source, const QString &text);
+    inline int capacity() const { return m_buff.size(); }
+    // Sets max count of messages, the newest messages are kept
+    void setCapacity(int capacity);
+    inline const Message &message(int row) const { return m_buff.at(rowIndex(row)); }
+    QString sourceName(const Message &message) const;
+    // Returns ids of the sources that have messages in the model
+    QList<quint16> sources() const;
+    // Appends all records of the batch. When model is full the oldest messages are removed
+    // with single remove notification before new messages are inserted with single insert notification
+    void logRecords(const QVector<mbCoreLogRecord> &records);
     void clear();
 
+public: // filter
+    inline const Filter &filter() const { return m_filter; }
+    // Rows are selected using indexes of sources and categories immediately,
+    // text search is made in separate thread and rows are updated when search is finished
+    void setFilter(const Filter &filter);
+    inline bool isFiltered() const { return m_filtered; }
+    inline bool isSearching() const { return m_searching; }
+    // Count of all messages (including not matched the filter)
+    inline int messageCount() const { return m_count; }
+
+Q_SIGNALS:
+    void sourcesChanged();
+    void searchFinished();
+
+private Q_SLOTS:
+    void slotSearchFinished();
+
+private:
+    // Sorted sequence numbers of messages with the same source or category.
+    // The oldest numbers are removed by moving 'begin', memory is compacted from time to time
+    struct PostingList
+    {
+        PostingList() : begin(0) {}
+        QVector<qint64> seqs;
+        int begin;
+    };
+    typedef QHash<quint16, PostingList> SourceIndex;
+    typedef QHash<int, PostingList> CategoryIndex;
+
 private:
-    inline int getActualIndex(int row) const { return (m_ptr + m_buff.size() - m_count + row) % m_buff.size(); }
+    inline int getActualIndex(int i) const { return (m_head + i) % m_buff.size(); }
+    inline int seqIndex(qint64 seq) const { return getActualIndex(static_cast<int>(seq - m_firstSeq)); }
+    inline int rowIndex(int row) const { return m_filtered ? seqIndex(m_rows.at(m_rowsBegin + row)) : getActualIndex(row); }
+    void indexMessage(const Message &message, qint64 seq);
+    void unindexMessage(const Message &message);
+    void rebuildIndex();
+    bool matchIndex(const Message &message) const;
+    bool matchText(const Message &message) const;
+    QVector<qint64> candidates() const;
+    void applyFilter();
 
 private:
     typedef QVector<Message> MessageBuffer;
     MessageBuffer m_buff;
-    int m_ptr;
+    int m_head; // index of the oldest message
     int m_count;
+    qint64 m_firstSeq; // sequence number of the oldest message
+    SourceIndex m_sourceIndex;
+    CategoryIndex m_categoryIndex;
+    Filter m_filter;
+    QByteArray m_filterText; // lower case UTF-8 text of the filter
+    bool m_filtered;
+    bool m_searching;
+    QVector<qint64> m_rows; // sequence numbers of the displayed messages when filter is set
+    int m_rowsBegin;
+    QVector<qint64> m_tail; // matched messages that were added while text search is in progress
+    mbCoreLogViewSearch *m_search;
 };
 
 #endif // XCHG_MESSAGEBUFFERMODEL_H
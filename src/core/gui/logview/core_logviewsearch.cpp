@@ -0,0 +1,117 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_logviewsearch.h"
+
+#include <QRunnable>
+
+// Min count of messages that are searched by single thread of the pool
+#define LOGVIEWSEARCH_MIN_PART_SIZE 4096
+
+class mbCoreLogViewSearch::Part : public QRunnable
+{
+public:
+    Part(mbCoreLogViewSearch *search, const QByteArray &text, int begin, int end, QVector<qint64> *result) :
+        m_search(search),
+        m_text(text),
+        m_begin(begin),
+        m_end(end),
+        m_result(result)
+    {
+    }
+
+public:
+    void run() override
+    {
+        const QVector<mbCoreLogViewModel::Message> &messages = m_search->m_messages;
+        const QVector<qint64> &seqs = m_search->m_seqs;
+        for (int i = m_begin; i < m_end; i++)
+        {
+            if (((i & 0x3FF) == 0) && m_search->m_cancel.load())
+                return;
+            if (messages.at(i).lowerText().contains(m_text))
+                m_result->append(seqs.at(i));
+        }
+    }
+
+private:
+    mbCoreLogViewSearch *m_search;
+    QByteArray m_text;
+    int m_begin;
+    int m_end;
+    QVector<qint64> *m_result;
+};
+
+mbCoreLogViewSearch::mbCoreLogViewSearch(QObject *parent) : QThread(parent)
+{
+}
+
+mbCoreLogViewSearch::~mbCoreLogViewSearch()
+{
+    cancel();
+    wait();
+}
+
+void mbCoreLogViewSearch::search(const QVector<qint64> &seqs, const QVector<mbCoreLogViewModel::Message> &messages, const QString &text)
+{
+    cancel();
+    wait();
+    m_seqs = seqs;
+    m_messages = messages;
+    m_text = text;
+    m_result.clear();
+    m_cancel.store(0);
+    start();
+}
+
+void mbCoreLogViewSearch::cancel()
+{
+    m_cancel.store(1);
+}
+
+QVector<qint64> mbCoreLogViewSearch::takeResult()
+{
+    QVector<qint64> r;
+    r.swap(m_result);
+    // Note: messages are released, so memory of the removed messages is not kept by search
+    m_messages = QVector<mbCoreLogViewModel::Message>();
+    m_seqs = QVector<qint64>();
+    return r;
+}
+
+void mbCoreLogViewSearch::run()
+{
+    int count = m_messages.count();
+    int threads = qMax(1, m_pool.maxThreadCount());
+    int partSize = qMax(LOGVIEWSEARCH_MIN_PART_SIZE, (count + threads - 1) / threads);
+    // Note: case insensitive search is made by comparing bytes of lower case UTF-8 texts
+    QByteArray text = m_text.toLower().toUtf8();
+    QVector<QVector<qint64> > results((count + partSize - 1) / partSize);
+    for (int i = 0; i < results.count(); i++)
+        m_pool.start(new Part(this, text, i * partSize, qMin(count, (i + 1) * partSize), &results[i]));
+    m_pool.waitForDone();
+    if (m_cancel.load())
+        return;
+    // Note: parts are ordered, so result is sorted
+    Q_FOREACH (const QVector<qint64> &r, results)
+        m_result += r;
+}
@@ -0,0 +1,68 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_LOGVIEWSEARCH_H
+#define CORE_LOGVIEWSEARCH_H
+
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+#include "core_logviewmodel.h"
+
+// Searches substring in the text of log messages in separate thread.
+// Messages are split into parts that are searched in parallel by the private thread pool,
+// so searching in a million of messages takes only fraction of a second.
+// Text of the message is formatted (lower case UTF-8) by the search and released right after comparison,
+// so search doesn't keep formatted texts of the whole buffer in memory.
+// 'QThread::finished()' signal is emitted when search is finished.
+class mbCoreLogViewSearch : public QThread
+{
+public:
+    explicit mbCoreLogViewSearch(QObject *parent = nullptr);
+    ~mbCoreLogViewSearch();
+
+public:
+    // Starts search of 'text' in 'messages' ('seqs' contains sequence numbers of the messages).
+    // Previous search is cancelled
+    void search(const QVector<qint64> &seqs, const QVector<mbCoreLogViewModel::Message> &messages, const QString &text);
+    // Cancels current search. Use 'wait()' to wait until search thread is finished
+    void cancel();
+    // Returns sorted sequence numbers of the messages that contain searched text
+    QVector<qint64> takeResult();
+
+protected:
+    void run() override;
+
+private:
+    class Part;
+
+private:
+    QVector<qint64> m_seqs;
+    QVector<mbCoreLogViewModel::Message> m_messages;
+    QString m_text;
+    QVector<qint64> m_result;
+    QAtomicInt m_cancel;
+    QThreadPool m_pool;
+};
+
+#endif // CORE_LOGVIEWSEARCH_H
@@ -1,7 +1,9 @@
 HEADERS +=                       \
-    #$$PWD/core_logviewmodel.h    \
+    $$PWD/core_logviewmodel.h     \
+    $$PWD/core_logviewsearch.h    \
     $$PWD/core_logview.h
 
 SOURCES +=                       \
-    #$$PWD/core_logviewmodel.cpp  \
+    $$PWD/core_logviewmodel.cpp   \
+    $$PWD/core_logviewsearch.cpp  \
     $$PWD/core_logview.cpp
@@ -37,6 +37,17 @@ mbCoreRunTaskThread::~mbCoreRunTaskThread()
     delete m_task;
 }
 
+void mbCoreRunTaskThread::stop()
+{
+    m_mutex.lock();
+    m_run = false;
+    m_mutex.unlock();
+    m_cond.wakeAll();
+}
+
+// Max time (milliseconds) thread sleeps between task loops, so thread events are processed regularly
+#define TASK_MAX_SLEEP 100
+
 void mbCoreRunTaskThread::run()
 {
     QEventLoop ev;
@@ -46,7 +57,15 @@ void mbCoreRunTaskThread::run()
     {
         ev.processEvents();
         m_task->loop();
-        Modbus::msleep(1);
+        int sleep = m_task->nextLoopTimeout();
+        if (sleep <= 0)
+            sleep = 1;
+        else if (sleep > TASK_MAX_SLEEP)
+            sleep = TASK_MAX_SLEEP;
+        m_mutex.lock();
+        if (m_run)
+            m_cond.wait(&m_mutex, static_cast<unsigned long>(sleep));
+        m_mutex.unlock();
     }
     m_task->final();
 }
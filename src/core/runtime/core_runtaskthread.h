@@ -24,6 +24,8 @@
 #define CORE_RUNTASKTHREAD_H
 
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 
 #include <mbcore_base.h>
 
@@ -36,7 +38,7 @@ public:
     ~mbCoreRunTaskThread();
 
 public:
-    inline void stop() { m_run = false; }
+    void stop();
 
 protected:
     void run();
@@ -44,6 +46,8 @@ protected:
 protected:
     mbCoreTask* m_task;
     bool m_run;
+    QMutex m_mutex;
+    QWaitCondition m_cond;
 };
 
 #endif // CORE_RUNTASKTHREAD_H
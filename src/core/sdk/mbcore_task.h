@@ -38,6 +38,9 @@ public: // task interface
     virtual int init() = 0;
     virtual int loop() = 0;
     virtual int final() = 0;
+    // Note: returns time (milliseconds) after last 'loop' call that task doesn't need next 'loop' call,
+    //       so task thread can sleep until then. Zero or negative means 'loop' is called every millisecond
+    virtual int nextLoopTimeout() { return 0; }
 };
 
 
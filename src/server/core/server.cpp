@@ -45,9 +45,15 @@ mbServer::Strings::Strings() : mbCore::Strings(),
     settings_scriptEnable         (QStringLiteral("Script.Enable")),
     settings_scriptUseOptimization(QStringLiteral("Script.UseOptimization")),
     settings_scriptLoopPeriod     (QStringLiteral("Script.LoopPeriod")),
+    settings_scriptEmbedded       (QStringLiteral("Script.Embedded")),
+    settings_scriptWorkerPool     (QStringLiteral("Script.WorkerPool")),
+    settings_scriptWorkerCount    (QStringLiteral("Script.WorkerCount")),
     settings_scriptManual         (QStringLiteral("Script.Manual")),
     settings_scriptDefault        (QStringLiteral("Script.DefaultInterpreter")),
-    settings_scriptImportPath     (QStringLiteral("Script.ImportPath"))
+    settings_scriptImportPath     (QStringLiteral("Script.ImportPath")),
+    settings_runtimeWorkerPool    (QStringLiteral("Runtime.WorkerPool")),
+    settings_runtimeWorkerCount   (QStringLiteral("Runtime.WorkerCount")),
+    settings_runtimeSimActionThreads(QStringLiteral("Runtime.SimActionThreads"))
 {
 }
 
@@ -140,7 +146,13 @@ mbServer::mbServer() :
     m_scriptEnable = true;
     m_scriptUseOptimization = true;
     m_scriptLoopPeriod = 100;
+    m_scriptEmbedded = false;
+    m_scriptWorkerPool = false;
+    m_scriptWorkerCount = 0; // Note: 0 means count of CPU cores
     m_autoDetectedExec = findPythonExecutables();
+    m_runtimeWorkerPool = false;
+    m_runtimeWorkerCount = 0; // Note: 0 means count of CPU cores
+    m_runtimeSimActionThreads = 1; // Note: 0 means count of CPU cores
 }
 
 mbServer::~mbServer()
@@ -154,9 +166,15 @@ MBSETTINGS mbServer::cachedSettings() const
     r[s.settings_scriptEnable           ] = scriptEnable           ();
     r[s.settings_scriptUseOptimization  ] = scriptUseOptimization  ();
     r[s.settings_scriptLoopPeriod       ] = scriptLoopPeriod       ();
+    r[s.settings_scriptEmbedded         ] = scriptEmbedded         ();
+    r[s.settings_scriptWorkerPool       ] = scriptWorkerPool       ();
+    r[s.settings_scriptWorkerCount      ] = scriptWorkerCount      ();
     r[s.settings_scriptManual           ] = scriptManualExecutables();
     r[s.settings_scriptDefault          ] = scriptDefaultExecutable();
     r[s.settings_scriptImportPath       ] = scriptImportPath       ();
+    r[s.settings_runtimeWorkerPool      ] = runtimeWorkerPool      ();
+    r[s.settings_runtimeWorkerCount     ] = runtimeWorkerCount     ();
+    r[s.settings_runtimeSimActionThreads] = runtimeSimActionThreads();
     return r;
 }
 
@@ -171,9 +189,15 @@ void mbServer::setCachedSettings(const MBSETTINGS &settings)
     it = settings.find(s.settings_scriptEnable          ); if (it != end) setScriptEnable           (it.value().toBool      ());
     it = settings.find(s.settings_scriptUseOptimization ); if (it != end) setScriptUseOptimization  (it.value().toBool      ());
     it = settings.find(s.settings_scriptLoopPeriod      ); if (it != end) setScriptLoopPeriod       (it.value().toInt       ());
+    it = settings.find(s.settings_scriptEmbedded        ); if (it != end) setScriptEmbedded         (it.value().toBool      ());
+    it = settings.find(s.settings_scriptWorkerPool      ); if (it != end) setScriptWorkerPool       (it.value().toBool      ());
+    it = settings.find(s.settings_scriptWorkerCount     ); if (it != end) setScriptWorkerCount      (it.value().toInt       ());
     it = settings.find(s.settings_scriptManual          ); if (it != end) scriptSetManualExecutables(it.value().toStringList());
     it = settings.find(s.settings_scriptDefault         ); if (it != end) scriptSetDefaultExecutable(it.value().toString    ());
     it = settings.find(s.settings_scriptImportPath      ); if (it != end) scriptSetImportPath       (it.value().toStringList());
+    it = settings.find(s.settings_runtimeWorkerPool     ); if (it != end) setRuntimeWorkerPool      (it.value().toBool      ());
+    it = settings.find(s.settings_runtimeWorkerCount    ); if (it != end) setRuntimeWorkerCount     (it.value().toInt       ());
+    it = settings.find(s.settings_runtimeSimActionThreads); if (it != end) setRuntimeSimActionThreads(it.value().toInt      ());
 }
 
 QString mbServer::scriptDefaultExecutable() const
@@ -52,9 +52,15 @@ public:
         const QString settings_scriptEnable         ;
         const QString settings_scriptUseOptimization;
         const QString settings_scriptLoopPeriod     ;
+        const QString settings_scriptEmbedded       ;
+        const QString settings_scriptWorkerPool     ;
+        const QString settings_scriptWorkerCount    ;
         const QString settings_scriptManual         ;
         const QString settings_scriptDefault        ;
         const QString settings_scriptImportPath     ;
+        const QString settings_runtimeWorkerPool    ;
+        const QString settings_runtimeWorkerCount   ;
+        const QString settings_runtimeSimActionThreads;
         Strings();
         static const Strings &instance();
     };
@@ -84,6 +90,12 @@ public:
     inline void setScriptUseOptimization(bool use) { m_scriptUseOptimization = use; }
     inline int scriptLoopPeriod() const { return m_scriptLoopPeriod; }
     inline void setScriptLoopPeriod(int period) { m_scriptLoopPeriod = period; }
+    inline bool scriptEmbedded() const { return m_scriptEmbedded; }
+    inline void setScriptEmbedded(bool embedded) { m_scriptEmbedded = embedded; }
+    inline bool scriptWorkerPool() const { return m_scriptWorkerPool; }
+    inline void setScriptWorkerPool(bool use) { m_scriptWorkerPool = use; }
+    inline int scriptWorkerCount() const { return m_scriptWorkerCount; }
+    inline void setScriptWorkerCount(int count) { m_scriptWorkerCount = count; }
     inline QStringList scriptAutoDetectedExecutables() const { return m_autoDetectedExec; }
     inline QStringList scriptManualExecutables() const { return m_manualExec; }
     inline void scriptSetManualExecutables(const QStringList &exec) { m_manualExec = exec; }
@@ -93,6 +105,14 @@ public:
     QStringList scriptImportPath() const;
     void scriptSetImportPath(const QStringList &pathList);
 
+public:
+    inline bool runtimeWorkerPool() const { return m_runtimeWorkerPool; }
+    inline void setRuntimeWorkerPool(bool use) { m_runtimeWorkerPool = use; }
+    inline int runtimeWorkerCount() const { return m_runtimeWorkerCount; }
+    inline void setRuntimeWorkerCount(int count) { m_runtimeWorkerCount = count; }
+    inline int runtimeSimActionThreads() const { return m_runtimeSimActionThreads; }
+    inline void setRuntimeSimActionThreads(int count) { m_runtimeSimActionThreads = count; }
+
 private:
     QString createGUID() override;
     mbCoreUi* createUi() override;
@@ -104,10 +124,16 @@ private:
     bool m_scriptEnable;
     bool m_scriptUseOptimization;
     int m_scriptLoopPeriod;
+    bool m_scriptEmbedded;
+    bool m_scriptWorkerPool;
+    int m_scriptWorkerCount;
     QStringList m_autoDetectedExec;
     QStringList m_manualExec;
     mutable QString m_defaultExec;
     QStringList m_importPath;
+    bool m_runtimeWorkerPool;
+    int m_runtimeWorkerCount;
+    int m_runtimeSimActionThreads;
 };
 
 #endif // SERVER_H
@@ -113,6 +113,25 @@ void mbServerDeviceUiModel::setRowCount(int count)
     endResetModel();
 }
 
+void mbServerDeviceUiModel::refreshRanges(const mbServerDevice::MemoryBlock::Ranges_t &ranges, int itemBits)
+{
+    int rows = rowCount();
+    if (rows == 0)
+        return;
+    Q_FOREACH (const mbServerDevice::MemoryBlock::Range &range, ranges)
+    {
+        int first = static_cast<int>(range.offset) * MB_BYTE_SZ_BITES / itemBits;
+        int last = static_cast<int>(range.offset + range.count) * MB_BYTE_SZ_BITES / itemBits - 1;
+        int firstRow = first / ColumnCount;
+        int lastRow = last / ColumnCount;
+        if (firstRow >= rows)
+            break;
+        if (lastRow >= rows)
+            lastRow = rows-1;
+        Q_EMIT dataChanged(index(firstRow, 0), index(lastRow, columnCount()-1));
+    }
+}
+
 void mbServerDeviceUiModel::setFormat(int format)
 {
     if (m_format != format)
@@ -185,7 +204,7 @@ void mbServerDeviceUiModel_0x::refresh()
     uint c = m_device->changeCounter_0x();
     if (m_changeCounter != c)
     {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
+        refreshRanges(m_device->changedRanges_0x(m_changeCounter, &c), 1);
         m_changeCounter = c;
     }
 }
@@ -253,7 +272,7 @@ void mbServerDeviceUiModel_1x::refresh()
     uint c = m_device->changeCounter_1x();
     if (m_changeCounter != c)
     {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
+        refreshRanges(m_device->changedRanges_1x(m_changeCounter, &c), 1);
         m_changeCounter = c;
     }
 }
@@ -352,7 +371,7 @@ void mbServerDeviceUiModel_3x::refresh()
     uint c = m_device->changeCounter_3x();
     if (m_changeCounter != c)
     {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
+        refreshRanges(m_device->changedRanges_3x(m_changeCounter, &c), MB_REGE_SZ_BITES);
         m_changeCounter = c;
     }
 }
@@ -451,7 +470,7 @@ void mbServerDeviceUiModel_4x::refresh()
     uint c = m_device->changeCounter_4x();
     if (m_changeCounter != c)
     {
-        Q_EMIT dataChanged(index(0, 0), index(rowCount()-1, columnCount()-1));
+        refreshRanges(m_device->changedRanges_4x(m_changeCounter, &c), MB_REGE_SZ_BITES);
         m_changeCounter = c;
     }
 }
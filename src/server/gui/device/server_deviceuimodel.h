@@ -27,7 +27,7 @@
 
 #include <mbcore.h>
 
-class mbServerDevice;
+#include <project/server_device.h>
 
 class mbServerDeviceUiModel : public QAbstractTableModel
 {
@@ -88,6 +88,11 @@ protected Q_SLOTS:
     void setRowCount(int count);
     void setFormat(int format);
 
+protected:
+    // Emits 'dataChanged' only for rows that contain changed memory.
+    // 'itemBits' is size of one table item in bits (1 for bits or 16 for registers)
+    void refreshRanges(const mbServerDevice::MemoryBlock::Ranges_t &ranges, int itemBits);
+
 protected:
     QString m_sym;
 
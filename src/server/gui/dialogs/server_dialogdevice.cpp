@@ -113,11 +113,21 @@ mbServerDialogDevice::mbServerDialogDevice(QWidget *parent) :
     ui->chbSaveData->setChecked(dDevice.isSaveData);
     // Read Only
     ui->chbReadOnly->setChecked(dDevice.isReadOnly);
+    // Sparse Memory
+    ui->chbSparseMemory->setChecked(dDevice.isSparseMemory);
 
     // Delay
     sp = ui->spDelay;
     sp->setMinimum(0);
     sp->setMaximum(INT_MAX);
+    // Delay Jitter
+    sp = ui->spDelayJitter;
+    sp->setMinimum(0);
+    sp->setMaximum(INT_MAX);
+    // Delay Distribution
+    QMetaEnum eDistribution = mb::metaEnum<mbServerDevice::DelayDistribution>();
+    for (int i = 0; i < eDistribution.keyCount(); i++)
+        ui->cmbDelayDistribution->addItem(QString(eDistribution.key(i)));
     // Enable Script
     ui->chbEnableScript->setChecked(dDevice.isEnableScript);
 }
@@ -140,7 +150,10 @@ MBSETTINGS mbServerDialogDevice::cachedSettings() const
     m[prefix+ms.count4x       ] = ui->spCount4x      ->value    ();
     m[prefix+ms.isSaveData    ] = ui->chbSaveData    ->isChecked();
     m[prefix+ms.isReadOnly    ] = ui->chbReadOnly    ->isChecked();
+    m[prefix+ms.isSparseMemory] = ui->chbSparseMemory->isChecked();
     m[prefix+ms.delay         ] = ui->spDelay        ->value    ();
+    m[prefix+ms.delayJitter   ] = ui->spDelayJitter  ->value    ();
+    m[prefix+ms.delayDistribution] = ui->cmbDelayDistribution->currentText();
     m[prefix+ms.isEnableScript] = ui->chbEnableScript->isChecked();
     m[prefix+ms.maxWriteMultipleRegisters] = m_ui.spMaxWriteMultipleRegisters->value      ();
     m[prefix+ms.maxWriteMultipleRegisters] = m_ui.spMaxWriteMultipleRegisters->value      ();
@@ -168,7 +181,10 @@ void mbServerDialogDevice::setCachedSettings(const MBSETTINGS &m)
     it = m.find(prefix+vs.count4x   ); if (it != end) ui->spCount4x  ->setValue  (it.value().toInt   ());
     it = m.find(prefix+vs.isSaveData); if (it != end) ui->chbSaveData->setChecked(it.value().toBool  ());
     it = m.find(prefix+vs.isReadOnly); if (it != end) ui->chbReadOnly->setChecked(it.value().toBool  ());
+    it = m.find(prefix+vs.isSparseMemory); if (it != end) ui->chbSparseMemory->setChecked(it.value().toBool());
     it = m.find(prefix+vs.delay     ); if (it != end) ui->spDelay    ->setValue  (it.value().toInt   ());
+    it = m.find(prefix+vs.delayJitter); if (it != end) ui->spDelayJitter->setValue(it.value().toInt   ());
+    it = m.find(prefix+vs.delayDistribution); if (it != end) ui->cmbDelayDistribution->setCurrentText(it.value().toString());
 
     it = m.find(prefix+vs.exceptionStatusAddress);
     if (it != end)
@@ -288,14 +304,43 @@ void mbServerDialogDevice::fillFormDevice(const MBSETTINGS &m)
     it = m.find(vs.count4x       ); if (it != end) ui->spCount4x      ->setValue  (it.value().toInt ());
     it = m.find(vs.isSaveData    ); if (it != end) ui->chbSaveData    ->setChecked(it.value().toBool());
     it = m.find(vs.isReadOnly    ); if (it != end) ui->chbReadOnly    ->setChecked(it.value().toBool());
+    it = m.find(vs.isSparseMemory); if (it != end) ui->chbSparseMemory->setChecked(it.value().toBool());
     it = m.find(vs.delay         ); if (it != end) ui->spDelay        ->setValue  (it.value().toInt ());
+    it = m.find(vs.delayJitter   ); if (it != end) ui->spDelayJitter  ->setValue  (it.value().toInt ());
+    it = m.find(vs.delayDistribution);
+    if (it != end)
+        ui->cmbDelayDistribution->setCurrentText(mb::enumKey(mb::enumValue<mbServerDevice::DelayDistribution>(it.value(), mbServerDevice::DelayUniform)));
     it = m.find(vs.isEnableScript); if (it != end) ui->chbEnableScript->setChecked(it.value().toBool());
+    it = m.find(vs.memoryAliases ); if (it != end) ui->lnMemoryAliases->setText   (it.value().toString());
 
     it = m.find(vs.exceptionStatusAddress);
     if (it != end)
     {
         setModbusExceptionStatusAddress(it.value());
     }
+
+    // Note: memory usage is known only for existing device
+    QString memoryUsage = QStringLiteral("-");
+    mbServerProject *project = mbServer::global()->project();
+    it = m.find(vs.name);
+    if (project && (it != end))
+    {
+        if (mbServerDevice *d = project->device(it.value().toString()))
+            memoryUsage = memoryUsageStr(d->memoryUsage());
+    }
+    const mbServerDevice::MemoryPool *pool = mbServerDevice::MemoryPool::global();
+    ui->lblMemoryUsageValue->setText(memoryUsage);
+    ui->lblMemoryUsageValue->setToolTip(QString("Sparse memory pool: %1 used, %2 reserved").arg(memoryUsageStr(pool->usedBytes()),
+                                                                                              memoryUsageStr(pool->reservedBytes())));
+}
+
+QString mbServerDialogDevice::memoryUsageStr(size_t bytes)
+{
+    if (bytes < 1024)
+        return QString("%1 B").arg(bytes);
+    if (bytes < 1024*1024)
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    return QString("%1 MB").arg(bytes / (1024.0*1024.0), 0, 'f', 1);
 }
 
 void mbServerDialogDevice::fillDataDevice(MBSETTINGS &settings) const
@@ -312,8 +357,12 @@ void mbServerDialogDevice::fillDataDevice(MBSETTINGS &settings) const
     settings[s.count4x       ] = ui->spCount4x      ->value    ();
     settings[s.isSaveData    ] = ui->chbSaveData    ->isChecked();
     settings[s.isReadOnly    ] = ui->chbReadOnly    ->isChecked();
+    settings[s.isSparseMemory] = ui->chbSparseMemory->isChecked();
     settings[s.delay         ] = ui->spDelay        ->value    ();
+    settings[s.delayJitter   ] = ui->spDelayJitter  ->value    ();
+    settings[s.delayDistribution] = ui->cmbDelayDistribution->currentText();
     settings[s.isEnableScript] = ui->chbEnableScript->isChecked();
+    settings[s.memoryAliases ] = ui->lnMemoryAliases->text     ().trimmed();
 
     settings[s.exceptionStatusAddress   ] = mb::toInt(adr);
 }
@@ -65,6 +65,7 @@ private:
     void fillDataShowDevices(MBSETTINGS& settings) const;
     void fillFormDevice(const MBSETTINGS& settings);
     void fillDataDevice(MBSETTINGS& settings) const;
+    static QString memoryUsageStr(size_t bytes);
 
 private:
     void setEditEnabled(bool enabled);
@@ -44,6 +44,34 @@ mbServerDialogPort::mbServerDialogPort(QWidget *parent) :
     sp->setMaximum(INT32_MAX);
     sp->setValue(d.maxconn);
 
+    QComboBox *cmb;
+    // Run Mode
+    cmb = ui->cmbRunMode;
+    QMetaEnum me = QMetaEnum::fromType<mbServerPort::RunMode>();
+    for (int i = 0; i < me.keyCount(); i++)
+        cmb->addItem(me.key(i), me.value(i));
+    cmb->setCurrentIndex(cmb->findData(mbServerPort::Defaults::instance().runMode));
+
+    // Network Impairment
+    const mbServerPort::Impairment &impairment = mbServerPort::Defaults::instance().impairment;
+    sp = ui->spImpairLatency;
+    sp->setMaximum(INT32_MAX);
+    sp->setValue(impairment.latency);
+    sp = ui->spImpairJitter;
+    sp->setMaximum(INT32_MAX);
+    sp->setValue(impairment.jitter);
+    sp = ui->spImpairBaudRate;
+    sp->setMaximum(INT32_MAX);
+    sp->setSpecialValueText(QStringLiteral("Unlimited"));
+    sp->setValue(impairment.baudRate);
+    QDoubleSpinBox *dsp;
+    dsp = ui->dspImpairLoss;
+    dsp->setRange(0, 100);
+    dsp->setValue(impairment.loss);
+    dsp = ui->dspImpairCorruption;
+    dsp->setRange(0, 100);
+    dsp->setValue(impairment.corruption);
+
     m_ui.lnName             = ui->lnName             ;
     m_ui.cmbType            = ui->cmbType            ;
     m_ui.cmbSerialPortName  = ui->cmbSerialPortName  ;
@@ -99,6 +127,22 @@ void mbServerDialogPort::fillFormInner(const MBSETTINGS &settings)
     MBSETTINGS::const_iterator end = settings.end();
 
     it = settings.find(vs.maxconn); if (it != end) ui->spMaxConn->setValue(it.value().toInt());
+
+    const mbServerPort::Strings &sPort = mbServerPort::Strings::instance();
+    it = settings.find(sPort.runMode);
+    if (it != end)
+    {
+        bool ok;
+        mbServerPort::RunMode v = mb::enumValue<mbServerPort::RunMode>(it.value(), &ok);
+        if (ok)
+            ui->cmbRunMode->setCurrentIndex(ui->cmbRunMode->findData(v));
+    }
+
+    it = settings.find(sPort.impairLatency   ); if (it != end) ui->spImpairLatency    ->setValue(it.value().toInt());
+    it = settings.find(sPort.impairJitter    ); if (it != end) ui->spImpairJitter     ->setValue(it.value().toInt());
+    it = settings.find(sPort.impairLoss      ); if (it != end) ui->dspImpairLoss      ->setValue(it.value().toDouble());
+    it = settings.find(sPort.impairCorruption); if (it != end) ui->dspImpairCorruption->setValue(it.value().toDouble());
+    it = settings.find(sPort.impairBaudRate  ); if (it != end) ui->spImpairBaudRate   ->setValue(it.value().toInt());
 }
 
 void mbServerDialogPort::fillDataInner(MBSETTINGS &settings) const
@@ -106,4 +150,12 @@ void mbServerDialogPort::fillDataInner(MBSETTINGS &settings) const
     Modbus::Strings vs = Modbus::Strings::instance();
 
     settings[vs.maxconn] = ui->spMaxConn->value();
+
+    const mbServerPort::Strings &sPort = mbServerPort::Strings::instance();
+    settings[sPort.runMode] = ui->cmbRunMode->currentText();
+    settings[sPort.impairLatency   ] = ui->spImpairLatency    ->value();
+    settings[sPort.impairJitter    ] = ui->spImpairJitter     ->value();
+    settings[sPort.impairLoss      ] = ui->dspImpairLoss      ->value();
+    settings[sPort.impairCorruption] = ui->dspImpairCorruption->value();
+    settings[sPort.impairBaudRate  ] = ui->spImpairBaudRate   ->value();
 }
@@ -24,10 +24,17 @@
 #include "ui_server_dialogsimaction.h"
 
 #include <QMetaEnum>
+#include <QDir>
+#include <QProgressDialog>
+#include <QMessageBox>
 
 #include <server.h>
 #include <project/server_project.h>
 #include <project/server_simaction.h>
+#include <runtime/server_replayfile.h>
+
+#include <gui/server_ui.h>
+#include <gui/dialogs/server_dialogs.h>
 
 #include <gui/widgets/core_addresswidget.h>
 
@@ -118,6 +125,30 @@ mbServerDialogSimAction::mbServerDialogSimAction(QWidget *parent) :
     sp->setMinimum(0);
     sp->setMaximum(USHRT_MAX);
 
+    // Action Waveform
+    cmb = ui->cmbActionWaveformType;
+    e = mb::metaEnum<mbServerSimAction::WaveformType>();
+    for (int i = 0; i < e.keyCount(); i++)
+        cmb->addItem(QString(e.key(i)));
+    cmb->setCurrentText(mb::enumKey(d.waveformType));
+    sp = ui->spActionWaveformChannels;
+    sp->setMinimum(1);
+    sp->setMaximum(USHRT_MAX);
+    sp->setValue(d.waveformChannels);
+    ui->lnActionWaveformPeriod->setText(QString::number(d.waveformPeriod));
+    ui->lnActionWaveformPhaseStep->setText(QString::number(d.waveformPhaseStep));
+    ui->lnActionWaveformAmplitude->setText(QString::number(d.waveformAmplitude));
+    ui->lnActionWaveformOffset->setText(QString::number(d.waveformOffset));
+
+    // Action Replay
+    sp = ui->spActionReplayChannels;
+    sp->setMinimum(1);
+    sp->setMaximum(USHRT_MAX);
+    sp->setValue(d.replayChannels);
+    ui->lnActionReplaySpeed->setText(QString::number(d.replaySpeed));
+    ui->chbActionReplayLoop->setChecked(d.replayLoop);
+    connect(ui->btnActionReplayFile, &QToolButton::clicked, this, &mbServerDialogSimAction::browseReplayFile);
+
     //--------------------- ADVANCED ---------------------
     // Byte Order
     cmb = ui->cmbByteOrder;
@@ -169,6 +200,17 @@ MBSETTINGS mbServerDialogSimAction::cachedSettings() const
     m[prefix+vs.randomMax        ] = ui->lnActionRandomMax->text();
     m[prefix+vs.copySourceAddress] = mb::toInt(adrCopy);
     m[prefix+vs.copySize         ] = ui->spCopySize->value();
+    m[prefix+vs.waveformType     ] = ui->cmbActionWaveformType->currentText();
+    m[prefix+vs.waveformChannels ] = ui->spActionWaveformChannels->value();
+    m[prefix+vs.waveformPeriod   ] = ui->lnActionWaveformPeriod->text();
+    m[prefix+vs.waveformPhaseStep] = ui->lnActionWaveformPhaseStep->text();
+    m[prefix+vs.waveformAmplitude] = ui->lnActionWaveformAmplitude->text();
+    m[prefix+vs.waveformOffset   ] = ui->lnActionWaveformOffset->text();
+    m[prefix+vs.waveformTable    ] = ui->lnActionWaveformTable->text();
+    m[prefix+vs.replayFile       ] = ui->lnActionReplayFile->text();
+    m[prefix+vs.replayChannels   ] = ui->spActionReplayChannels->value();
+    m[prefix+vs.replaySpeed      ] = ui->lnActionReplaySpeed->text();
+    m[prefix+vs.replayLoop       ] = ui->chbActionReplayLoop->isChecked();
     m[prefix+vs.actionType       ] = ui->cmbActionType->currentText();
     m[prefix+vs.byteOrder        ] = ui->cmbByteOrder->currentText();
     m[prefix+vs.registerOrder    ] = ui->cmbRegisterOrder->currentText();
@@ -212,6 +254,17 @@ void mbServerDialogSimAction::setCachedSettings(const MBSETTINGS &m)
     it = m.find(prefix+vs.randomMin        ); if (it != end) ui->lnActionRandomMin->setText(it.value().toString());
     it = m.find(prefix+vs.randomMax        ); if (it != end) ui->lnActionRandomMax->setText(it.value().toString());
     it = m.find(prefix+vs.copySize         ); if (it != end) ui->spCopySize->setValue(it.value().toInt());
+    it = m.find(prefix+vs.waveformType     ); if (it != end) ui->cmbActionWaveformType->setCurrentText(it.value().toString());
+    it = m.find(prefix+vs.waveformChannels ); if (it != end) ui->spActionWaveformChannels->setValue(it.value().toInt());
+    it = m.find(prefix+vs.waveformPeriod   ); if (it != end) ui->lnActionWaveformPeriod->setText(it.value().toString());
+    it = m.find(prefix+vs.waveformPhaseStep); if (it != end) ui->lnActionWaveformPhaseStep->setText(it.value().toString());
+    it = m.find(prefix+vs.waveformAmplitude); if (it != end) ui->lnActionWaveformAmplitude->setText(it.value().toString());
+    it = m.find(prefix+vs.waveformOffset   ); if (it != end) ui->lnActionWaveformOffset->setText(it.value().toString());
+    it = m.find(prefix+vs.waveformTable    ); if (it != end) ui->lnActionWaveformTable->setText(it.value().toString());
+    it = m.find(prefix+vs.replayFile       ); if (it != end) ui->lnActionReplayFile->setText(it.value().toString());
+    it = m.find(prefix+vs.replayChannels   ); if (it != end) ui->spActionReplayChannels->setValue(it.value().toInt());
+    it = m.find(prefix+vs.replaySpeed      ); if (it != end) ui->lnActionReplaySpeed->setText(it.value().toString());
+    it = m.find(prefix+vs.replayLoop       ); if (it != end) ui->chbActionReplayLoop->setChecked(it.value().toBool());
     it = m.find(prefix+vs.actionType       ); if (it != end) ui->cmbActionType->setCurrentText(mb::enumKey(mb::enumValue<mbServerSimAction::ActionType>(it.value())));
     it = m.find(prefix+vs.byteOrder        ); if (it != end) fillFormByteOrder(mb::enumDataOrderValue(it.value()));
     it = m.find(prefix+vs.registerOrder    ); if (it != end) fillFormRegisterOrder(mb::toRegisterOrder(it.value()));
@@ -239,6 +292,9 @@ MBSETTINGS mbServerDialogSimAction::getSettings(const MBSETTINGS &settings, cons
     {
     case QDialog::Accepted:
         fillData(r);
+        // Note: recorded file is imported here, so runtime start only opens prepared binary file
+        if (mb::enumValue<mbServerSimAction::ActionType>(r.value(mbServerSimAction::Strings::instance().actionType)) == mbServerSimAction::Replay)
+            importReplayFile(ui->lnActionReplayFile->text());
     }
     return r;
 }
@@ -348,6 +404,28 @@ void mbServerDialogSimAction::fillFormActionType(const MBSETTINGS &settings)
             ui->spCopySize->setValue(it.value().toInt());
     }
         break;
+    case mbServerSimAction::Waveform:
+    {
+        it = settings.find(sItem.waveformType);
+        if (it != end)
+        {
+            mbServerSimAction::WaveformType wt = mb::enumValue<mbServerSimAction::WaveformType>(it.value(), mbServerSimAction::WaveformSine);
+            ui->cmbActionWaveformType->setCurrentText(mb::enumKey(wt));
+        }
+        it = settings.find(sItem.waveformChannels ); if (it != end) ui->spActionWaveformChannels ->setValue(it.value().toInt());
+        it = settings.find(sItem.waveformPeriod   ); if (it != end) ui->lnActionWaveformPeriod   ->setText(it.value().toString());
+        it = settings.find(sItem.waveformPhaseStep); if (it != end) ui->lnActionWaveformPhaseStep->setText(it.value().toString());
+        it = settings.find(sItem.waveformAmplitude); if (it != end) ui->lnActionWaveformAmplitude->setText(it.value().toString());
+        it = settings.find(sItem.waveformOffset   ); if (it != end) ui->lnActionWaveformOffset   ->setText(it.value().toString());
+        it = settings.find(sItem.waveformTable    ); if (it != end) ui->lnActionWaveformTable    ->setText(it.value().toString());
+    }
+        break;
+    case mbServerSimAction::Replay:
+        it = settings.find(sItem.replayFile    ); if (it != end) ui->lnActionReplayFile    ->setText(it.value().toString());
+        it = settings.find(sItem.replayChannels); if (it != end) ui->spActionReplayChannels->setValue(it.value().toInt());
+        it = settings.find(sItem.replaySpeed   ); if (it != end) ui->lnActionReplaySpeed   ->setText(it.value().toString());
+        it = settings.find(sItem.replayLoop    ); if (it != end) ui->chbActionReplayLoop   ->setChecked(it.value().toBool());
+        break;
     }
     ui->cmbActionType->setCurrentText(mb::enumKey<mbServerSimAction::ActionType>(t));
 }
@@ -445,6 +523,21 @@ void mbServerDialogSimAction::fillDataActionType(MBSETTINGS &settings)
         settings[sItem.copySize         ] = ui->spCopySize->value();
     }
         break;
+    case mbServerSimAction::Waveform:
+        settings[sItem.waveformType     ] = ui->cmbActionWaveformType->currentText();
+        settings[sItem.waveformChannels ] = ui->spActionWaveformChannels->value();
+        settings[sItem.waveformPeriod   ] = ui->lnActionWaveformPeriod->text();
+        settings[sItem.waveformPhaseStep] = ui->lnActionWaveformPhaseStep->text();
+        settings[sItem.waveformAmplitude] = ui->lnActionWaveformAmplitude->text();
+        settings[sItem.waveformOffset   ] = ui->lnActionWaveformOffset->text();
+        settings[sItem.waveformTable    ] = ui->lnActionWaveformTable->text();
+        break;
+    case mbServerSimAction::Replay:
+        settings[sItem.replayFile    ] = ui->lnActionReplayFile->text();
+        settings[sItem.replayChannels] = ui->spActionReplayChannels->value();
+        settings[sItem.replaySpeed   ] = ui->lnActionReplaySpeed->text();
+        settings[sItem.replayLoop    ] = ui->chbActionReplayLoop->isChecked();
+        break;
     }
     settings[sItem.actionType] = t;
 }
@@ -504,3 +597,54 @@ void mbServerDialogSimAction::setActionType(int i)
     ui->swActionType->setCurrentIndex(i);
 }
 
+void mbServerDialogSimAction::browseReplayFile()
+{
+    mbServerUi *serverUi = mbServer::global()->ui();
+    QString file = serverUi->dialogs()->getOpenFileName(this,
+                                                        QStringLiteral("Browse recorded data file ..."),
+                                                        QString(),
+                                                        serverUi->dialogs()->getFilterString(mbCoreDialogs::Filter_CsvFiles | mbCoreDialogs::Filter_AllFiles));
+    if (file.isEmpty())
+        return;
+    // Note: file within project directory is stored with relative path, so project can be moved with its data
+    mbServerProject *project = mbServer::global()->project();
+    if (project && !project->absoluteDirPath().isEmpty())
+    {
+        QString rel = QDir(project->absoluteDirPath()).relativeFilePath(file);
+        if (!rel.startsWith(QStringLiteral("..")))
+            file = rel;
+    }
+    ui->lnActionReplayFile->setText(file);
+}
+
+bool mbServerDialogSimAction::importReplayFile(const QString &file)
+{
+    if (file.isEmpty())
+        return false;
+    QString fileName = file;
+    mbServerProject *project = mbServer::global()->project();
+    if (project)
+        fileName = QDir(project->absoluteDirPath()).absoluteFilePath(fileName);
+    if (mbServerReplayFile::isImported(fileName))
+        return true;
+
+    QProgressDialog progress(QString("Import recorded data file '%1' ...").arg(file), QStringLiteral("Cancel"), 0, 100, this);
+    progress.setWindowTitle(QStringLiteral("Import"));
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    progress.setAutoReset(false);
+    mbServerReplayImport import(fileName);
+    connect(&import, &mbServerReplayImport::progressChanged, &progress, &QProgressDialog::setValue);
+    connect(&import, &QThread::finished, &progress, &QProgressDialog::reset);
+    connect(&progress, &QProgressDialog::canceled, &import, &mbServerReplayImport::cancel, Qt::DirectConnection);
+    import.start();
+    progress.exec();
+    import.wait();
+    if (!import.isSuccess())
+    {
+        QMessageBox::warning(this, QStringLiteral("Import"), import.errorString());
+        return false;
+    }
+    return true;
+}
+
@@ -77,11 +77,13 @@ private:
     void setModbusAddress(const QVariant &v);
     mb::Address modbusAddressCopy() const;
     void setModbusAddressCopy(const QVariant &v);
+    bool importReplayFile(const QString &file);
 
 private Q_SLOTS:
     void setModbusAddresNotation(mb::AddressNotation notation);
     void deviceChanged(int i);
     void setActionType(int i);
+    void browseReplayFile();
 
 private:
     Ui::mbServerDialogSimAction *ui;
@@ -6,6 +6,7 @@
 #include <server.h>
 
 #include "server_widgetsettingsscript.h"
+#include "server_widgetsettingsruntime.h"
 #include <gui/server_outputview.h>
 #include <gui/script/server_scriptmanager.h>
 
@@ -27,6 +28,10 @@ mbServerDialogSettings::mbServerDialogSettings(QWidget *parent) :
     m_listWidget->addItem(QStringLiteral("Script"));
     m_script = new mbServerWidgetSettingsScript(m_stackedWidget);
     m_stackedWidget->addWidget(m_script);
+
+    m_listWidget->addItem(QStringLiteral("Runtime"));
+    m_runtime = new mbServerWidgetSettingsRuntime(m_stackedWidget);
+    m_stackedWidget->addWidget(m_runtime);
 }
 
 void mbServerDialogSettings::fillForm(const MBSETTINGS &m)
@@ -39,6 +44,9 @@ void mbServerDialogSettings::fillForm(const MBSETTINGS &m)
     m_script->setScriptEnable            (m.value(ssrv.settings_scriptEnable         ).toBool      ());
     m_script->setScriptUseOptimization   (m.value(ssrv.settings_scriptUseOptimization).toBool      ());
     m_script->setScriptLoopPeriod        (m.value(ssrv.settings_scriptLoopPeriod     ).toInt       ());
+    m_script->setScriptEmbedded          (m.value(ssrv.settings_scriptEmbedded       ).toBool      ());
+    m_script->setScriptWorkerPool        (m.value(ssrv.settings_scriptWorkerPool     ).toBool      ());
+    m_script->setScriptWorkerCount       (m.value(ssrv.settings_scriptWorkerCount    ).toInt       ());
     m_script->setScriptGenerateComment   (m.value(sscr.settings_scriptGenerateComment).toBool      ());
     m_script->setScriptWordWrap          (m.value(sscr.settings_wordWrap             ).toBool      ());
     m_script->setScriptUseLineNumbers    (m.value(sscr.settings_useLineNumbers       ).toBool      ());
@@ -49,6 +57,9 @@ void mbServerDialogSettings::fillForm(const MBSETTINGS &m)
     m_script->scriptSetManualExecutables (m.value(ssrv.settings_scriptManual         ).toStringList());
     m_script->scriptSetDefaultExecutable (m.value(ssrv.settings_scriptDefault        ).toString    ());
     m_script->scriptSetImportPath        (m.value(ssrv.settings_scriptImportPath     ).toStringList());
+    m_runtime->setRuntimeWorkerPool      (m.value(ssrv.settings_runtimeWorkerPool    ).toBool      ());
+    m_runtime->setRuntimeWorkerCount     (m.value(ssrv.settings_runtimeWorkerCount   ).toInt       ());
+    m_runtime->setRuntimeSimActionThreads(m.value(ssrv.settings_runtimeSimActionThreads).toInt     ());
 }
 
 void mbServerDialogSettings::fillData(MBSETTINGS &m)
@@ -60,6 +71,9 @@ void mbServerDialogSettings::fillData(MBSETTINGS &m)
     m[ssrv.settings_scriptEnable         ] = m_script->scriptEnable            ();
     m[ssrv.settings_scriptUseOptimization] = m_script->scriptUseOptimization   ();
     m[ssrv.settings_scriptLoopPeriod     ] = m_script->scriptLoopPeriod        ();
+    m[ssrv.settings_scriptEmbedded       ] = m_script->scriptEmbedded          ();
+    m[ssrv.settings_scriptWorkerPool     ] = m_script->scriptWorkerPool        ();
+    m[ssrv.settings_scriptWorkerCount    ] = m_script->scriptWorkerCount       ();
     m[sscr.settings_scriptGenerateComment] = m_script->scriptGenerateComment   ();
     m[sscr.settings_wordWrap             ] = m_script->scriptWordWrap          ();
     m[sscr.settings_useLineNumbers       ] = m_script->scriptUseLineNumbers    ();
@@ -70,4 +84,7 @@ void mbServerDialogSettings::fillData(MBSETTINGS &m)
     m[ssrv.settings_scriptManual         ] = m_script->scriptManualExecutables ();
     m[ssrv.settings_scriptDefault        ] = m_script->scriptDefaultExecutable ();
     m[ssrv.settings_scriptImportPath     ] = m_script->scriptImportPath        ();
+    m[ssrv.settings_runtimeWorkerPool    ] = m_runtime->runtimeWorkerPool      ();
+    m[ssrv.settings_runtimeWorkerCount   ] = m_runtime->runtimeWorkerCount     ();
+    m[ssrv.settings_runtimeSimActionThreads] = m_runtime->runtimeSimActionThreads();
 }
@@ -4,6 +4,7 @@
 #include <gui/dialogs/settings/core_dialogsettings.h>
 
 class mbServerWidgetSettingsScript;
+class mbServerWidgetSettingsRuntime;
 
 class mbServerDialogSettings : public mbCoreDialogSettings
 {
@@ -25,6 +26,7 @@ protected:
 
 protected:
     mbServerWidgetSettingsScript *m_script;
+    mbServerWidgetSettingsRuntime *m_runtime;
 };
 
 #endif // SERVER_DIALOGSETTINGS_H
@@ -0,0 +1,68 @@
+#include "server_widgetsettingsruntime.h"
+#include "ui_server_widgetsettingsruntime.h"
+
+#include <QThread>
+
+#include <server.h>
+
+mbServerWidgetSettingsRuntime::mbServerWidgetSettingsRuntime(QWidget *parent) :
+    QWidget(parent),
+    ui(new Ui::mbServerWidgetSettingsRuntime)
+{
+    ui->setupUi(this);
+
+    QSpinBox *sp;
+
+    sp = ui->spWorkerCount;
+    sp->setMinimum(0);
+    sp->setMaximum(1024);
+    sp->setSpecialValueText(QString("Auto (%1)").arg(QThread::idealThreadCount()));
+
+    sp = ui->spSimActionThreads;
+    sp->setMinimum(0);
+    sp->setMaximum(1024);
+    sp->setSpecialValueText(QString("Auto (%1)").arg(QThread::idealThreadCount()));
+
+    connect(ui->chbWorkerPool, &QCheckBox::toggled, ui->spWorkerCount, &QWidget::setEnabled);
+
+    mbServer *server = mbServer::global();
+    setRuntimeWorkerPool(server->runtimeWorkerPool());
+    setRuntimeWorkerCount(server->runtimeWorkerCount());
+    setRuntimeSimActionThreads(server->runtimeSimActionThreads());
+}
+
+mbServerWidgetSettingsRuntime::~mbServerWidgetSettingsRuntime()
+{
+    delete ui;
+}
+
+bool mbServerWidgetSettingsRuntime::runtimeWorkerPool() const
+{
+    return ui->chbWorkerPool->isChecked();
+}
+
+void mbServerWidgetSettingsRuntime::setRuntimeWorkerPool(bool use)
+{
+    ui->chbWorkerPool->setChecked(use);
+    ui->spWorkerCount->setEnabled(use);
+}
+
+int mbServerWidgetSettingsRuntime::runtimeWorkerCount() const
+{
+    return ui->spWorkerCount->value();
+}
+
+void mbServerWidgetSettingsRuntime::setRuntimeWorkerCount(int count)
+{
+    ui->spWorkerCount->setValue(count);
+}
+
+int mbServerWidgetSettingsRuntime::runtimeSimActionThreads() const
+{
+    return ui->spSimActionThreads->value();
+}
+
+void mbServerWidgetSettingsRuntime::setRuntimeSimActionThreads(int count)
+{
+    ui->spSimActionThreads->setValue(count);
+}
@@ -0,0 +1,32 @@
+#ifndef SERVER_WIDGETSETTINGSRUNTIME_H
+#define SERVER_WIDGETSETTINGSRUNTIME_H
+
+#include <QWidget>
+
+namespace Ui {
+class mbServerWidgetSettingsRuntime;
+}
+
+class mbServerWidgetSettingsRuntime : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit mbServerWidgetSettingsRuntime(QWidget *parent = nullptr);
+    ~mbServerWidgetSettingsRuntime();
+
+public:
+    bool runtimeWorkerPool() const;
+    void setRuntimeWorkerPool(bool use);
+
+    int runtimeWorkerCount() const;
+    void setRuntimeWorkerCount(int count);
+
+    int runtimeSimActionThreads() const;
+    void setRuntimeSimActionThreads(int count);
+
+private:
+    Ui::mbServerWidgetSettingsRuntime *ui;
+};
+
+#endif // SERVER_WIDGETSETTINGSRUNTIME_H
@@ -2,6 +2,7 @@
 #include "ui_server_widgetsettingsscript.h"
 
 #include <QStringListModel>
+#include <QThread>
 
 #include <server.h>
 #include <gui/server_ui.h>
@@ -34,6 +35,18 @@ mbServerWidgetSettingsScript::mbServerWidgetSettingsScript(QWidget *parent) :
     sp->setMinimum(1);
     sp->setMaximum(8);
 
+    sp = ui->spScriptWorkerCount;
+    sp->setMinimum(0);
+    sp->setMaximum(1024);
+    sp->setSpecialValueText(QString("Auto (%1)").arg(QThread::idealThreadCount()));
+
+    connect(ui->chbScriptWorkerPool, &QCheckBox::toggled, ui->spScriptWorkerCount, &QWidget::setEnabled);
+
+#ifndef MB_PYTHON_EMBEDDED
+    // Note: server is built without embedded Python interpreter
+    ui->chbScriptEmbedded->setEnabled(false);
+#endif
+
     mbServer *server = mbServer::global();
     setScriptEnable(server->scriptEnable());
     setScriptEnable(server->scriptUseOptimization());
@@ -118,6 +131,37 @@ void mbServerWidgetSettingsScript::setScriptLoopPeriod(int period)
     ui->spLoopPeriod->setValue(period);
 }
 
+bool mbServerWidgetSettingsScript::scriptEmbedded() const
+{
+    return ui->chbScriptEmbedded->isChecked();
+}
+
+void mbServerWidgetSettingsScript::setScriptEmbedded(bool embedded)
+{
+    ui->chbScriptEmbedded->setChecked(embedded);
+}
+
+bool mbServerWidgetSettingsScript::scriptWorkerPool() const
+{
+    return ui->chbScriptWorkerPool->isChecked();
+}
+
+void mbServerWidgetSettingsScript::setScriptWorkerPool(bool use)
+{
+    ui->chbScriptWorkerPool->setChecked(use);
+    ui->spScriptWorkerCount->setEnabled(use);
+}
+
+int mbServerWidgetSettingsScript::scriptWorkerCount() const
+{
+    return ui->spScriptWorkerCount->value();
+}
+
+void mbServerWidgetSettingsScript::setScriptWorkerCount(int count)
+{
+    ui->spScriptWorkerCount->setValue(count);
+}
+
 bool mbServerWidgetSettingsScript::scriptGenerateComment() const
 {
     return ui->chbGenerateComment->isChecked();
@@ -31,6 +31,15 @@ public:
     int scriptLoopPeriod() const;
     void setScriptLoopPeriod(int period);
 
+    bool scriptEmbedded() const;
+    void setScriptEmbedded(bool embedded);
+
+    bool scriptWorkerPool() const;
+    void setScriptWorkerPool(bool use);
+
+    int scriptWorkerCount() const;
+    void setScriptWorkerCount(int count);
+
     bool scriptGenerateComment() const;
     void setScriptGenerateComment(bool gen);
 
@@ -3,6 +3,7 @@ HEADERS += \
     $$PWD/server_dialogsettings.h \
     $$PWD/server_modelsettingsscripteditorcolors.h \
     $$PWD/server_modelsettingsscriptinterpreters.h \
+    $$PWD/server_widgetsettingsruntime.h \
     $$PWD/server_widgetsettingsscript.h
 
 SOURCES += \
@@ -10,7 +11,9 @@ SOURCES += \
     $$PWD/server_dialogsettings.cpp \
     $$PWD/server_modelsettingsscripteditorcolors.cpp \
     $$PWD/server_modelsettingsscriptinterpreters.cpp \
+    $$PWD/server_widgetsettingsruntime.cpp \
     $$PWD/server_widgetsettingsscript.cpp
 
 FORMS += \
+    $$PWD/server_widgetsettingsruntime.ui \
     $$PWD/server_widgetsettingsscript.ui
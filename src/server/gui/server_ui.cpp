@@ -293,6 +293,21 @@ void mbServerUi::initialize()
     a->setVisible(true);
 
     mbCoreUi::initialize();
+
+    // status bar
+    // Note: impairment counters of the current port are shown only when its impairment is enabled
+    m_lbPortImpairmentName = new QLabel("Impairment: ", ui->statusbar);
+    m_lbPortImpairment = new QLabel("0/0/0", ui->statusbar);
+    m_lbPortImpairment->setFrameShape(QFrame::Panel);
+    m_lbPortImpairment->setFrameStyle(QFrame::Sunken);
+    m_lbPortImpairment->setAutoFillBackground(true);
+    m_lbPortImpairment->setMinimumWidth(70);
+    m_lbPortImpairment->setToolTip("Delayed/dropped/value corrupted requests of the current port");
+    ui->statusbar->addPermanentWidget(m_lbPortImpairmentName);
+    ui->statusbar->addPermanentWidget(m_lbPortImpairment);
+    // Note: connected after mbCoreUi::currentPortChanged which disconnects previous port from this
+    connect(m_projectUi, &mbCoreProjectUi::currentPortChanged, this, &mbServerUi::currentPortImpairmentChanged);
+    currentPortImpairmentChanged(projectUi()->currentPort());
 }
 
 MBSETTINGS mbServerUi::cachedSettings() const
@@ -1119,6 +1134,33 @@ void mbServerUi::setFormat(int format)
     }
 }
 
+void mbServerUi::currentPortImpairmentChanged(mbCorePort *port)
+{
+    if (mbServerPort *p = static_cast<mbServerPort*>(port))
+    {
+        connect(p, &mbServerPort::changed              , this, &mbServerUi::refreshPortImpairment);
+        connect(p, &mbServerPort::statImpairmentChanged, this, &mbServerUi::setStatImpairment    );
+    }
+    refreshPortImpairment();
+}
+
+void mbServerUi::refreshPortImpairment()
+{
+    mbServerPort *port = projectUi()->currentPort();
+    bool visible = port && port->impairment().isEnabled();
+    m_lbPortImpairmentName->setVisible(visible);
+    m_lbPortImpairment->setVisible(visible);
+    mbServerPort::ImpairmentStatistic stat;
+    if (port)
+        stat = port->statImpairment();
+    setStatImpairment(stat.delayed, stat.dropped, stat.corrupted);
+}
+
+void mbServerUi::setStatImpairment(quint32 delayed, quint32 dropped, quint32 corrupted)
+{
+    m_lbPortImpairment->setText(QString("%1/%2/%3").arg(delayed).arg(dropped).arg(corrupted));
+}
+
 void mbServerUi::editPort(mbCorePort *port)
 {
     if (core()->isRunning())
@@ -187,6 +187,9 @@ protected Q_SLOTS: // non menu slots
     void slotSimActionPaste();
     void slotSimActionSelectAll();
     void setFormat(int format);
+    void currentPortImpairmentChanged(mbCorePort *port);
+    void refreshPortImpairment();
+    void setStatImpairment(quint32 delayed, quint32 dropped, quint32 corrupted);
 
 private Q_SLOTS:
     void editPort(mbCorePort *port);
@@ -219,6 +222,9 @@ private:
     Ui::mbServerUi *ui;
     mb::DigitalFormat m_format;
     QComboBox *m_cmbFormat;
+    // Status bar
+    QLabel *m_lbPortImpairmentName;
+    QLabel *m_lbPortImpairment;
     // Output
     QDockWidget *m_dockOutput;
     mbServerOutputView *m_outputView;
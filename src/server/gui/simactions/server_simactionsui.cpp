@@ -25,6 +25,8 @@
 #include <QVBoxLayout>
 #include <QTableView>
 #include <QHeaderView>
+#include <QLabel>
+#include <QTimer>
 
 #include <server.h>
 
@@ -32,9 +34,14 @@
 #include <project/server_simaction.h>
 #include <project/server_device.h>
 
+#include <runtime/server_runtime.h>
+
 #include "server_simactionsmodel.h"
 #include "server_simactionsdelegate.h"
 
+// Period (milliseconds) of refresh of simulation statistic while server is running
+#define SIMACTIONS_STATISTIC_INTERVAL 1000
+
 mbServerSimActionsUi::mbServerSimActionsUi(QWidget *parent) : QWidget(parent)
 {
 
@@ -76,9 +83,18 @@ mbServerSimActionsUi::mbServerSimActionsUi(QWidget *parent) : QWidget(parent)
 
     m_view->setStyleSheet(headerStyleSheet);
 
+    // Note: statistic of running simulation is read from the runtime periodically
+    m_lbStatistic = new QLabel(this);
+    m_lbStatistic->setVisible(false);
+    m_timerStatistic = new QTimer(this);
+    m_timerStatistic->setInterval(SIMACTIONS_STATISTIC_INTERVAL);
+    connect(m_timerStatistic, &QTimer::timeout, this, &mbServerSimActionsUi::refreshStatistic);
+    connect(mbServer::global(), &mbServer::statusChanged, this, &mbServerSimActionsUi::statusChange);
+
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->setMargin(0);
     layout->addWidget(m_view);
+    layout->addWidget(m_lbStatistic);
 }
 
 QModelIndex mbServerSimActionsUi::currentItemModelIndex() const
@@ -148,3 +164,28 @@ void mbServerSimActionsUi::contextMenu(const QModelIndex &index)
     mbServerSimAction *simAction = m_model->simAction(index);
     Q_EMIT simActionContextMenu(simAction);
 }
+
+void mbServerSimActionsUi::statusChange(int status)
+{
+    if (status == mbServer::Running)
+    {
+        refreshStatistic();
+        m_lbStatistic->setVisible(true);
+        m_timerStatistic->start();
+    }
+    else
+    {
+        m_timerStatistic->stop();
+        m_lbStatistic->setVisible(false);
+    }
+}
+
+void mbServerSimActionsUi::refreshStatistic()
+{
+    mbServerRuntime::SimActionStatistic s = mbServer::global()->runtime()->simActionStatistic();
+    m_lbStatistic->setText(QString("Actions: %1, executions: %2, overruns: %3, max lateness: %4 ms")
+                               .arg(s.actions)
+                               .arg(s.execCount)
+                               .arg(s.overrunCount)
+                               .arg(s.maxLateness));
+}
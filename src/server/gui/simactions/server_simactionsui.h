@@ -27,6 +27,8 @@
 #include <QWidget>
 
 class QTableView;
+class QLabel;
+class QTimer;
 
 class mbServerSimAction;
 class mbServerSimActionsModel;
@@ -60,9 +62,13 @@ protected Q_SLOTS:
     void customContextMenu(const QPoint &pos);
     void doubleClick(const QModelIndex &index);
     void contextMenu(const QModelIndex &index);
+    void statusChange(int status);
+    void refreshStatistic();
 
 private:
     QTableView *m_view;
+    QLabel *m_lbStatistic;
+    QTimer *m_timerStatistic;
     mbServerSimActionsModel *m_model;
     mbServerSimActionsDelegate *m_delegate;
 };
@@ -28,7 +28,10 @@
     when setUnits-method with project incharge
 */
 
+#include <algorithm>
+
 #include <QSet>
+#include <QtEndian>
 
 mbServerDevice::Strings::Strings() :
     count0x               (QStringLiteral("count0x")),
@@ -37,8 +40,12 @@ mbServerDevice::Strings::Strings() :
     count4x               (QStringLiteral("count4x")),
     isSaveData            (QStringLiteral("isSaveData")),
     isReadOnly            (QStringLiteral("isReadOnly")),
+    isSparseMemory        (QStringLiteral("isSparseMemory")),
+    memoryAliases         (QStringLiteral("memoryAliases")),
     exceptionStatusAddress(QStringLiteral("exceptionStatusAddress")),
     delay                 (QStringLiteral("delay")),
+    delayJitter           (QStringLiteral("delayJitter")),
+    delayDistribution     (QStringLiteral("delayDistribution")),
     isEnableScript        (QStringLiteral("isEnableScript")),
     scriptInit            (QStringLiteral("scriptInit")),
     scriptLoop            (QStringLiteral("scriptLoop")),
@@ -63,8 +70,11 @@ mbServerDevice::Defaults::Defaults() :
     count4x(65536),
     isSaveData(false),
     isReadOnly(false),
+    isSparseMemory(false),
     exceptionStatusAddress(1),
     delay(0),
+    delayJitter(0),
+    delayDistribution(DelayUniform),
     isEnableScript(true)
 {
 }
@@ -75,32 +85,664 @@ const mbServerDevice::Defaults &mbServerDevice::Defaults::instance()
     return d;
 }
 
+mbServerDevice::MemoryPool *mbServerDevice::MemoryPool::global()
+{
+    static MemoryPool pool;
+    return &pool;
+}
+
+mbServerDevice::MemoryPool::MemoryPool()
+{
+    m_lock.clear();
+    m_used = 0;
+    m_reserved = 0;
+}
+
+mbServerDevice::MemoryPool::~MemoryPool()
+{
+    Q_FOREACH (quint8 *slab, m_slabs)
+        delete[] slab;
+}
+
+quint8 *mbServerDevice::MemoryPool::allocPage()
+{
+    while (m_lock.test_and_set(std::memory_order_acquire))
+        QThread::yieldCurrentThread();
+    if (m_free.isEmpty())
+    {
+        quint8 *slab = new quint8[SlabPages*PageBytes];
+        m_slabs.append(slab);
+        m_free.reserve(m_free.count()+SlabPages);
+        for (uint i = SlabPages; i > 0; i--)
+            m_free.append(slab + (i-1)*PageBytes);
+        m_reserved.fetch_add(SlabPages, std::memory_order_relaxed);
+    }
+    quint8 *page = m_free.takeLast();
+    m_lock.clear(std::memory_order_release);
+    m_used.fetch_add(1, std::memory_order_relaxed);
+    memset(page, 0, PageBytes);
+    return page;
+}
+
+void mbServerDevice::MemoryPool::releasePage(quint8 *page)
+{
+    while (m_lock.test_and_set(std::memory_order_acquire))
+        QThread::yieldCurrentThread();
+    m_free.append(page);
+    m_lock.clear(std::memory_order_release);
+    m_used.fetch_sub(1, std::memory_order_relaxed);
+}
+
+mbServerDevice::MemoryBlock::Buffer::~Buffer()
+{
+    releaseSparse(this);
+}
+
 mbServerDevice::MemoryBlock::MemoryBlock()
 {
-    m_sizeBits = 0;
+    m_writeLock.clear();
+    m_seq = 0;
     m_changeCounter = 0;
+    m_listener = nullptr;
+    m_changed = false;
+    m_changedRange = Range{0, 0};
+    m_sparse = false;
+    m_buffer = createBuffer(0, 0, false);
+}
+
+mbServerDevice::MemoryBlock::~MemoryBlock()
+{
+    delete m_buffer.load();
+    qDeleteAll(m_retired);
+}
+
+void mbServerDevice::MemoryBlock::lockWrite()
+{
+    if (m_lockOrder.isEmpty())
+    {
+        lockSingle();
+        return;
+    }
+    // Note: blocks are always locked in order of their addresses,
+    //       so writers of blocks that are aliased to each other can't deadlock
+    Q_FOREACH (MemoryBlock *m, m_lockOrder)
+        m->lockSingle();
+}
+
+void mbServerDevice::MemoryBlock::unlockWrite()
+{
+    Range changed;
+    if (m_lockOrder.isEmpty())
+    {
+        if (unlockSingle(&changed))
+            notifyChanged(changed, m_lockOrder);
+        return;
+    }
+    unlockBlocks(m_lockOrder.constData(), m_lockOrder.count(), m_lockOrder);
+}
+
+void mbServerDevice::MemoryBlock::unlockBlocks(MemoryBlock *const *blocks, int count, const QVector<MemoryBlock*> &writer)
+{
+    Range changed;
+    QVarLengthArray<QPair<MemoryBlock*, Range>, 8> changedBlocks;
+    for (int i = count-1; i >= 0; i--)
+    {
+        MemoryBlock *m = blocks[i];
+        if (m->unlockSingle(&changed))
+            changedBlocks.append(qMakePair(m, changed));
+    }
+    // Note: listeners and dependent blocks are notified when all locks are released
+    for (int i = 0; i < changedBlocks.count(); i++)
+        changedBlocks.at(i).first->notifyChanged(changedBlocks.at(i).second, writer);
+}
+
+mbServerDevice::MemoryBlock::TransferLocker::TransferLocker(MemoryBlock *dst, const MemoryBlock *src) :
+    m_dst(dst)
+{
+    MemoryBlock *const blocks[] = { dst, const_cast<MemoryBlock*>(src) };
+    for (MemoryBlock *m : blocks)
+    {
+        if (m->m_lockOrder.isEmpty())
+        {
+            if (!m_blocks.contains(m))
+                m_blocks.append(m);
+            continue;
+        }
+        Q_FOREACH (MemoryBlock *t, m->m_lockOrder)
+        {
+            if (!m_blocks.contains(t))
+                m_blocks.append(t);
+        }
+    }
+    // Note: same order as in 'lockWrite()'
+    std::sort(m_blocks.begin(), m_blocks.end());
+    for (int i = 0; i < m_blocks.count(); i++)
+        m_blocks.at(i)->lockSingle();
+}
+
+mbServerDevice::MemoryBlock::TransferLocker::~TransferLocker()
+{
+    // Note: only destination block (with its targets) is written,
+    //       so dependents of the source block must be notified as usual
+    unlockBlocks(m_blocks.constData(), m_blocks.count(), m_dst->m_lockOrder);
+}
+
+void mbServerDevice::MemoryBlock::lockSingle()
+{
+    while (m_writeLock.test_and_set(std::memory_order_acquire))
+        QThread::yieldCurrentThread();
+    m_seq.fetch_add(1, std::memory_order_relaxed); // Note: odd sequence means that memory is being changed
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+bool mbServerDevice::MemoryBlock::unlockSingle(Range *changed)
+{
+    bool r = m_changed;
+    *changed = m_changedRange;
+    m_changed = false;
+    m_seq.fetch_add(1, std::memory_order_release);
+    m_writeLock.clear(std::memory_order_release);
+    return r;
+}
+
+void mbServerDevice::MemoryBlock::notifyChanged(const Range &changed, const QVector<MemoryBlock*> &locked)
+{
+    if (Listener *listener = m_listener.load(std::memory_order_acquire))
+        listener->memoryChanged();
+    // Note: block that was locked together with this one has already marked its aliased range itself
+    Q_FOREACH (const Dependent &d, m_dependents)
+    {
+        if (locked.contains(d.block))
+            continue;
+        uint begin = qMax(changed.offset, d.targetOffset);
+        uint end = qMin(changed.offset + changed.count, d.targetOffset + d.count);
+        if (begin < end)
+            d.block->markAliasChanged(d.offset + (begin - d.targetOffset), end - begin);
+    }
+}
+
+void mbServerDevice::MemoryBlock::markAliasChanged(uint byteOffset, uint byteCount)
+{
+    WriteLocker _(this);
+    markChanged(m_buffer.load(std::memory_order_relaxed), byteOffset, byteCount);
+}
+
+mbServerDevice::MemoryBlock::Buffer *mbServerDevice::MemoryBlock::createBuffer(uint bytes, uint bits, bool sparse)
+{
+    Buffer *n = new Buffer;
+    n->size = bytes;
+    n->sizeBits = bits;
+    n->isSparse = sparse;
+    if (sparse)
+        n->sparsePages.fill(nullptr, static_cast<int>((bytes+MemoryPool::PageBytes-1)/MemoryPool::PageBytes));
+    else
+        n->data = QByteArray(static_cast<int>(bytes), '\0');
+    n->pages.resize((bytes+PageBytes-1)/PageBytes);
+    return n;
+}
+
+void mbServerDevice::MemoryBlock::releaseSparse(Buffer *b)
+{
+    if (b->sparseCount == 0)
+        return;
+    MemoryPool *pool = MemoryPool::global();
+    quint8 **pages = b->sparsePages.data();
+    for (int i = 0; i < b->sparsePages.count(); i++)
+    {
+        if (pages[i])
+        {
+            pool->releasePage(pages[i]);
+            pages[i] = nullptr;
+        }
+    }
+    b->sparseCount = 0;
+}
+
+void mbServerDevice::MemoryBlock::resizeBuffer(int bytes, uint bits)
+{
+    Buffer *n = createBuffer(static_cast<uint>(bytes), bits, m_sparse);
+    WriteLocker _(this);
+    retireBuffer(m_buffer.load(std::memory_order_relaxed));
+    markChanged(n, 0, static_cast<uint>(bytes));
+    m_buffer.store(n, std::memory_order_release);
+}
+
+void mbServerDevice::MemoryBlock::retireBuffer(Buffer *b)
+{
+    // Note: reader may still use previous buffer, so it's retired instead of deletion.
+    //       Pages of sparse buffer are returned to the pool at once: they are never freed by the pool,
+    //       so reader can still access them and it repeats reading because memory sequence was changed
+    releaseSparse(b);
+    m_retired.append(b);
+}
+
+void mbServerDevice::MemoryBlock::markChanged(Buffer *b, uint byteOffset, uint byteCount)
+{
+    uint gen = m_changeCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (byteCount == 0)
+    {
+        m_changed = true;
+        return;
+    }
+    if (m_changed)
+    {
+        uint end = qMax(m_changedRange.offset + m_changedRange.count, byteOffset + byteCount);
+        m_changedRange.offset = qMin(m_changedRange.offset, byteOffset);
+        m_changedRange.count = end - m_changedRange.offset;
+    }
+    else
+        m_changedRange = Range{byteOffset, byteCount};
+    m_changed = true;
+    uint last = (byteOffset+byteCount-1)/PageBytes;
+    if (last >= static_cast<uint>(b->pages.size()))
+        last = b->pages.size()-1;
+    uint *pages = b->pages.data();
+    for (uint i = byteOffset/PageBytes; i <= last; i++)
+        pages[i] = gen;
+}
+
+void mbServerDevice::MemoryBlock::bufferCopyTo(const Buffer *b, uint offset, uint count, void *dst)
+{
+    quint8 *d = reinterpret_cast<quint8*>(dst);
+    if (!b->isSparse)
+    {
+        memcpy(d, b->data.constData()+offset, count);
+        return;
+    }
+    quint8 *const *pages = b->sparsePages.constData();
+    while (count)
+    {
+        uint o = offset % MemoryPool::PageBytes;
+        uint c = qMin(count, MemoryPool::PageBytes - o);
+        const quint8 *page = pages[offset / MemoryPool::PageBytes]; // Note: pointer is read once, writer can change it
+        if (page)
+            memcpy(d, page+o, c);
+        else
+            memset(d, 0, c);
+        d += c;
+        offset += c;
+        count -= c;
+    }
+}
+
+void mbServerDevice::MemoryBlock::bufferCopyFrom(Buffer *b, uint offset, uint count, const void *src)
+{
+    const quint8 *s = reinterpret_cast<const quint8*>(src);
+    if (!b->isSparse)
+    {
+        memcpy(b->data.data()+offset, s, count);
+        return;
+    }
+    quint8 **pages = b->sparsePages.data();
+    while (count)
+    {
+        uint i = offset / MemoryPool::PageBytes;
+        uint o = offset % MemoryPool::PageBytes;
+        uint c = qMin(count, MemoryPool::PageBytes - o);
+        quint8 *page = pages[i];
+        if (!page)
+        {
+            // Note: page is not allocated while only zeros are written into it
+            uint k = 0;
+            while ((k < c) && (s[k] == 0))
+                ++k;
+            if (k < c)
+            {
+                page = MemoryPool::global()->allocPage();
+                pages[i] = page;
+                ++b->sparseCount;
+            }
+        }
+        if (page)
+            memcpy(page+o, s, c);
+        s += c;
+        offset += c;
+        count -= c;
+    }
+}
+
+void mbServerDevice::MemoryBlock::copyTo(const Buffer *b, uint offset, uint count, void *dst, bool locked) const
+{
+    quint8 *d = reinterpret_cast<quint8*>(dst);
+    for (int i = 0; (i < m_aliases.count()) && count; i++)
+    {
+        const Alias &a = m_aliases.at(i);
+        if ((a.offset + a.count) <= offset)
+            continue;
+        if (a.offset > offset)
+        {
+            uint c = qMin(count, a.offset - offset);
+            bufferCopyTo(b, offset, c, d);
+            d += c;
+            offset += c;
+            count -= c;
+            if (count == 0)
+                break;
+        }
+        uint c = qMin(count, a.offset + a.count - offset);
+        uint t = a.targetOffset + (offset - a.offset);
+        if (locked)
+            bufferCopyTo(a.target->m_buffer.load(std::memory_order_relaxed), t, c, d);
+        else
+            a.target->readAlias(t, c, d);
+        d += c;
+        offset += c;
+        count -= c;
+    }
+    if (count)
+        bufferCopyTo(b, offset, count, d);
+}
+
+void mbServerDevice::MemoryBlock::copyFrom(Buffer *b, uint offset, uint count, const void *src)
+{
+    const quint8 *s = reinterpret_cast<const quint8*>(src);
+    for (int i = 0; (i < m_aliases.count()) && count; i++)
+    {
+        const Alias &a = m_aliases.at(i);
+        if ((a.offset + a.count) <= offset)
+            continue;
+        if (a.offset > offset)
+        {
+            uint c = qMin(count, a.offset - offset);
+            bufferCopyFrom(b, offset, c, s);
+            s += c;
+            offset += c;
+            count -= c;
+            if (count == 0)
+                break;
+        }
+        uint c = qMin(count, a.offset + a.count - offset);
+        uint t = a.targetOffset + (offset - a.offset);
+        Buffer *tb = a.target->m_buffer.load(std::memory_order_relaxed); // Note: target is locked together with this block
+        bufferCopyFrom(tb, t, c, s);
+        a.target->markChanged(tb, t, c);
+        s += c;
+        offset += c;
+        count -= c;
+    }
+    if (count)
+        bufferCopyFrom(b, offset, count, s);
+}
+
+void mbServerDevice::MemoryBlock::readAlias(uint offset, uint count, void *dst) const
+{
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        // Note: target range is checked when alias is set, target can't be resized while alias exists
+        bufferCopyTo(m_buffer.load(std::memory_order_acquire), offset, count, dst);
+    }
+    while (readRetry(seq));
+}
+
+bool mbServerDevice::MemoryBlock::isAliased(uint offset, uint count) const
+{
+    for (int i = 0; i < m_aliases.count(); i++)
+    {
+        const Alias &a = m_aliases.at(i);
+        if ((a.offset < (offset + count)) && (offset < (a.offset + a.count)))
+            return true;
+    }
+    return false;
+}
+
+const quint8 *mbServerDevice::MemoryBlock::readPtr(const Buffer *b, uint offset, uint count, Temp_t &temp, bool locked) const
+{
+    if (!b->isSparse && !isAliased(offset, count))
+        return reinterpret_cast<const quint8*>(b->data.constData())+offset; // Note: QByteArray has terminating zero byte
+    uint c = qMin(count, b->size - offset);
+    temp.resize(static_cast<int>(count+1));
+    copyTo(b, offset, c, temp.data(), locked);
+    memset(temp.data()+c, 0, count+1-c);
+    return temp.constData();
+}
+
+quint8 *mbServerDevice::MemoryBlock::writePtr(Buffer *b, uint offset, uint count, Temp_t &temp)
+{
+    if (!b->isSparse && !isAliased(offset, count))
+        return reinterpret_cast<quint8*>(b->data.data())+offset;
+    uint c = qMin(count, b->size - offset);
+    temp.resize(static_cast<int>(count+1));
+    copyTo(b, offset, c, temp.data(), true);
+    memset(temp.data()+c, 0, count+1-c);
+    return temp.data();
+}
+
+void mbServerDevice::MemoryBlock::writeCommit(Buffer *b, uint offset, uint count, const quint8 *data)
+{
+    if (b->isSparse || isAliased(offset, count))
+        copyFrom(b, offset, qMin(count, b->size - offset), data);
+}
+
+// Note: 8 bools are processed as single 64-bit word (byte 'i' of the word is bool 'i'),
+//       multiplication and masks below move every bit into its byte and back without branches
+static inline quint64 bitsToBools8(quint8 bits)
+{
+    quint64 v = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL; // bit 'i' is kept in byte 'i'
+    return ((v + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+}
+
+static inline quint8 boolsToBits8(quint64 bools)
+{
+    // Note: any nonzero byte is true
+    quint64 v = ((((bools & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | bools) >> 7) & 0x0101010101010101ULL;
+    return static_cast<quint8>((v * 0x0102040810204080ULL) >> 56);
+}
+
+void mbServerDevice::MemoryBlock::bitsExtract(quint8 *dst, const quint8 *src, uint srcShift, uint bitCount)
+{
+    const uint bytes = bitCount / MB_BYTE_SZ_BITES;
+    const uint resid = bitCount % MB_BYTE_SZ_BITES;
+    uint i = 0;
+    if (srcShift == 0)
+    {
+        memcpy(dst, src, bytes);
+        if (resid)
+            dst[bytes] = src[bytes] & static_cast<quint8>((1u << resid) - 1);
+        return;
+    }
+    // Note: every 8 bytes of 'dst' are made of 9 bytes of 'src',
+    //       next byte of 'src' always exists because of the shift or extra byte after the range
+    for (; (i + sizeof(quint64)) <= bytes; i += sizeof(quint64))
+    {
+        quint64 v = qFromLittleEndian<quint64>(src+i) >> srcShift;
+        v |= static_cast<quint64>(src[i+sizeof(quint64)]) << (64 - srcShift);
+        qToLittleEndian<quint64>(v, dst+i);
+    }
+    for (; i < bytes; i++)
+        dst[i] = static_cast<quint8>((src[i] >> srcShift) | (src[i+1] << (MB_BYTE_SZ_BITES - srcShift)));
+    if (resid)
+    {
+        quint8 v = static_cast<quint8>((src[bytes] >> srcShift) | (src[bytes+1] << (MB_BYTE_SZ_BITES - srcShift)));
+        dst[bytes] = v & static_cast<quint8>((1u << resid) - 1);
+    }
+}
+
+void mbServerDevice::MemoryBlock::bitsInsert(quint8 *dst, uint dstShift, const quint8 *src, uint bitCount)
+{
+    const uint bytes = bitCount / MB_BYTE_SZ_BITES;
+    const uint resid = bitCount % MB_BYTE_SZ_BITES;
+    uint i = 0;
+    if (dstShift == 0)
+    {
+        memcpy(dst, src, bytes);
+        if (resid)
+        {
+            quint8 mask = static_cast<quint8>((1u << resid) - 1);
+            dst[bytes] = (dst[bytes] & ~mask) | (src[bytes] & mask);
+        }
+        return;
+    }
+    // Note: 'carry' keeps 'dstShift' bits that are put into the low part of the next byte
+    quint64 carry = dst[0] & ((1u << dstShift) - 1);
+    for (; (i + sizeof(quint64)) <= bytes; i += sizeof(quint64))
+    {
+        quint64 s = qFromLittleEndian<quint64>(src+i);
+        qToLittleEndian<quint64>((s << dstShift) | carry, dst+i);
+        carry = s >> (64 - dstShift);
+    }
+    for (; i < bytes; i++)
+    {
+        dst[i] = static_cast<quint8>((src[i] << dstShift) | carry);
+        carry = src[i] >> (MB_BYTE_SZ_BITES - dstShift);
+    }
+    // Note: last 'dstShift + resid' bits can take 2 bytes
+    uint n = dstShift + resid;
+    quint16 v = static_cast<quint16>(carry | (static_cast<quint16>(resid ? (src[bytes] & ((1u << resid) - 1)) : 0) << dstShift));
+    quint16 mask = static_cast<quint16>((1u << n) - 1);
+    dst[bytes] = static_cast<quint8>((dst[bytes] & ~mask) | (v & mask));
+    if (n > MB_BYTE_SZ_BITES)
+        dst[bytes+1] = static_cast<quint8>((dst[bytes+1] & ~(mask >> MB_BYTE_SZ_BITES)) | (v >> MB_BYTE_SZ_BITES));
+}
+
+mbServerDevice::MemoryBlock::Ranges_t mbServerDevice::MemoryBlock::changedRanges(uint generation, uint *current) const
+{
+    Ranges_t r;
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        r.clear();
+        const Buffer *b = m_buffer.load(std::memory_order_acquire);
+        if (current)
+            *current = m_changeCounter.load(std::memory_order_relaxed);
+        const uint *pages = b->pages.constData();
+        uint size = b->size;
+        uint count = static_cast<uint>(b->pages.size());
+        for (uint i = 0; i < count; i++)
+        {
+            // Note: difference is used instead of comparison to process wrap of generation counter
+            if (static_cast<int>(pages[i] - generation) <= 0)
+                continue;
+            uint offset = i * PageBytes;
+            uint c = PageBytes;
+            if ((offset + c) > size)
+                c = size - offset;
+            if (r.count() && (r.last().offset + r.last().count == offset))
+                r.last().count += c;
+            else
+                r.append(Range{offset, c});
+        }
+    }
+    while (readRetry(seq));
+    return r;
 }
 
 void mbServerDevice::MemoryBlock::resize(int bytes)
 {
-    QWriteLocker _(&m_lock);
-    m_data.resize(bytes);
-    memset(m_data.data(), 0, m_data.size());
-    m_sizeBits = m_data.size() * MB_BYTE_SZ_BITES;
+    resizeBuffer(bytes, static_cast<uint>(bytes * MB_BYTE_SZ_BITES));
 }
 
 void mbServerDevice::MemoryBlock::resizeBits(int bits)
 {
-    QWriteLocker _(&m_lock);
-    m_data.resize((bits+7)/8);
-    memset(m_data.data(), 0, m_data.size());
-    m_sizeBits = bits;
+    resizeBuffer((bits+7)/8, static_cast<uint>(bits));
+}
+
+void mbServerDevice::MemoryBlock::setSparse(bool sparse)
+{
+    if (m_sparse == sparse)
+        return;
+    m_sparse = sparse;
+    WriteLocker _(this);
+    Buffer *o = m_buffer.load(std::memory_order_relaxed);
+    Buffer *n = createBuffer(o->size, o->sizeBits, sparse);
+    if (sparse)
+        bufferCopyFrom(n, 0, o->size, o->data.constData());
+    else
+        bufferCopyTo(o, 0, o->size, n->data.data());
+    n->pages = o->pages; // Note: content is not changed, so change generations are kept
+    retireBuffer(o);
+    m_buffer.store(n, std::memory_order_release);
+}
+
+size_t mbServerDevice::MemoryBlock::memoryUsage() const
+{
+    size_t r;
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        const Buffer *b = m_buffer.load(std::memory_order_acquire);
+        r = sizeof(Buffer) + static_cast<size_t>(b->pages.size()) * sizeof(uint);
+        if (b->isSparse)
+            r += static_cast<size_t>(b->sparseCount) * MemoryPool::PageBytes + static_cast<size_t>(b->sparsePages.size()) * sizeof(quint8*);
+        else
+            r += b->size;
+    }
+    while (readRetry(seq));
+    return r;
+}
+
+void mbServerDevice::MemoryBlock::releaseRetired()
+{
+    WriteLocker _(this);
+    qDeleteAll(m_retired);
+    m_retired.clear();
+}
+
+void mbServerDevice::MemoryBlock::setAliases(const Aliases_t &aliases)
+{
+    clearAliases();
+    m_aliases = aliases;
+    m_lockOrder.append(this);
+    Q_FOREACH (const Alias &a, m_aliases)
+    {
+        a.target->m_dependents.append(Dependent{this, a.offset, a.targetOffset, a.count});
+        if (!m_lockOrder.contains(a.target))
+            m_lockOrder.append(a.target);
+    }
+    std::sort(m_lockOrder.begin(), m_lockOrder.end());
+    // Note: own memory of aliased ranges is not used anymore, so it's marked changed to be refreshed by viewers
+    WriteLocker _(this);
+    Q_FOREACH (const Alias &a, m_aliases)
+        markChanged(m_buffer.load(std::memory_order_relaxed), a.offset, a.count);
+}
+
+void mbServerDevice::MemoryBlock::clearAliases()
+{
+    if (m_aliases.isEmpty())
+        return;
+    Aliases_t aliases = m_aliases;
+    QVector<QByteArray> data;
+    Q_FOREACH (const Alias &a, aliases)
+    {
+        QByteArray v(static_cast<int>(a.count), '\0');
+        a.target->readAlias(a.targetOffset, a.count, v.data());
+        data.append(v);
+        QVector<Dependent> &deps = a.target->m_dependents;
+        for (int i = deps.count()-1; i >= 0; i--)
+        {
+            if (deps.at(i).block == this)
+                deps.remove(i);
+        }
+    }
+    m_aliases.clear();
+    m_lockOrder.clear();
+    WriteLocker _(this);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
+    for (int i = 0; i < aliases.count(); i++)
+    {
+        bufferCopyFrom(b, aliases.at(i).offset, aliases.at(i).count, data.at(i).constData());
+        markChanged(b, aliases.at(i).offset, aliases.at(i).count);
+    }
 }
 
 void mbServerDevice::MemoryBlock::memGet(uint byteOffset, void *buff, size_t size)
 {
-    QReadLocker _(&m_lock);
-    memcpy(buff, m_data.data()+byteOffset, size);
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        const Buffer *b = m_buffer.load(std::memory_order_acquire);
+        size_t n = size;
+        if (byteOffset >= b->size)
+            return;
+        if ((byteOffset + size) > b->size)
+            n = b->size - byteOffset;
+        copyTo(b, byteOffset, static_cast<uint>(n), buff, false);
+    }
+    while (readRetry(seq));
 }
 
 void mbServerDevice::MemoryBlock::memSetMask(uint byteOffset, const void *buff, const void *mask, size_t size)
@@ -109,13 +751,18 @@ void mbServerDevice::MemoryBlock::memSetMask(uint byteOffset, const void *buff,
 
     size_t n = size;
 
-    QWriteLocker _(&m_lock);
-    if (byteOffset >= m_data.size())
+    WriteLocker _(this);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
+    if (byteOffset >= b->size)
         return;
-    if ((byteOffset + size) > m_data.size())
-        n = m_data.size() - byteOffset;
-
-    quint8 *membyte = reinterpret_cast<quint8*>(m_data.data())+byteOffset;
+    if ((byteOffset + size) > b->size)
+        n = b->size - byteOffset;
+    markChanged(b, byteOffset, static_cast<uint>(n));
+
+    Temp_t temp;
+    quint8 *mem = writePtr(b, byteOffset, static_cast<uint>(n), temp);
+    const uint count = static_cast<uint>(n);
+    quint8 *membyte = mem;
     const quint8 *bufbyte = reinterpret_cast<const quint8*>(buff);
     const quint8 *mskbyte = reinterpret_cast<const quint8*>(mask);
 
@@ -156,29 +803,31 @@ void mbServerDevice::MemoryBlock::memSetMask(uint byteOffset, const void *buff,
         ++bufbyte;
         --n;
     }
-
-    m_changeCounter++;
+    writeCommit(b, byteOffset, count, mem);
 }
 
 void mbServerDevice::MemoryBlock::zerroAll()
 {
-    QWriteLocker _(&m_lock);
-    m_changeCounter++;
-    memset(m_data.data(), 0, m_data.size());
+    WriteLocker _(this);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
+    markChanged(b, 0, b->size);
+    if (b->isSparse)
+        releaseSparse(b); // Note: see 'retireBuffer()' about readers of released pages
+    else
+        memset(b->data.data(), 0, b->data.size());
 }
 
-Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, void *buff, uint *fact) const
+Modbus::StatusCode mbServerDevice::MemoryBlock::readInner(const Buffer *b, uint offset, uint count, void *buff, uint *fact) const
 {
-    QReadLocker _(&m_lock);
     uint c;
-    if (offset >= static_cast<uint>(static_cast<uint>(m_data.size())))
+    if (offset >= b->size)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(static_cast<uint>(m_data.size())) - offset;
+    if ((offset+count) > b->size)
+        c = b->size - offset;
     else
         c = count;
-    memcpy(buff, m_data.data()+offset, c);
+    copyTo(b, offset, c, buff, false);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -186,70 +835,45 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, vo
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::write(uint offset, uint count, const void *buff, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
+    return writeInner(m_buffer.load(std::memory_order_relaxed), offset, count, buff, fact);
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::writeInner(Buffer *b, uint offset, uint count, const void *buff, uint *fact)
+{
     uint c;
-    if (offset >= static_cast<uint>(m_data.size()))
+    if (offset >= b->size)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(m_data.size()) - offset;
+    if ((offset+count) > b->size)
+        c = b->size - offset;
     else
         c = count;
     if (c == 0)
         return Modbus::Status_BadIllegalDataAddress;
-    memcpy(m_data.data()+offset, buff, c);
-    m_changeCounter++;
+    copyFrom(b, offset, c, buff);
+    markChanged(b, offset, c);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
 }
 
-Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bitCount, void *buff, uint *fact) const
+Modbus::StatusCode mbServerDevice::MemoryBlock::readBitsInner(const Buffer *b, uint bitOffset, uint bitCount, void *buff, uint *fact) const
 {
-    QReadLocker _(&m_lock);
     uint c;
-    if (bitOffset >= m_sizeBits)
+    if (bitOffset >= b->sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
+    if ((bitOffset+bitCount) > b->sizeBits)
+        c = b->sizeBits - bitOffset;
     else
         c = bitCount;
 
     uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
-    uint bytes = c/MB_BYTE_SZ_BITES;
     uint shift = bitOffset%MB_BYTE_SZ_BITES;
-    const quint8 *mem = reinterpret_cast<const quint8*>(m_data.data());
-    if (shift)
-    {
-        for (uint i = 0; i < bytes; i++)
-        {
-            quint16 v = *(reinterpret_cast<const quint16*>(&mem[byteOffset+i])) >> shift; // no need to check (i+1) < bytes because if (shift > 0) then target bits are located in both nearest bytes (i) and (i+1)
-            reinterpret_cast<quint8*>(buff)[i] = static_cast<quint8>(v);
-        }
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
-        {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = ~(mask>>(7-resid));
-            if ((shift+resid) > MB_BYTE_SZ_BITES)
-            {
-                quint16 v = ((*reinterpret_cast<const quint16*>(&mem[byteOffset+bytes])) >> shift) & mask;
-                reinterpret_cast<quint8*>(buff)[bytes] = static_cast<quint8>(v);
-            }
-            else
-                reinterpret_cast<quint8*>(buff)[bytes] = (mem[byteOffset+bytes]>>shift) & mask;
-        }
-    }
-    else
-    {
-        memcpy(buff, &mem[byteOffset], static_cast<size_t>(bytes));
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
-        {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = ~(mask>>(7-resid));
-            reinterpret_cast<quint8*>(buff)[bytes] = mem[byteOffset+bytes] & mask;
-        }
-    }
+    Temp_t temp;
+    const quint8 *mem = readPtr(b, byteOffset, (shift+c+7)/MB_BYTE_SZ_BITES, temp);
+    bitsExtract(reinterpret_cast<quint8*>(buff), mem, shift, c);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -257,92 +881,57 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bi
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint bitCount, const void *buff, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
     uint c;
-    if (bitOffset >= m_sizeBits)
+    if (bitOffset >= b->sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
+    if ((bitOffset+bitCount) > b->sizeBits)
+        c = b->sizeBits - bitOffset;
     else
         c = bitCount;
     if (c == 0)
         return Modbus::Status_BadIllegalDataAddress;
     uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
-    uint bytes = c/MB_BYTE_SZ_BITES;
     uint shift = bitOffset%MB_BYTE_SZ_BITES;
-    quint8 *mem = reinterpret_cast<quint8*>(m_data.data());
-    if (shift)
-    {
-        for (uint i = 0; i < bytes; i++)
-        {
-            quint16 mask = static_cast<quint16>(0x00FF) << shift;
-            quint16 v = static_cast<quint16>(reinterpret_cast<const quint8*>(buff)[i]) << shift; // no need to check (i+1) < bytes because if (shift > 0) then target bits are located in both nearest bytes (i) and (i+1)
-            *reinterpret_cast<quint16*>(&mem[byteOffset+i]) &= ~mask; // zero undermask buff
-            *reinterpret_cast<quint16*>(&mem[byteOffset+i]) |= v; // set bit values
-        }
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
-        {
-            if ((shift+resid) > MB_BYTE_SZ_BITES)
-            {
-                qint16 m = static_cast<qint16>(0x8000); // using signed mask for right shift filled by '1'-bit
-                m = m>>(resid-1);
-                quint16 mask = *reinterpret_cast<quint16*>(&m);
-                mask = mask >> (MB_REGE_SZ_BITES-resid-shift);
-                quint16 v = (static_cast<quint16>(reinterpret_cast<const quint8*>(buff)[bytes]) << shift) & mask;
-                *reinterpret_cast<quint16*>(&mem[byteOffset+bytes]) &= ~mask; // zero undermask buff
-                *reinterpret_cast<quint16*>(&mem[byteOffset+bytes]) |= v;
-            }
-            else
-            {
-                qint8 m = static_cast<qint8>(0x80); // using signed mask for right shift filled by '1'-bit
-                m = m>>(resid-1);
-                quint8 mask = *reinterpret_cast<quint8*>(&m);
-                mask = mask >> (MB_BYTE_SZ_BITES-resid-shift);
-                quint8 v = (reinterpret_cast<const quint8*>(buff)[bytes] << shift) & mask;
-                mem[byteOffset+bytes] &= ~mask; // zero undermask buff
-                mem[byteOffset+bytes] |= v;
-            }
-        }
-    }
-    else
-    {
-        memcpy(&mem[byteOffset], buff, static_cast<size_t>(bytes));
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
-        {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = mask>>(7-resid);
-            mem[byteOffset+bytes] &= mask;
-            mask = ~mask;
-            mem[byteOffset+bytes] |= (reinterpret_cast<const quint8*>(buff)[bytes] & mask);
-        }
-    }
-    m_changeCounter++;
+    uint byteCount = (shift+c+7)/MB_BYTE_SZ_BITES;
+    Temp_t temp;
+    quint8 *mem = writePtr(b, byteOffset, byteCount, temp);
+    bitsInsert(mem, shift, reinterpret_cast<const quint8*>(buff), c);
+    writeCommit(b, byteOffset, byteCount, mem);
+    markChanged(b, byteOffset, byteCount);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
 }
 
-Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint bitCount, bool *values, uint *fact) const
+Modbus::StatusCode mbServerDevice::MemoryBlock::readBoolsInner(const Buffer *b, uint bitOffset, uint bitCount, bool *values, uint *fact) const
 {
-    QReadLocker _(&m_lock);
     uint c;
-    if (bitOffset >= m_sizeBits)
+    if (bitOffset >= b->sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
+    if ((bitOffset+bitCount) > b->sizeBits)
+        c = b->sizeBits - bitOffset;
     else
         c = bitCount;
     uint byte = bitOffset / MB_BYTE_SZ_BITES;
     uint bit  = bitOffset % MB_BYTE_SZ_BITES;
-    const quint8 *mem = reinterpret_cast<const quint8*>(m_data.data());
-    for (uint by = byte, i = 0; i < c; by++)
+    Temp_t temp;
+    const quint8 *mem = readPtr(b, byte, (bit+c+7)/MB_BYTE_SZ_BITES, temp);
+    uint i = 0;
+    // Note: head and tail of the range are processed bit by bit, whole bytes are unpacked into 8 bools at once
+    for (; (bit != 0) && (bit < MB_BYTE_SZ_BITES) && (i < c); bit++, i++)
+        values[i] = (mem[0] & (1<<bit)) != 0;
+    uint by = (bit != 0) ? 1 : 0;
+    for (; (i + MB_BYTE_SZ_BITES) <= c; i += MB_BYTE_SZ_BITES, by++)
     {
-        for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
-            values[i] = (mem[by] & (1<<bi)) != 0;
-        bit = 0;
+        quint64 v = bitsToBools8(mem[by]);
+        memcpy(values+i, &v, sizeof(v));
     }
+    for (uint bi = 0; i < c; bi++, i++)
+        values[i] = (mem[by] & (1<<bi)) != 0;
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -350,35 +939,94 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint b
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeBools(uint bitOffset, uint bitCount, const bool *values, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    WriteLocker _(this);
+    return writeBoolsInner(m_buffer.load(std::memory_order_relaxed), bitOffset, bitCount, values, fact);
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::writeBoolsInner(Buffer *b, uint bitOffset, uint bitCount, const bool *values, uint *fact)
+{
     uint c;
-    if (bitOffset >= m_sizeBits)
+    if (bitOffset >= b->sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
+    if ((bitOffset+bitCount) > b->sizeBits)
+        c = b->sizeBits - bitOffset;
     else
         c = bitCount;
     uint byte = bitOffset / MB_BYTE_SZ_BITES;
     uint bit  = bitOffset % MB_BYTE_SZ_BITES;
-    quint8 *mem = reinterpret_cast<quint8*>(m_data.data());
-    for (uint by = byte, i = 0; i < c; by++)
+    uint byteCount = (bit+c+7)/MB_BYTE_SZ_BITES;
+    Temp_t temp;
+    quint8 *mem = writePtr(b, byte, byteCount, temp);
+    uint i = 0;
+    // Note: head and tail of the range are processed bit by bit, whole bytes are packed from 8 bools at once
+    for (; (bit != 0) && (bit < MB_BYTE_SZ_BITES) && (i < c); bit++, i++)
     {
-        for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
-        {
-            if (values[i])
-                mem[by] |= (1<<bi);
-            else
-                mem[by] &= ~(1<<bi);
-        }
-        bit = 0;
+        if (values[i])
+            mem[0] |= (1<<bit);
+        else
+            mem[0] &= ~(1<<bit);
+    }
+    uint by = (bit != 0) ? 1 : 0;
+    for (; (i + MB_BYTE_SZ_BITES) <= c; i += MB_BYTE_SZ_BITES, by++)
+    {
+        quint64 v;
+        memcpy(&v, values+i, sizeof(v));
+        mem[by] = boolsToBits8(v);
+    }
+    for (uint bi = 0; i < c; bi++, i++)
+    {
+        if (values[i])
+            mem[by] |= (1<<bi);
+        else
+            mem[by] &= ~(1<<bi);
     }
-    m_changeCounter++;
+    writeCommit(b, byte, byteCount, mem);
+    markChanged(b, byte, byteCount);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
 }
 
+Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, void *values, uint *fact) const
+{
+    Modbus::StatusCode r;
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        r = readInner(m_buffer.load(std::memory_order_acquire), offset, count, values, fact);
+    }
+    while (readRetry(seq));
+    return r;
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bitCount, void *values, uint *fact) const
+{
+    Modbus::StatusCode r;
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        r = readBitsInner(m_buffer.load(std::memory_order_acquire), bitOffset, bitCount, values, fact);
+    }
+    while (readRetry(seq));
+    return r;
+}
+
+Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint bitCount, bool *values, uint *fact) const
+{
+    Modbus::StatusCode r;
+    uint seq;
+    do
+    {
+        seq = readBegin();
+        r = readBoolsInner(m_buffer.load(std::memory_order_acquire), bitOffset, bitCount, values, fact);
+    }
+    while (readRetry(seq));
+    return r;
+}
+
 Modbus::StatusCode mbServerDevice::MemoryBlock::readRegs(uint regOffset, uint regCount, quint16 *buff, uint *fact) const
 {
     uint offset = regOffset * MB_REGE_SZ_BYTES;
@@ -405,78 +1053,151 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeRegs(uint regOffset, uint r
     return r;
 }
 
+Modbus::StatusCode mbServerDevice::MemoryBlock::copyBits(uint bitOffset, const MemoryBlock *src, uint srcBitOffset, uint bitCount, uint *fact,
+                                                         uint rows, uint stride, uint srcStride)
+{
+    TransferLocker _(this, src);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
+    const Buffer *sb = src->m_buffer.load(std::memory_order_relaxed);
+    if ((bitOffset >= b->sizeBits) || (srcBitOffset >= sb->sizeBits) || (rows == 0))
+        return Modbus::Status_BadIllegalDataAddress;
+    uint c = qMin(bitCount, qMin(b->sizeBits - bitOffset, sb->sizeBits - srcBitOffset));
+    if (c == 0)
+        return Modbus::Status_BadIllegalDataAddress;
+    // Note: rows that are out of memory of any block are not copied
+    uint n = 1;
+    while ((n < rows) && ((bitOffset    + n*stride    + c) <= b->sizeBits ) &&
+                         ((srcBitOffset + n*srcStride + c) <= sb->sizeBits))
+        ++n;
+
+    const uint rowBytes = (c + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES;
+    Temp_t bits;
+    Temp_t temp;
+    const quint8 *rowsData;
+    uint srcShift = srcBitOffset % MB_BYTE_SZ_BITES;
+    if ((n == 1) && (srcShift == 0) && (src != this))
+    {
+        // Note: source can't share memory with destination window, so it's used as is
+        rowsData = src->readPtr(sb, srcBitOffset / MB_BYTE_SZ_BITES, rowBytes, temp, true);
+    }
+    else
+    {
+        // Note: all source rows are gathered before writing, so overlapped ranges of the same block are copied correctly
+        bits.resize(static_cast<int>(n * rowBytes));
+        for (uint r = 0; r < n; r++)
+        {
+            uint offset = srcBitOffset + r*srcStride;
+            uint shift = offset % MB_BYTE_SZ_BITES;
+            const quint8 *s = src->readPtr(sb, offset / MB_BYTE_SZ_BITES, (shift + c + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES, temp, true);
+            bitsExtract(bits.data() + r*rowBytes, s, shift, c);
+        }
+        rowsData = bits.constData();
+    }
+    for (uint r = 0; r < n; r++)
+    {
+        uint offset = bitOffset + r*stride;
+        uint byteOffset = offset / MB_BYTE_SZ_BITES;
+        uint shift = offset % MB_BYTE_SZ_BITES;
+        uint byteCount = (shift + c + MB_BYTE_SZ_BITES - 1) / MB_BYTE_SZ_BITES;
+        Temp_t wtemp;
+        quint8 *mem = writePtr(b, byteOffset, byteCount, wtemp);
+        bitsInsert(mem, shift, rowsData + r*rowBytes, c);
+        writeCommit(b, byteOffset, byteCount, mem);
+        markChanged(b, byteOffset, byteCount);
+    }
+    if (fact)
+        *fact = c;
+    return Modbus::Status_Good;
+}
+
 Modbus::StatusCode mbServerDevice::MemoryBlock::readFrameBools(uint bitOffset, int columns, QByteArray &values, uint maxColumns) const
 {
-    // TODO: make it single operation without 'readBools' call
     bool *v = reinterpret_cast<bool*>(values.data());
-    int c = values.count();
-    int offset = bitOffset;
-    int i = 0;
-    // read memory frame line by line
-    while (c > 0)
+    int count = values.count();
+    if (columns <= 0)
+        return Modbus::Status_Good;
+    Modbus::StatusCode r;
+    uint seq;
+    do
     {
-        if (Modbus::StatusCode r = readBools(static_cast<quint16>(offset), columns % (c+1), v+i))
-            return r;
-        c -= columns;
-        offset += maxColumns;
-        i += columns;
+        seq = readBegin();
+        const Buffer *b = m_buffer.load(std::memory_order_acquire);
+        r = Modbus::Status_Good;
+        uint offset = bitOffset;
+        // read memory frame line by line within single read operation
+        for (int i = 0; i < count; i += columns, offset += maxColumns)
+        {
+            r = readBoolsInner(b, offset, static_cast<uint>(qMin(columns, count - i)), v+i, nullptr);
+            if (!Modbus::StatusIsGood(r))
+                break;
+        }
     }
-    return Modbus::Status_Good;
+    while (readRetry(seq));
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeFrameBools(uint bitOffset, int columns, const QByteArray &values, int maxColumns)
 {
-    // TODO: make it single operation without 'writeBools' call
     const bool *v = reinterpret_cast<const bool*>(values.constData());
-    int c = values.count();
-    int offset = bitOffset;
-    int i = 0;
-    // read memory frame line by line
-    while (c > 0)
+    int count = values.count();
+    if (columns <= 0)
+        return Modbus::Status_Good;
+    WriteLocker _(this);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
+    uint offset = bitOffset;
+    // write memory frame line by line within single lock
+    for (int i = 0; i < count; i += columns, offset += maxColumns)
     {
-        if (Modbus::StatusCode r = writeBools(static_cast<quint16>(offset), columns % (c+1), v+i))
+        Modbus::StatusCode r = writeBoolsInner(b, offset, static_cast<uint>(qMin(columns, count - i)), v+i, nullptr);
+        if (!Modbus::StatusIsGood(r))
             return r;
-        c -= columns;
-        offset += maxColumns;
-        i += columns;
     }
     return Modbus::Status_Good;
 }
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::readFrameRegs(uint regOffset, int columns, QByteArray &values, int maxColumns) const
 {
-    // TODO: make it single operation without 'readRegs' call
     quint16 *v = reinterpret_cast<quint16*>(values.data());
-    int c = values.count()/static_cast<int>(sizeof(quint16));
-    int offset = regOffset;
-    int i = 0;
-    // read memory frame line by line
-    while (c > 0)
+    int count = values.count()/static_cast<int>(sizeof(quint16));
+    if (columns <= 0)
+        return Modbus::Status_Good;
+    Modbus::StatusCode r;
+    uint seq;
+    do
     {
-        if (Modbus::StatusCode r = readRegs(static_cast<quint16>(offset), columns % (c+1), v+i))
-            return r;
-        c -= columns;
-        offset += maxColumns;
-        i += columns;
+        seq = readBegin();
+        const Buffer *b = m_buffer.load(std::memory_order_acquire);
+        r = Modbus::Status_Good;
+        uint offset = regOffset;
+        // read memory frame line by line within single read operation
+        for (int i = 0; i < count; i += columns, offset += maxColumns)
+        {
+            uint c = static_cast<uint>(qMin(columns, count - i));
+            r = readInner(b, offset * MB_REGE_SZ_BYTES, c * MB_REGE_SZ_BYTES, v+i, nullptr);
+            if (!Modbus::StatusIsGood(r))
+                break;
+        }
     }
-    return Modbus::Status_Good;
+    while (readRetry(seq));
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeFrameRegs(uint regOffset, int columns, const QByteArray &values, int maxColumns)
 {
-    // TODO: make it single operation without 'writeRegs' call
     const quint16 *v = reinterpret_cast<const quint16*>(values.constData());
-    int c = values.count()/static_cast<int>(sizeof(quint16));
-    int offset = regOffset;
-    int i = 0;
-    // read memory frame line by line
-    while (c > 0)
+    int count = values.count()/static_cast<int>(sizeof(quint16));
+    if (columns <= 0)
+        return Modbus::Status_Good;
+    WriteLocker _(this);
+    Buffer *b = m_buffer.load(std::memory_order_relaxed);
+    uint offset = regOffset;
+    // write memory frame line by line within single lock
+    for (int i = 0; i < count; i += columns, offset += maxColumns)
     {
-        if (Modbus::StatusCode r = writeRegs(offset, columns % (c+1), v+i))
+        uint c = static_cast<uint>(qMin(columns, count - i));
+        Modbus::StatusCode r = writeInner(b, offset * MB_REGE_SZ_BYTES, c * MB_REGE_SZ_BYTES, v+i, nullptr);
+        if (!Modbus::StatusIsGood(r))
             return r;
-        c -= columns;
-        offset += maxColumns;
-        i += columns;
     }
     return Modbus::Status_Good;
 }
@@ -486,6 +1207,7 @@ mbServerDevice::mbServerDevice(QObject * /*parent*/)
     Defaults d = Defaults::instance();
     m_project = nullptr;
     setName(d.name);
+    setSparseMemory(d.isSparseMemory);
     this->realloc_0x(d.count0x);
     this->realloc_1x(d.count1x);
     this->realloc_3x(d.count3x);
@@ -494,6 +1216,8 @@ mbServerDevice::mbServerDevice(QObject * /*parent*/)
     setReadOnly(d.isReadOnly);
     m_settings.isSaveData = d.isSaveData;
     m_settings.delay = d.delay;
+    m_settings.delayJitter = d.delayJitter;
+    m_settings.delayDistribution = static_cast<DelayDistribution>(d.delayDistribution);
     m_settings.isEnableScript = d.isEnableScript;
 }
 
@@ -523,8 +1247,12 @@ Modbus::Settings mbServerDevice::settings() const
     r.insert(s.count4x                  , count_4x                  ());
     r.insert(s.isSaveData               , isSaveData                ());
     r.insert(s.isReadOnly               , isReadOnly                ());
+    r.insert(s.isSparseMemory           , isSparseMemory            ());
+    r.insert(s.memoryAliases            , memoryAliases             ());
     r.insert(s.exceptionStatusAddress   , exceptionStatusAddressInt ());
     r.insert(s.delay                    , delay                     ());
+    r.insert(s.delayJitter              , delayJitter               ());
+    r.insert(s.delayDistribution        , mb::enumKey(delayDistribution()));
     r.insert(s.isEnableScript           , isEnableScript            ());
 
     mb::unite(r, scriptSources());
@@ -542,6 +1270,14 @@ bool mbServerDevice::setSettings(const Modbus::Settings &settings)
     Modbus::Settings::const_iterator end = settings.end();
     bool ok;
 
+    // Note: memory representation is set before memory size to avoid allocation of dense memory
+    it = settings.find(s.isSparseMemory);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setSparseMemory(var.toBool());
+    }
+
     it = settings.find(s.count0x);
     if (it != end)
     {
@@ -601,6 +1337,13 @@ bool mbServerDevice::setSettings(const Modbus::Settings &settings)
             setExceptionStatusAddress(v);
     }
 
+    it = settings.find(s.memoryAliases);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setMemoryAliases(var.toString());
+    }
+
     it = settings.find(s.delay);
     if (it != end)
     {
@@ -610,6 +1353,24 @@ bool mbServerDevice::setSettings(const Modbus::Settings &settings)
             setDelay(v);
     }
 
+    it = settings.find(s.delayJitter);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint v = var.toUInt(&ok);
+        if (ok)
+            setDelayJitter(v);
+    }
+
+    it = settings.find(s.delayDistribution);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        DelayDistribution v = mb::enumValue<DelayDistribution>(var, &ok);
+        if (ok)
+            setDelayDistribution(v);
+    }
+
     it = settings.find(s.isEnableScript);
     if (it != end)
     {
@@ -622,6 +1383,44 @@ bool mbServerDevice::setSettings(const Modbus::Settings &settings)
     return true;
 }
 
+void mbServerDevice::setSparseMemory(bool sparse)
+{
+    m_mem_0x.setSparse(sparse);
+    m_mem_1x.setSparse(sparse);
+    m_mem_3x.setSparse(sparse);
+    m_mem_4x.setSparse(sparse);
+}
+
+size_t mbServerDevice::memoryUsage() const
+{
+    return m_mem_0x.memoryUsage() +
+           m_mem_1x.memoryUsage() +
+           m_mem_3x.memoryUsage() +
+           m_mem_4x.memoryUsage();
+}
+
+void mbServerDevice::releaseRetiredMemory()
+{
+    m_mem_0x.releaseRetired();
+    m_mem_1x.releaseRetired();
+    m_mem_3x.releaseRetired();
+    m_mem_4x.releaseRetired();
+}
+
+mbServerDevice::MemoryBlock *mbServerDevice::memBlock(Modbus::MemoryType memoryType)
+{
+    switch (memoryType)
+    {
+    case Modbus::Memory_0x: return &m_mem_0x;
+    case Modbus::Memory_1x: return &m_mem_1x;
+    case Modbus::Memory_3x: return &m_mem_3x;
+    case Modbus::Memory_4x: return &m_mem_4x;
+    default:
+        break;
+    }
+    return nullptr;
+}
+
 QByteArray mbServerDevice::readData(const mb::Address &address, quint16 count)
 {
     QByteArray v;
@@ -678,9 +1477,9 @@ void mbServerDevice::writeData(const mb::Address &address, quint16 count, const
     }
 }
 
+// Note: read requests don't take device lock because memory blocks are lock-free for readers
 Modbus::StatusCode mbServerDevice::readCoils(uint16_t offset, uint16_t count, void *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadCoils())
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_0x())
@@ -690,7 +1489,6 @@ Modbus::StatusCode mbServerDevice::readCoils(uint16_t offset, uint16_t count, vo
 
 Modbus::StatusCode mbServerDevice::readDiscreteInputs(uint16_t offset, uint16_t count, void *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadDiscreteInputs())
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_1x())
@@ -700,7 +1498,6 @@ Modbus::StatusCode mbServerDevice::readDiscreteInputs(uint16_t offset, uint16_t
 
 Modbus::StatusCode mbServerDevice::readHoldingRegisters(uint16_t offset, uint16_t count, uint16_t *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadHoldingRegisters())
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_4x())
@@ -710,7 +1507,6 @@ Modbus::StatusCode mbServerDevice::readHoldingRegisters(uint16_t offset, uint16_
 
 Modbus::StatusCode mbServerDevice::readInputRegisters(uint16_t offset, uint16_t count, uint16_t *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadInputRegisters())
         return Modbus::Status_BadIllegalDataAddress;
     if ((offset+count) > this->count_3x())
@@ -742,7 +1538,6 @@ Modbus::StatusCode mbServerDevice::writeSingleRegister(uint16_t offset, uint16_t
 
 Modbus::StatusCode mbServerDevice::readExceptionStatus(uint8_t *status)
 {
-    QReadLocker _(&m_lock);
     *status = this->exceptionStatus();
     return Modbus::Status_Good;
 }
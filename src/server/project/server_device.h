@@ -23,8 +23,12 @@
 #ifndef SERVER_DEVICE_H
 #define SERVER_DEVICE_H
 
+#include <atomic>
+
 #include <QReadWriteLock>
+#include <QVarLengthArray>
 #include <QSharedMemory>
+#include <QThread>
 
 #include <project/core_device.h>
 #include <server_global.h>
@@ -43,8 +47,12 @@ public:
         const QString count4x               ;
         const QString isSaveData            ;
         const QString isReadOnly            ;
+        const QString isSparseMemory        ;
+        const QString memoryAliases         ;
         const QString exceptionStatusAddress;
         const QString delay                 ;
+        const QString delayJitter           ;
+        const QString delayDistribution     ;
         const QString isEnableScript        ;
         const QString scriptInit            ;
         const QString scriptLoop            ;
@@ -66,33 +74,132 @@ public:
         const int  count4x               ;
         const bool isSaveData            ;
         const bool isReadOnly            ;
+        const bool isSparseMemory        ;
         const int  exceptionStatusAddress;
         const uint delay                 ;
+        const uint delayJitter           ;
+        const int  delayDistribution     ;
         const bool isEnableScript        ;
 
         Defaults();
         static const Defaults &instance();
     };
 
+    // Pool of fixed-size pages shared by sparse memory blocks of all devices.
+    // Pages are allocated by slabs and never returned to the system, so seqlock reader
+    // of the memory block can safely read the page that was released by writer at the same time
+    class MemoryPool
+    {
+    public:
+        // Size of sparse memory page (bytes): 256 registers or 4096 bits
+        static const uint PageBytes = 512;
+        // Count of pages allocated from the system at once
+        static const uint SlabPages = 64;
+
+    public:
+        static MemoryPool *global();
+
+    public:
+        // Returns zero-filled page
+        quint8 *allocPage();
+        void releasePage(quint8 *page);
+        // Memory (bytes) of pages that are used by memory blocks
+        inline size_t usedBytes() const { return m_used.load(std::memory_order_relaxed) * PageBytes; }
+        // Memory (bytes) allocated by pool from the system
+        inline size_t reservedBytes() const { return m_reserved.load(std::memory_order_relaxed) * PageBytes; }
+
+    private:
+        MemoryPool();
+        ~MemoryPool();
+
+    private:
+        std::atomic_flag m_lock;
+        QVector<quint8*> m_free;
+        QList<quint8*> m_slabs;
+        std::atomic<size_t> m_used;
+        std::atomic<size_t> m_reserved;
+    };
+
+    // Memory block uses seqlock to synchronize access to the memory.
+    // Readers never block: they read optimistically and repeat reading if memory
+    // was changed by writer at the same time. Writers are serialized by spinlock.
+    // Buffer is replaced (not reallocated in place) when block is resized,
+    // previous buffers are kept until block is destroyed (or 'releaseRetired()' is called), so reader can't access freed memory.
+    // Sparse memory block allocates pages from 'MemoryPool' on first write of nonzero data,
+    // pages that were never written are read as zeros.
     class MemoryBlock
     {
+    public:
+        // Size of memory page (bytes) used for change tracking: 64 registers or 1024 bits
+        static const uint PageBytes = 128;
+
+        // Continuous range of changed memory (bytes)
+        struct Range
+        {
+            uint offset;
+            uint count;
+        };
+        typedef QVector<Range> Ranges_t;
+
+        // Interface to be notified (outside of memory lock) after memory was changed
+        class Listener
+        {
+        public:
+            virtual ~Listener() {}
+            virtual void memoryChanged() = 0;
+        };
+
+        // Range of the block (bytes) that is backed by memory of other block:
+        // reads and writes of the range are redirected to the target memory
+        struct Alias
+        {
+            uint offset;
+            uint count;
+            MemoryBlock *target;
+            uint targetOffset;
+        };
+        typedef QVector<Alias> Aliases_t;
+
     public:
         MemoryBlock();
+        ~MemoryBlock();
 
     public:
-        inline int size() const { QReadLocker _(&m_lock); return m_data.size(); }
-        inline int sizeBits() const { QReadLocker _(&m_lock); return m_sizeBits; }
+        inline int size() const { return static_cast<int>(m_buffer.load(std::memory_order_acquire)->size); }
+        inline int sizeBits() const { return static_cast<int>(m_buffer.load(std::memory_order_acquire)->sizeBits); }
         inline int sizeBytes() const { return size(); }
-        inline int sizeRegs() const { QReadLocker _(&m_lock); return m_data.size() / MB_REGE_SZ_BYTES; }
+        inline int sizeRegs() const { return size() / MB_REGE_SZ_BYTES; }
         void resize(int bytes);
         void resizeBits(int bits);
         inline void resizeBytes(int bytes) { resize(bytes); }
         inline void resizeRegs(int regs) { resize(regs*MB_REGE_SZ_BYTES); }
         void memGet(uint byteOffset, void *buff, size_t size);
         void memSetMask(uint byteOffset, const void *buff, const void *mask, size_t size);
+        inline bool isSparse() const { return m_sparse; }
+        // Converts memory to sparse/dense representation, content of the memory is kept
+        void setSparse(bool sparse);
+        // Memory (bytes) currently used by the block
+        size_t memoryUsage() const;
+        // Deletes buffers that were replaced by resize.
+        // Must be called only when there is no other thread that can read the block (e.g. runtime is stopped)
+        void releaseRetired();
+        inline const Aliases_t &aliases() const { return m_aliases; }
+        // Aliases must be sorted by offset, must not overlap each other (neither own nor target ranges)
+        // and must be within both blocks, target must be other block and its range must not contain aliases of the target block.
+        // Must be called only when there is no other thread that uses the blocks (e.g. runtime is stopped)
+        void setAliases(const Aliases_t &aliases);
+        // Removes aliases, current data of aliased ranges is copied into own memory of the block
+        void clearAliases();
 
     public:
-        inline uint changeCounter() const { QReadLocker _(&m_lock); return m_changeCounter; }
+        // Change counter is also used as generation number of the memory:
+        // every change of memory increments it and marks changed pages with the new value
+        inline uint changeCounter() const { return m_changeCounter.load(std::memory_order_acquire); }
+        inline uint generation() const { return changeCounter(); }
+        // Returns ranges (aligned to pages) changed after 'generation'.
+        // If 'current' is not null it gets generation the returned ranges correspond to.
+        Ranges_t changedRanges(uint generation, uint *current = nullptr) const;
+        inline void setListener(Listener *listener) { m_listener.store(listener, std::memory_order_release); }
         void zerroAll();
         Modbus::StatusCode read(uint offset, uint count, void *values, uint *fact = nullptr) const;
         Modbus::StatusCode write(uint offset, uint count, const void *values, uint *fact = nullptr);
@@ -102,16 +209,134 @@ public:
         Modbus::StatusCode writeBools(uint bitOffset, uint bitCount, const bool *values, uint *fact = nullptr);
         Modbus::StatusCode readRegs(uint regOffset, uint regCount, quint16 *values, uint *fact = nullptr) const;
         Modbus::StatusCode writeRegs(uint regOffset, uint regCount, const quint16 *values, uint *fact = nullptr);
+        // Copies 'bitCount' bits from memory of 'src' block (can be this block) starting from 'srcBitOffset'
+        // into this block starting from 'bitOffset' at once: both blocks (and targets of its aliases) are locked
+        // for the whole transfer, so readers never see partially copied data. Bit offsets can be unaligned.
+        // If 'rows' > 1 then the same is repeated for next rows, 'stride' and 'srcStride' are distances (bits)
+        // between rows of this and source block. Source is read before destination is written.
+        Modbus::StatusCode copyBits(uint bitOffset, const MemoryBlock *src, uint srcBitOffset, uint bitCount, uint *fact = nullptr,
+                                    uint rows = 1, uint stride = 0, uint srcStride = 0);
+        // Frame functions read/write 'values' (bools or registers) by rows of 'columns' items
+        // within memory rows of 'maxColumns' items as single operation
         Modbus::StatusCode readFrameBools(uint bitOffset, int columns, QByteArray &values, uint maxColumns) const;
         Modbus::StatusCode writeFrameBools(uint bitOffset, int columns, const QByteArray &values, int maxColumns);
         Modbus::StatusCode readFrameRegs(uint regOffset, int columns, QByteArray &values, int maxColumns) const;
         Modbus::StatusCode writeFrameRegs(uint regOffset, int columns, const QByteArray &values, int maxColumns);
 
     private:
-        mutable QReadWriteLock m_lock;
-        QByteArray m_data;
-        uint m_sizeBits;
-        uint m_changeCounter;
+        struct Buffer
+        {
+            Buffer() : size(0), sizeBits(0), isSparse(false), sparseCount(0) {}
+            ~Buffer();
+            QByteArray data; // memory of dense block
+            uint size;       // size of memory (bytes)
+            uint sizeBits;
+            bool isSparse;
+            QVector<quint8*> sparsePages; // pages of sparse block ('nullptr' for page that contains only zeros)
+            uint sparseCount;             // count of allocated pages of sparse block
+            QVector<uint> pages; // generation of the last change for each page
+        };
+        typedef QVarLengthArray<quint8, 256> Temp_t;
+
+        class WriteLocker
+        {
+        public:
+            inline WriteLocker(MemoryBlock *mem) : m_mem(mem) { m_mem->lockWrite(); }
+            inline ~WriteLocker() { m_mem->unlockWrite(); }
+        private:
+            MemoryBlock *m_mem;
+        };
+
+        // Locks destination and source block of the transfer together with targets of their aliases
+        class TransferLocker
+        {
+        public:
+            TransferLocker(MemoryBlock *dst, const MemoryBlock *src);
+            ~TransferLocker();
+        private:
+            MemoryBlock *m_dst;
+            QVarLengthArray<MemoryBlock*, 8> m_blocks;
+        };
+
+        // Block that has aliases is locked together with its targets (see 'm_lockOrder')
+        void lockWrite();
+        void unlockWrite();
+        void lockSingle();
+        bool unlockSingle(Range *changed);
+        // Unlocks 'blocks' and notifies about changes, 'writer' is lock order of the block that was written
+        static void unlockBlocks(MemoryBlock *const *blocks, int count, const QVector<MemoryBlock*> &writer);
+        void notifyChanged(const Range &changed, const QVector<MemoryBlock*> &locked);
+        void markAliasChanged(uint byteOffset, uint byteCount);
+        inline uint readBegin() const
+        {
+            uint seq;
+            while ((seq = m_seq.load(std::memory_order_acquire)) & 1) // Note: writer is in progress
+                QThread::yieldCurrentThread();
+            return seq;
+        }
+        inline bool readRetry(uint seq) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return m_seq.load(std::memory_order_relaxed) != seq;
+        }
+        void resizeBuffer(int bytes, uint bits);
+        void retireBuffer(Buffer *b);
+        void markChanged(Buffer *b, uint byteOffset, uint byteCount);
+        static Buffer *createBuffer(uint bytes, uint bits, bool sparse);
+        static void releaseSparse(Buffer *b);
+        // Note: functions below can access sparse and dense memory in the same way
+        static void bufferCopyTo(const Buffer *b, uint offset, uint count, void *dst);
+        static void bufferCopyFrom(Buffer *b, uint offset, uint count, const void *src);
+        // Same as above but aliased ranges are accessed in the target memory.
+        // 'locked' means that write lock of the block (and so of its targets) is held by caller
+        void copyTo(const Buffer *b, uint offset, uint count, void *dst, bool locked) const;
+        void copyFrom(Buffer *b, uint offset, uint count, const void *src);
+        void readAlias(uint offset, uint count, void *dst) const;
+        bool isAliased(uint offset, uint count) const;
+        // Returns pointer to 'count' bytes of memory starting from 'offset' (plus 1 zero byte after).
+        // Dense memory is accessed directly, sparse or aliased memory is gathered into 'temp'
+        const quint8 *readPtr(const Buffer *b, uint offset, uint count, Temp_t &temp, bool locked = false) const;
+        // Same as 'readPtr' but changed data must be stored by 'writeCommit' (it does nothing for direct access)
+        quint8 *writePtr(Buffer *b, uint offset, uint count, Temp_t &temp);
+        void writeCommit(Buffer *b, uint offset, uint count, const quint8 *data);
+        // Bit kernels that process memory by 64-bit words.
+        // 'bitsExtract' copies 'bitCount' bits of 'src' starting from bit 'srcShift' (0-7) into 'dst' starting from bit 0,
+        // unused bits of the last byte of 'dst' are set to zero, 'src' must have 1 readable byte after the range (see 'readPtr').
+        // 'bitsInsert' copies 'bitCount' bits of 'src' starting from bit 0 into 'dst' starting from bit 'dstShift' (0-7),
+        // other bits of 'dst' are kept
+        static void bitsExtract(quint8 *dst, const quint8 *src, uint srcShift, uint bitCount);
+        static void bitsInsert(quint8 *dst, uint dstShift, const quint8 *src, uint bitCount);
+
+    private:
+        Modbus::StatusCode readInner(const Buffer *b, uint offset, uint count, void *values, uint *fact) const;
+        Modbus::StatusCode readBitsInner(const Buffer *b, uint bitOffset, uint bitCount, void *values, uint *fact) const;
+        Modbus::StatusCode readBoolsInner(const Buffer *b, uint bitOffset, uint bitCount, bool *values, uint *fact) const;
+        // Note: write functions below must be called when block is locked
+        Modbus::StatusCode writeInner(Buffer *b, uint offset, uint count, const void *values, uint *fact);
+        Modbus::StatusCode writeBoolsInner(Buffer *b, uint bitOffset, uint bitCount, const bool *values, uint *fact);
+
+    private:
+        std::atomic_flag m_writeLock;
+        std::atomic<uint> m_seq;
+        std::atomic<Buffer*> m_buffer;
+        QList<Buffer*> m_retired;
+        std::atomic<uint> m_changeCounter;
+        std::atomic<Listener*> m_listener;
+        bool m_changed;
+        Range m_changedRange;
+        bool m_sparse;
+
+    private: // aliases
+        struct Dependent // alias of other block that targets this block
+        {
+            MemoryBlock *block;
+            uint offset;
+            uint targetOffset;
+            uint count;
+        };
+        Aliases_t m_aliases;
+        QVector<Dependent> m_dependents;
+        QVector<MemoryBlock*> m_lockOrder; // this block and its targets sorted by address (empty if there is no alias)
     };
 
     enum ScriptType
@@ -121,6 +346,15 @@ public:
         Script_Final
     };
 
+    // Distribution of the random part (jitter) of the response delay
+    enum DelayDistribution
+    {
+        DelayUniform,    // delay +- jitter
+        DelayNormal,     // jitter is standard deviation
+        DelayExponential // jitter is mean of additional delay (long tail)
+    };
+    Q_ENUM(DelayDistribution)
+
 public:
     explicit mbServerDevice(QObject *parent = nullptr);
 
@@ -144,8 +378,24 @@ public: // settings
     inline void setReadOnly(bool v) { m_settings.isReadOnly = v; }
     inline bool isSaveData() const { return m_settings.isSaveData; }
     inline void setSaveData(bool save) { m_settings.isSaveData = save; }
+    inline bool isSparseMemory() const { return m_mem_0x.isSparse(); }
+    void setSparseMemory(bool sparse);
+    // Memory (bytes) used by all memory blocks of the device
+    size_t memoryUsage() const;
+    // See 'MemoryBlock::releaseRetired()'
+    void releaseRetiredMemory();
+    // Returns memory block of the 'memoryType' (0x, 1x, 3x, 4x) or 'nullptr' for other types
+    MemoryBlock *memBlock(Modbus::MemoryType memoryType);
+    // List of memory aliases separated by ';', each alias is 'address,count,targetAddress,targetDevice'.
+    // Aliases are resolved by runtime when it starts (see 'MemoryBlock::setAliases()')
+    inline QString memoryAliases() const { return m_settings.memoryAliases; }
+    inline void setMemoryAliases(const QString &aliases) { m_settings.memoryAliases = aliases; }
     inline uint delay() const { return m_settings.delay; }
     inline void setDelay(uint delay) { m_settings.delay = delay; }
+    inline uint delayJitter() const { return m_settings.delayJitter; }
+    inline void setDelayJitter(uint jitter) { m_settings.delayJitter = jitter; }
+    inline DelayDistribution delayDistribution() const { return m_settings.delayDistribution; }
+    inline void setDelayDistribution(DelayDistribution distribution) { m_settings.delayDistribution = distribution; }
     inline bool isEnableScript() const { return m_settings.isEnableScript; }
     inline void setEnableScript(bool v) { m_settings.isEnableScript = v; }
 
@@ -172,6 +422,7 @@ public: // 'Modbus'-like Interface
 
 public: // memory-0x management functions
     inline uint changeCounter_0x() const { return m_mem_0x.changeCounter(); }
+    inline MemoryBlock::Ranges_t changedRanges_0x(uint generation, uint *current = nullptr) const { return m_mem_0x.changedRanges(generation, current); }
     inline int count_0x() const { return m_mem_0x.sizeBits(); }
     inline int count_0x_bites() const { return m_mem_0x.sizeBits(); }
     inline int count_0x_bytes() const { return m_mem_0x.sizeBytes(); }
@@ -219,6 +470,7 @@ public: // memory-0x management functions
 
 public: // memory-1x management functions
     inline uint changeCounter_1x() const { return m_mem_1x.changeCounter(); }
+    inline MemoryBlock::Ranges_t changedRanges_1x(uint generation, uint *current = nullptr) const { return m_mem_1x.changedRanges(generation, current); }
     inline int count_1x() const { return m_mem_1x.sizeBits(); }
     inline int count_1x_bites() const { return m_mem_1x.sizeBits(); }
     inline int count_1x_bytes() const { return m_mem_1x.sizeBytes(); }
@@ -266,6 +518,7 @@ public: // memory-1x management functions
 
 public: // memory-3x management functions
     inline uint changeCounter_3x() const { return m_mem_3x.changeCounter(); }
+    inline MemoryBlock::Ranges_t changedRanges_3x(uint generation, uint *current = nullptr) const { return m_mem_3x.changedRanges(generation, current); }
     inline int count_3x() const { return m_mem_3x.sizeRegs(); }
     inline int count_3x_bites() const { return m_mem_3x.sizeBits(); }
     inline int count_3x_bytes() const { return m_mem_3x.sizeBytes(); }
@@ -311,6 +564,7 @@ public: // memory-3x management functions
 
 public: // memory-4x management functions
     inline uint changeCounter_4x() const { return m_mem_4x.changeCounter(); }
+    inline MemoryBlock::Ranges_t changedRanges_4x(uint generation, uint *current = nullptr) const { return m_mem_4x.changedRanges(generation, current); }
     inline int count_4x() const { return m_mem_4x.sizeRegs(); }
     inline int count_4x_bites() const { return m_mem_4x.sizeBits(); }
     inline int count_4x_bytes() const { return m_mem_4x.sizeBytes(); }
@@ -393,7 +647,10 @@ private: // settings
         bool        isSaveData            ;
         bool        isReadOnly            ;
         mb::Address exceptionStatusAddress;
+        QString     memoryAliases         ;
         uint        delay                 ;
+        uint        delayJitter           ;
+        DelayDistribution delayDistribution;
         bool        isEnableScript        ;
     } m_settings;
 
@@ -31,16 +31,52 @@
 #define MAX_DISCRETS 1600
 #define MAX_REGISTERS 100
 
+mbServerPort::Strings::Strings() : mbCorePort::Strings(),
+    runMode(QStringLiteral("runMode")),
+    impairLatency(QStringLiteral("impairLatency")),
+    impairJitter(QStringLiteral("impairJitter")),
+    impairLoss(QStringLiteral("impairLoss")),
+    impairCorruption(QStringLiteral("impairCorruption")),
+    impairBaudRate(QStringLiteral("impairBaudRate"))
+{
+}
+
+const mbServerPort::Strings &mbServerPort::Strings::instance()
+{
+    static const Strings s;
+    return s;
+}
+
+mbServerPort::Defaults::Defaults() : mbCorePort::Defaults(),
+    runMode(Auto),
+    impairment{0, 0, 0.0, 0.0, 0}
+{
+}
+
+const mbServerPort::Defaults &mbServerPort::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
 mbServerPort::mbServerPort(QObject *parent) :
     mbCorePort(parent)
 {
     memset(m_units, 0, sizeof(m_units));
+    m_runMode = Defaults::instance().runMode;
+    m_impairment = Defaults::instance().impairment;
 }
 
 mbServerPort::~mbServerPort()
 {
 }
 
+void mbServerPort::setStatImpairment(const ImpairmentStatistic &stat)
+{
+    m_statImpairment = stat;
+    Q_EMIT statImpairmentChanged(stat.delayed, stat.dropped, stat.corrupted);
+}
+
 QString mbServerPort::extendedName() const
 {
     switch (type())
@@ -54,6 +90,90 @@ QString mbServerPort::extendedName() const
     return name();
 }
 
+QString mbServerPort::runModeStr() const
+{
+    return mb::enumKey<RunMode>(m_runMode);
+}
+
+void mbServerPort::setRunModeStr(const QString &mode)
+{
+    bool ok;
+    RunMode v = mb::enumValueTypeStr<RunMode>(mode, &ok);
+    if (ok)
+        setRunMode(v);
+}
+
+MBSETTINGS mbServerPort::settings() const
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS r = mbCorePort::settings();
+    r.insert(s.runMode, runModeStr());
+    r.insert(s.impairLatency   , m_impairment.latency   );
+    r.insert(s.impairJitter    , m_impairment.jitter    );
+    r.insert(s.impairLoss      , m_impairment.loss      );
+    r.insert(s.impairCorruption, m_impairment.corruption);
+    r.insert(s.impairBaudRate  , m_impairment.baudRate  );
+    return r;
+}
+
+bool mbServerPort::setSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    MBSETTINGS::const_iterator end = settings.end();
+
+    it = settings.find(s.runMode);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setRunModeStr(var.toString());
+    }
+
+    bool ok;
+    it = settings.find(s.impairLatency);
+    if (it != end)
+    {
+        uint v = it.value().toUInt(&ok);
+        if (ok)
+            m_impairment.latency = v;
+    }
+
+    it = settings.find(s.impairJitter);
+    if (it != end)
+    {
+        uint v = it.value().toUInt(&ok);
+        if (ok)
+            m_impairment.jitter = v;
+    }
+
+    it = settings.find(s.impairLoss);
+    if (it != end)
+    {
+        double v = it.value().toDouble(&ok);
+        if (ok)
+            m_impairment.loss = qBound(0.0, v, 100.0);
+    }
+
+    it = settings.find(s.impairCorruption);
+    if (it != end)
+    {
+        double v = it.value().toDouble(&ok);
+        if (ok)
+            m_impairment.corruption = qBound(0.0, v, 100.0);
+    }
+
+    it = settings.find(s.impairBaudRate);
+    if (it != end)
+    {
+        uint v = it.value().toUInt(&ok);
+        if (ok)
+            m_impairment.baudRate = v;
+    }
+    return mbCorePort::setSettings(settings);
+}
+
 int mbServerPort::freeDeviceUnit() const
 {
     for (int i = 1; i < 255; i++)
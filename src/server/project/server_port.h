@@ -37,6 +37,63 @@ class mbServerPort : public mbCorePort
 {
     Q_OBJECT
 
+public:
+    enum RunMode
+    {
+        Auto       , // own thread of the port is polling, worker pool thread is event-driven
+        Polling    ,
+        EventDriven
+    };
+    Q_ENUM(RunMode)
+
+    // Simulation of bad network link between client and server port
+    struct Impairment
+    {
+        uint   latency   ; // additional delay of response (milliseconds)
+        uint   jitter    ; // random part of the latency: latency +- jitter (milliseconds)
+        double loss      ; // percent of requests left without response
+        double corruption; // percent of responses with corrupted value (frame stays valid, not a link error)
+        uint   baudRate  ; // bit rate of the emulated link, 0 - unlimited
+
+        inline bool isEnabled() const { return latency || jitter || (loss > 0) || (corruption > 0) || baudRate; }
+    };
+
+    // Count of requests affected by impairment since the port was created (updated while running)
+    struct ImpairmentStatistic
+    {
+        ImpairmentStatistic()
+        {
+            delayed   = 0;
+            dropped   = 0;
+            corrupted = 0;
+        }
+        quint32 delayed  ;
+        quint32 dropped  ;
+        quint32 corrupted; // responses with corrupted value
+    };
+
+    struct Strings : public mbCorePort::Strings
+    {
+        const QString runMode;
+        const QString impairLatency;
+        const QString impairJitter;
+        const QString impairLoss;
+        const QString impairCorruption;
+        const QString impairBaudRate;
+
+        Strings();
+        static const Strings &instance();
+    };
+
+    struct Defaults : public mbCorePort::Defaults
+    {
+        const RunMode runMode;
+        const Impairment impairment;
+
+        Defaults();
+        static const Defaults &instance();
+    };
+
 public:
     explicit mbServerPort(QObject* parent = nullptr);
     virtual ~mbServerPort();
@@ -46,6 +103,22 @@ public:
     inline void setProject(mbServerProject* project) { mbCorePort::setProjectCore(reinterpret_cast<mbCoreProject*>(project)); }
     QString extendedName() const override;
 
+public: // runtime settings
+    inline RunMode runMode() const { return m_runMode; }
+    inline void setRunMode(RunMode mode) { m_runMode = mode; }
+    QString runModeStr() const;
+    void setRunModeStr(const QString &mode);
+    inline const Impairment &impairment() const { return m_impairment; }
+    inline void setImpairment(const Impairment &impairment) { m_impairment = impairment; }
+
+public: // statistic
+    inline ImpairmentStatistic statImpairment() const { return m_statImpairment; }
+    void setStatImpairment(const ImpairmentStatistic &stat);
+
+public: // settings
+    MBSETTINGS settings() const override;
+    bool setSettings(const MBSETTINGS &settings) override;
+
 public: // devices
     int freeDeviceUnit() const;
     inline bool hasDevice(mbServerDeviceRef* device) const { return m_devices.contains(device); }
@@ -73,6 +146,7 @@ Q_SIGNALS:
     void deviceAdded(mbServerDeviceRef*);
     void deviceRemoving(mbServerDeviceRef*);
     void deviceRemoved(mbServerDeviceRef*);
+    void statImpairmentChanged(quint32 delayed, quint32 dropped, quint32 corrupted);
 
 private:
     void deviceRemoveUnits(mbServerDeviceRef *device);
@@ -83,6 +157,11 @@ private: // devices
     typedef QList<mbServerDeviceRef*> Devices_t;
     typedef QHash<QString, mbServerDeviceRef*> HashDevices_t;
     Devices_t m_devices;
+
+private: // runtime settings
+    RunMode m_runMode;
+    Impairment m_impairment;
+    ImpairmentStatistic m_statImpairment;
 };
 
 #endif // SERVER_PORT_H
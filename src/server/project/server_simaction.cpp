@@ -45,7 +45,18 @@ mbServerSimAction::Strings::Strings() :
     randomMin        (QStringLiteral("randomMin")),
     randomMax        (QStringLiteral("randomMax")),
     copySourceAddress(QStringLiteral("sourceAddress")),
-    copySize         (QStringLiteral("size"))
+    copySize         (QStringLiteral("size")),
+    waveformType     (QStringLiteral("waveform")),
+    waveformChannels (QStringLiteral("waveformChannels")),
+    waveformPeriod   (QStringLiteral("waveformPeriod")),
+    waveformPhaseStep(QStringLiteral("waveformPhaseStep")),
+    waveformAmplitude(QStringLiteral("waveformAmplitude")),
+    waveformOffset   (QStringLiteral("waveformOffset")),
+    waveformTable    (QStringLiteral("waveformTable")),
+    replayFile       (QStringLiteral("replayFile")),
+    replayChannels   (QStringLiteral("replayChannels")),
+    replaySpeed      (QStringLiteral("replaySpeed")),
+    replayLoop       (QStringLiteral("replayLoop"))
 {
 }
 
@@ -73,7 +84,16 @@ mbServerSimAction::Defaults::Defaults() :
     randomMin        (0),
     randomMax        (100),
     copySourceAddress(300001),
-    copySize         (1)
+    copySize         (1),
+    waveformType     (WaveformSine),
+    waveformChannels (16),
+    waveformPeriod   (10000),
+    waveformPhaseStep(0),
+    waveformAmplitude(100),
+    waveformOffset   (0),
+    replayChannels   (1),
+    replaySpeed      (1.0),
+    replayLoop       (true)
 {
 }
 
@@ -290,13 +310,19 @@ int mbServerSimAction::byteLength() const
 
 int mbServerSimAction::length() const
 {
+    // Note: 'Waveform' and 'Replay' actions drive several values (channels) one after another
+    int channels = 1;
+    if (m_actionType == Waveform)
+        channels = static_cast<ActionWaveform*>(m_actionExtended)->channels;
+    else if (m_actionType == Replay)
+        channels = static_cast<ActionReplay*>(m_actionExtended)->channels;
     switch (m_address.type())
     {
     case Modbus::Memory_0x:
     case Modbus::Memory_1x:
-        return bitLength();
+        return bitLength() * channels;
     default:
-        return registerLength();
+        return registerLength() * channels;
     }
 }
 
@@ -353,6 +379,12 @@ void mbServerSimAction::setNewActionExtended(ActionType actionType)
     case Copy:
         m_actionExtended = new ActionCopy(this);
         break;
+    case Waveform:
+        m_actionExtended = new ActionWaveform(this);
+        break;
+    case Replay:
+        m_actionExtended = new ActionReplay(this);
+        break;
     default:
         return;
     }
@@ -540,3 +572,156 @@ QString mbServerSimAction::ActionCopy::extendedSettingsStr() const
                                       s.copySize         , QString::number(size));
 }
 
+
+// -----------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------------- WAVEFORM ------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+MBSETTINGS mbServerSimAction::ActionWaveform::extendedSettings() const
+{
+    const Strings &s = Strings::instance();
+    MBSETTINGS p;
+    p[s.waveformType     ] = mb::enumKey(waveformType);
+    p[s.waveformChannels ] = channels      ;
+    p[s.waveformPeriod   ] = waveformPeriod;
+    p[s.waveformPhaseStep] = phaseStep     ;
+    p[s.waveformAmplitude] = amplitude     ;
+    p[s.waveformOffset   ] = offset        ;
+    p[s.waveformTable    ] = table         ;
+    return p;
+}
+
+void mbServerSimAction::ActionWaveform::setExtendedSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    auto end = settings.end();
+    bool ok;
+
+    it = settings.find(s.waveformType);
+    if (it != end)
+    {
+        WaveformType v = mb::enumValue<WaveformType>(it.value(), &ok);
+        if (ok)
+            waveformType = v;
+    }
+
+    it = settings.find(s.waveformChannels);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok && (v > 0))
+            channels = v;
+    }
+
+    it = settings.find(s.waveformPeriod);
+    if (it != end)
+    {
+        qint64 v = it.value().toLongLong(&ok);
+        if (ok && (v > 0))
+            waveformPeriod = v;
+    }
+
+    it = settings.find(s.waveformPhaseStep);
+    if (it != end)
+    {
+        qint64 v = it.value().toLongLong(&ok);
+        if (ok)
+            phaseStep = v;
+    }
+
+    it = settings.find(s.waveformAmplitude);
+    if (it != end)
+    {
+        double v = it.value().toDouble(&ok);
+        if (ok)
+            amplitude = v;
+    }
+
+    it = settings.find(s.waveformOffset);
+    if (it != end)
+    {
+        double v = it.value().toDouble(&ok);
+        if (ok)
+            offset = v;
+    }
+
+    it = settings.find(s.waveformTable);
+    if (it != end)
+        table = it.value().toString().simplified();
+}
+
+QString mbServerSimAction::ActionWaveform::extendedSettingsStr() const
+{
+    const Strings &s = Strings::instance();
+    QString res = QString("%1=%2;%3=%4;%5=%6;%7=%8;%9=%10")
+        .arg(s.waveformType     , mb::enumKey(waveformType),
+             s.waveformChannels , QString::number(channels),
+             s.waveformPeriod   , QString::number(waveformPeriod),
+             s.waveformPhaseStep, QString::number(phaseStep),
+             s.waveformAmplitude, QString::number(amplitude));
+    res += QString(";%1=%2").arg(s.waveformOffset, QString::number(offset));
+    if (table.count())
+        res += QString(";%1=%2").arg(s.waveformTable, table);
+    return res;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------
+// -------------------------------------------------------- REPLAY -------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------
+
+MBSETTINGS mbServerSimAction::ActionReplay::extendedSettings() const
+{
+    const Strings &s = Strings::instance();
+    MBSETTINGS p;
+    p[s.replayFile    ] = file    ;
+    p[s.replayChannels] = channels;
+    p[s.replaySpeed   ] = speed   ;
+    p[s.replayLoop    ] = loop    ;
+    return p;
+}
+
+void mbServerSimAction::ActionReplay::setExtendedSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    auto end = settings.end();
+    bool ok;
+
+    it = settings.find(s.replayFile);
+    if (it != end)
+        file = it.value().toString().trimmed();
+
+    it = settings.find(s.replayChannels);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok && (v > 0))
+            channels = v;
+    }
+
+    it = settings.find(s.replaySpeed);
+    if (it != end)
+    {
+        double v = it.value().toDouble(&ok);
+        if (ok && (v > 0))
+            speed = v;
+    }
+
+    it = settings.find(s.replayLoop);
+    if (it != end)
+        loop = it.value().toBool();
+}
+
+QString mbServerSimAction::ActionReplay::extendedSettingsStr() const
+{
+    // Note: file name can't contain ';' and '=' symbols because of extended string format
+    const Strings &s = Strings::instance();
+    return QString("%1=%2;%3=%4;%5=%6;%7=%8")
+        .arg(s.replayChannels, QString::number(channels),
+             s.replaySpeed   , QString::number(speed),
+             s.replayLoop    , loop ? QStringLiteral("true") : QStringLiteral("false"),
+             s.replayFile    , file);
+}
@@ -37,10 +37,22 @@ public:
         Increment,
         Sine,
         Random,
-        Copy
+        Copy,
+        Waveform,
+        Replay
     };
     Q_ENUM(ActionType)
 
+    // Generator of 'Waveform' action which drives whole range of values (channels)
+    enum WaveformType
+    {
+        WaveformSine,
+        WaveformRamp,
+        WaveformNoise,
+        WaveformTable
+    };
+    Q_ENUM(WaveformType)
+
     struct Strings
     {
         const QString device           ;
@@ -63,6 +75,17 @@ public:
         const QString randomMax        ;
         const QString copySourceAddress;
         const QString copySize         ;
+        const QString waveformType     ;
+        const QString waveformChannels ;
+        const QString waveformPeriod   ;
+        const QString waveformPhaseStep;
+        const QString waveformAmplitude;
+        const QString waveformOffset   ;
+        const QString waveformTable    ;
+        const QString replayFile       ;
+        const QString replayChannels   ;
+        const QString replaySpeed      ;
+        const QString replayLoop       ;
 
         Strings();
         static const Strings &instance();
@@ -88,6 +111,15 @@ public:
         const int               randomMax        ;
         const int               copySourceAddress;
         const quint16           copySize         ;
+        const WaveformType      waveformType     ;
+        const int               waveformChannels ;
+        const int               waveformPeriod   ;
+        const int               waveformPhaseStep;
+        const int               waveformAmplitude;
+        const int               waveformOffset   ;
+        const int               replayChannels   ;
+        const double            replaySpeed      ;
+        const bool              replayLoop       ;
 
         Defaults();
         static const Defaults &instance();
@@ -238,6 +270,52 @@ private:
         }
     };
 
+    struct ActionWaveform : public ActionExtended
+    {
+        WaveformType waveformType;
+        int channels;
+        qint64 waveformPeriod;
+        qint64 phaseStep;
+        double amplitude;
+        double offset;
+        QString table; // Note: values of lookup table separated by space
+
+        MBSETTINGS extendedSettings() const override;
+        void setExtendedSettings(const MBSETTINGS &settings) override;
+        QString extendedSettingsStr() const override;
+
+        ActionWaveform(mbServerSimAction *a) : ActionExtended(a)
+        {
+            Defaults d = Defaults::instance();
+            waveformType   = d.waveformType     ;
+            channels       = d.waveformChannels ;
+            waveformPeriod = d.waveformPeriod   ;
+            phaseStep      = d.waveformPhaseStep;
+            amplitude      = d.waveformAmplitude;
+            offset         = d.waveformOffset   ;
+        }
+    };
+
+    struct ActionReplay : public ActionExtended
+    {
+        QString file; // Note: CSV or converted binary file, relative path is related to project file
+        int channels;
+        double speed;
+        bool loop;
+
+        MBSETTINGS extendedSettings() const override;
+        void setExtendedSettings(const MBSETTINGS &settings) override;
+        QString extendedSettingsStr() const override;
+
+        ActionReplay(mbServerSimAction *a) : ActionExtended(a)
+        {
+            Defaults d = Defaults::instance();
+            channels = d.replayChannels;
+            speed    = d.replaySpeed   ;
+            loop     = d.replayLoop    ;
+        }
+    };
+
 private:
     void setNewActionExtended(ActionType actionType);
 
@@ -6,7 +6,9 @@ More details.
 
 #from typing import Union
 
+import os
 from os import path
+import platform
 from ctypes import *
 import struct
 
@@ -16,6 +18,13 @@ from PyQt5.QtCore import QSharedMemory
 from mbconfig import *
 import modbus
 
+# Note: module is available only within embedded interpreter of the server
+#       and gives direct access to device memory
+try:
+    import _mbembedded
+except ImportError:
+    _mbembedded = None
+
 def swapbyteorder(data: bytearray) -> bytearray:
     """
     @note Since v0.4.2
@@ -48,6 +57,19 @@ MB_BYTEORDER_DEFAULT = 'little'
 # Note (Feb 08 2025): c_long type was replaced by c_int because
 #                     on some platforms c_long is size of 8 bytes
 
+_numpymodule = False
+
+def _numpy():
+    # Note: numpy is optional and imported only when it's used for the first time
+    global _numpymodule
+    if _numpymodule is False:
+        try:
+            import numpy
+            _numpymodule = numpy
+        except ImportError:
+            _numpymodule = None
+    return _numpymodule
+
 
 class CDeviceBlock(Structure): 
     _fields_ = [("flags"             , c_uint),
@@ -63,17 +85,107 @@ class CDeviceBlock(Structure):
                 ("stringTableSize"   , c_uint)]
 
 class CPythonBlock(Structure): 
-    _fields_ = [("pycycle"           , c_uint)]
-
+    _fields_ = [("pycycle"           , c_uint),
+                ("pyflags"           , c_uint)]
+
+# Note: memory block is lock-free: [header][mem][out][mask][pages][acks].
+#       `mem` is written only by server (`seq` is odd while it's being changed),
+#       `out`, `mask`, `pages` and `changeCounter` are written only by script,
+#       `acks` is written only by server when page changes are applied and copied back into `mem`.
+#       Page stamp is writer seqlock: `changeCounter` is always even and page is stamped with odd value
+#       while its `out` and `mask` are changed, so server never applies half-written value.
+#       Lock-free access relies on strong (x86) memory ordering: script can't issue memory barriers,
+#       so on other CPUs both sides access memory block under shared memory lock (`_MEMBLOCK_LOCKED` flag)
 class CMemoryBlockHeader(Structure): 
-    _fields_ = [("changeCounter"     , c_uint),
-                ("changeByteOffset"  , c_uint),
-                ("changeByteCount"   , c_uint),
-                ("dummy"             , c_uint)]
+    _fields_ = [("seq"               , c_uint),
+                ("changeCounter"     , c_uint),
+                ("memBytes"          , c_uint),
+                ("pageBytes"         , c_uint),
+                ("pageCount"         , c_uint),
+                ("flags"             , c_uint),
+                ("dummy"             , c_uint*2)]
+
+_MEMBLOCK_LOCKED = 1
+
+_STRONG_ORDER_MACHINES = ('x86_64', 'amd64', 'x64', 'i386', 'i486', 'i586', 'i686', 'x86')
 
 ## @endcond
 
 
+class _MemoryBuffer:
+    """Copy of device memory region that can be read and changed in bulk.
+
+       Buffer is created by `buffer()` function of the memory objects.
+       Its content is available as writable `memoryview` and as typed numpy arrays
+       (if numpy is installed) which don't copy data when device byte and register order allow it.
+       Changed bytes are written into device memory by `commit()` in one operation
+       (it's called automatically at the end of `with` statement).
+    """
+    ## @cond
+    def __init__(self, memblock, byteoffset:int, bytecount:int, bitcount:int=None):
+        self._mem = memblock
+        self._byteoffset = byteoffset
+        self._bitcount = bitcount if bitcount is not None else bytecount*8
+        self._orig = memblock._getbytes(byteoffset, bytecount, bytes)
+        self._data = bytearray(self._orig)
+        self._arrays = []
+    ## @endcond
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if exc_type is None:
+            self.commit()
+        return False
+
+    def __len__(self)->int:
+        return len(self._data)
+
+    def memoryview(self)->memoryview:
+        """
+        @details Returns writable `memoryview` of the buffer bytes.
+        """
+        return memoryview(self._data)
+
+    def numpy(self, dtype='uint16'):
+        """
+        @details
+        Returns numpy array of `dtype` items for the buffer.
+        Byte and register order of the device are applied to the items.
+        For bit memory `dtype='bool'` returns array of bits.
+
+        @param[in]  dtype   numpy data type, e.g. 'uint16', 'int32', 'float32', 'bool'.
+
+        @note Raises `RuntimeError` if numpy is not installed.
+        """
+        np = _numpy()
+        if np is None:
+            raise RuntimeError("numpy is not installed")
+        arr, conv = self._mem._numpyarray(np, self, dtype)
+        if conv is not None:
+            self._arrays.append((arr, conv))
+        return arr
+
+    def refresh(self):
+        """
+        @details Reads device memory into the buffer again. Not committed changes are discarded.
+        """
+        self._orig = self._mem._getbytes(self._byteoffset, len(self._data), bytes)
+        self._data[:] = self._orig
+        for arr, conv in self._arrays:
+            conv[0](arr)
+
+    def commit(self):
+        """
+        @details Writes changed bytes of the buffer into device memory.
+        """
+        for arr, conv in self._arrays:
+            conv[1](arr)
+        self._mem._writechanged(self._byteoffset, self._data, self._orig)
+        self._orig = bytes(self._data)
+
+
 class _MemoryBlock:
     """Base class for the memory objects mem0x, mem1x, mem3x, mem4x.
 
@@ -100,15 +212,35 @@ class _MemoryBlock:
             raise RuntimeError(f"Cannot attach to Shared Memory with id = '{shmid}'")
         qptr = shm.data()
         memptr = c_void_p(qptr.__int__())
-        sz = shm.size()
-        cbytes = bytecount if bytecount <= sz else sz
+        ptrhead = cast(memptr, POINTER(CMemoryBlockHeader))
+        head = ptrhead[0]
+        membytes = head.memBytes
+        cbytes = bytecount if bytecount <= membytes else membytes
         self._shm = shm
         self._countbytes = cbytes
         self._id = id
-        ptrhead = cast(memptr, POINTER(CMemoryBlockHeader))
-        self._head = ptrhead[0]
-        self._pmembytes = cast(byref(ptrhead[1]),POINTER(c_ubyte*1))
-        self._pmaskbytes = cast(byref(cast(byref(ptrhead[1]),POINTER(c_byte*cbytes))[1]),POINTER(c_ubyte*1))
+        self._head = head
+        self._membytes = membytes
+        self._pagebytes = head.pageBytes if head.pageBytes else 1
+        self._npout = None
+        self._npmask = None
+        ptr = memptr.value + sizeof(CMemoryBlockHeader)
+        self._pmembytes  = cast(c_void_p(ptr), POINTER(c_ubyte*1))
+        self._poutbytes  = cast(c_void_p(ptr+membytes), POINTER(c_ubyte*1))
+        self._pmaskbytes = cast(c_void_p(ptr+membytes*2), POINTER(c_ubyte*1))
+        self._memaddr  = ptr
+        self._outaddr  = ptr+membytes
+        self._maskaddr = ptr+membytes*2
+        ptr += (membytes*3 + 3) & ~3
+        self._ppages = cast(c_void_p(ptr), POINTER(c_uint*head.pageCount)).contents
+        self._packs  = cast(c_void_p(ptr+head.pageCount*4), POINTER(c_uint*head.pageCount)).contents
+        self._direct = _mbembedded.memblock(shmid) if _mbembedded is not None else None
+        self._locked = bool(head.flags & _MEMBLOCK_LOCKED) or (platform.machine().lower() not in _STRONG_ORDER_MACHINES)
+        if self._locked and not (head.flags & _MEMBLOCK_LOCKED):
+            # Note: server checks the flag every cycle and takes the same lock from then on
+            shm.lock()
+            head.flags |= _MEMBLOCK_LOCKED
+            shm.unlock()
 
     def __del__(self):
         try:
@@ -116,17 +248,152 @@ class _MemoryBlock:
         except RuntimeError:
             pass
     
-    def _recalcheader(self, byteoffset:int, bytecount:int):
-        rightedge = byteoffset + bytecount
-        if self._head.changeByteOffset > byteoffset:
-            if self._head.changeByteCount == 0:
-                self._head.changeByteCount = rightedge - byteoffset
-            else:
-                self._head.changeByteCount += self._head.changeByteOffset - byteoffset # Fixed Jan 30 2025
-            self._head.changeByteOffset = byteoffset
-        if self._head.changeByteOffset + self._head.changeByteCount < rightedge:
-            self._head.changeByteCount = rightedge - self._head.changeByteOffset
-        self._head.changeCounter += 1
+    def _readmem(self, byteoffset:int, count:int, bytestype=bytes) -> Union[bytes, bytearray]:
+        if self._direct is not None:
+            b = _mbembedded.memget(self._direct, byteoffset, count)
+            return b if bytestype is bytes else bytestype(b)
+        if not self._locked:
+            return self._readmemnolock(byteoffset, count, bytestype)
+        self._shm.lock()
+        try:
+            return self._readmemnolock(byteoffset, count, bytestype)
+        finally:
+            self._shm.unlock()
+
+    def _readmemnolock(self, byteoffset:int, count:int, bytestype=bytes) -> Union[bytes, bytearray]:
+        # Note: seqlock read, repeat if server was changing memory at the same time
+        head = self._head
+        arr = cast(self._pmembytes[byteoffset], POINTER(c_ubyte*count))[0]
+        while True:
+            seq = head.seq
+            if seq & 1:
+                continue
+            b = bytestype(arr)
+            if head.seq == seq:
+                break
+        # Note: own changes that are not applied by server yet are taken from `out`
+        pagebytes = self._pagebytes
+        for page in range(byteoffset // pagebytes, (byteoffset+count-1) // pagebytes + 1):
+            if self._ppages[page] != self._packs[page]:
+                if not isinstance(b, bytearray):
+                    b = bytearray(b)
+                beg = max(page * pagebytes, byteoffset)
+                c = min((page+1) * pagebytes, byteoffset+count) - beg
+                m = int.from_bytes(string_at(self._maskaddr+beg, c), 'little')
+                if m:
+                    j = beg - byteoffset
+                    v = int.from_bytes(b[j:j+c], 'little')
+                    o = int.from_bytes(string_at(self._outaddr+beg, c), 'little')
+                    b[j:j+c] = ((v & ~m) | (o & m)).to_bytes(c, 'little')
+        return bytestype(b) if bytestype is bytes else b
+
+    def _beginwrite(self, pages):
+        # Note: page is stamped with odd value before its `out` and `mask` are changed
+        pagebytes = self._pagebytes
+        busy = (self._head.changeCounter + 1) & 0xFFFFFFFF
+        for page in pages:
+            applied = self._ppages[page] == self._packs[page]
+            self._ppages[page] = busy
+            if applied:
+                # Note: previous changes of the page are already applied by server
+                beg = page * pagebytes
+                memset(self._pmaskbytes[beg], 0, min(pagebytes, self._membytes-beg))
+
+    def _publish(self, pages):
+        # Note: pages are stamped before counter is published, so server never misses the change
+        gen = (self._head.changeCounter + 2) & 0xFFFFFFFF
+        for page in pages:
+            self._ppages[page] = gen
+        self._head.changeCounter = gen
+
+    def _lock(self):
+        if self._locked:
+            self._shm.lock()
+
+    def _unlock(self):
+        if self._locked:
+            self._shm.unlock()
+
+    def _writemem(self, byteoffset:int, value: Union[bytes, bytearray], mask: Union[bytes, bytearray] = None):
+        count = len(value)
+        if self._direct is not None:
+            _mbembedded.memset(self._direct, byteoffset, bytes(value), None if mask is None else bytes(mask))
+            return
+        pages = range(byteoffset // self._pagebytes, (byteoffset+count-1) // self._pagebytes + 1)
+        self._lock()
+        try:
+            self._writememnolock(byteoffset, value, mask, pages)
+        finally:
+            self._unlock()
+
+    def _writememnolock(self, byteoffset:int, value: Union[bytes, bytearray], mask, pages):
+        count = len(value)
+        self._beginwrite(pages)
+        if mask is None:
+            memmove(self._poutbytes[byteoffset], bytes(value), count)
+            memset(self._pmaskbytes[byteoffset], -1, count)
+        else:
+            for i in range(count):
+                m = mask[i]
+                o = byteoffset + i
+                self._poutbytes[o][0] = (self._poutbytes[o][0] & ~m) | (value[i] & m)
+                self._pmaskbytes[o][0] |= m
+        self._publish(pages)
+
+    def _writechanged(self, byteoffset:int, value: Union[bytes, bytearray], orig: Union[bytes, bytearray]):
+        # Note: only changed bytes (bits for bit memory) are written,
+        #       so concurrent changes of other values made by server are not overwritten
+        if self._direct is not None:
+            _mbembedded.memcommit(self._direct, byteoffset, value, orig, self._bitmask)
+            return
+        np = _numpy()
+        if np is not None:
+            v = np.frombuffer(value, dtype=np.uint8)
+            x = v ^ np.frombuffer(orig, dtype=np.uint8)
+            idx = np.flatnonzero(x)
+            if idx.size == 0:
+                return
+            pos = idx + byteoffset
+            pages = np.unique(pos // self._pagebytes).tolist()
+            if self._npout is None:
+                self._npout  = np.ctypeslib.as_array(cast(self._poutbytes , POINTER(c_ubyte)), shape=(self._membytes,))
+                self._npmask = np.ctypeslib.as_array(cast(self._pmaskbytes, POINTER(c_ubyte)), shape=(self._membytes,))
+            m = x[idx] if self._bitmask else np.full(idx.size, 0xFF, dtype=np.uint8)
+            self._lock()
+            try:
+                self._beginwrite(pages)
+                self._npout[pos] = (self._npout[pos] & ~m) | (v[idx] & m)
+                self._npmask[pos] |= m
+                self._publish(pages)
+            finally:
+                self._unlock()
+        else:
+            idx = [i for i in range(len(value)) if value[i] != orig[i]]
+            if not idx:
+                return
+            pages = sorted({(byteoffset+i) // self._pagebytes for i in idx})
+            self._lock()
+            try:
+                self._beginwrite(pages)
+                for i in idx:
+                    m = (value[i] ^ orig[i]) if self._bitmask else 0xFF
+                    o = byteoffset + i
+                    self._poutbytes[o][0] = (self._poutbytes[o][0] & ~m) | (value[i] & m)
+                    self._pmaskbytes[o][0] |= m
+                self._publish(pages)
+            finally:
+                self._unlock()
+
+    def _view(self, byteoffset:int, bytecount:int)->memoryview:
+        # Note: view refers to the ctypes array, so it stays valid while memory block is attached
+        arr = (c_ubyte*bytecount).from_address(self._memaddr+byteoffset)
+        return memoryview(arr).cast('B').toreadonly()
+
+    def _getvalue(self, byteoffset:int, ctype):
+        return ctype.from_buffer_copy(self._readmem(byteoffset, sizeof(ctype))).value
+
+    def _setvalue(self, byteoffset:int, ctype, value):
+        self._writemem(byteoffset, bytes(ctype(value)))
 
     def _getbytes(self, byteoffset: int, count: int, bytestype=bytes) -> Union[bytes, bytearray]:
         if 0 <= byteoffset < self._countbytes:
@@ -134,9 +401,7 @@ class _MemoryBlock:
                 c = self._countbytes - byteoffset
             else:
                 c = count
-            self._shm.lock()
-            b = bytestype(cast(self._pmembytes[byteoffset], POINTER(c_ubyte*c))[0])
-            self._shm.unlock()
+            b = self._readmem(byteoffset, c, bytestype)
             return b
         return bytestype()
 
@@ -258,11 +523,7 @@ class _MemoryBlock:
                 c = count
             if not isinstance(value, bytes):
                 value = bytes(value)
-            self._shm.lock()
-            memmove(self._pmembytes[byteoffset], value, c)
-            memset(self._pmaskbytes[byteoffset], -1, c)
-            self._recalcheader(byteoffset, c)
-            self._shm.unlock()
+            self._writemem(byteoffset, value[:c])
         ## @endcond
 
     def getbitbytearray(self, bitoffset:int, bitcount:int)->bytearray:
@@ -384,9 +645,7 @@ class _MemoryBlock:
         ## @cond
         byteoffset = bitoffset // 8
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            vbyte = self._pmembytes[byteoffset][0]
-            self._shm.unlock()
+            vbyte = self._getvalue(byteoffset, c_ubyte)
             return (vbyte & (1 << bitoffset % 8)) != 0
         return False
         ## @endcond
@@ -409,14 +668,8 @@ class _MemoryBlock:
         ## @cond
         byteoffset = bitoffset // 8
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            if value:
-                self._pmembytes[byteoffset][0] |= (1 << (bitoffset % 8))
-            else:
-                self._pmembytes[byteoffset][0] &= ~(1 << (bitoffset % 8))
-            self._pmaskbytes[byteoffset][0] |= (1 << bitoffset % 8)
-            self._recalcheader(byteoffset, 1)
-            self._shm.unlock()
+            m = 1 << (bitoffset % 8)
+            self._writemem(byteoffset, bytes([m if value else 0]), bytes([m]))
         ## @endcond
 
     def getbitstring(self, bitoffset:int, bytecount:int)->str:
@@ -568,12 +821,88 @@ class _MemoryBlockBits(_MemoryBlock):
        More details. 
     """
     ## @cond
+    _bitmask = True
+
     def __init__(self, shmid:str, count:int, id:int, byteorder, regorder:int):
         super().__init__(shmid, (count+7)//8, id, byteorder, regorder)
         c = self._countbytes * 8
         self._count = count if count <= c else c
+
+    def _numpyarray(self, np, buf:_MemoryBuffer, dtype):
+        data = buf._data
+        dt = np.dtype(dtype)
+        if dt != np.bool_:
+            return np.frombuffer(data, dtype=dt, count=len(data) // dt.itemsize), None
+        raw = np.frombuffer(data, dtype=np.uint8)
+        count = buf._bitcount
+        orig = np.empty(count, dtype=np.bool_)
+        def load(arr):
+            arr[:] = np.unpackbits(raw, bitorder='little')[:count]
+            orig[:] = arr
+        def store(arr):
+            # Note: only changed bits are written back, so other views of the buffer are not overwritten
+            idx = np.flatnonzero(arr != orig)
+            if idx.size:
+                byteidx = idx >> 3
+                bits = np.left_shift(1, idx & 7).astype(np.uint8)
+                values = arr[idx]
+                np.bitwise_and.at(raw, byteidx, ~bits)
+                np.bitwise_or.at(raw, byteidx[values], bits[values])
+                orig[:] = arr
+        arr = np.empty(count, dtype=np.bool_)
+        load(arr)
+        return arr, (load, store)
     ## @endcond
 
+    def buffer(self, bitoffset:int=0, bitcount:int=None)->_MemoryBuffer:
+        """
+        @details
+        Function returns buffer (`_MemoryBuffer`) with copy of device memory starting with `bitoffset` and `bitcount` bits.
+        Buffer content is available as `memoryview` of packed bits or as numpy array (`buffer.numpy('bool')`)
+        and all its changes are written into device memory by single `commit()` call:
+
+        ```python
+        with mem0x.buffer(0, 1000) as buf:
+            bits = buf.numpy('bool')
+            bits[::2] = True
+        ```
+
+        @param[in]  bitoffset   Bit offset (0-based), must be multiple of 8.
+        @param[in]  bitcount    Count of bits. If `None` buffer contains all bits up to the end of memory.
+
+        @note Raises `IndexError` if `bitoffset` is out of range or `ValueError` if it's not multiple of 8.
+        """
+        if bitoffset < 0 or bitoffset >= self._count:
+            raise IndexError("Memory index out of range")
+        if bitoffset % 8:
+            raise ValueError("Bit offset of the buffer must be multiple of 8")
+        if bitcount is None or bitoffset+bitcount > self._count:
+            bitcount = self._count - bitoffset
+        return _MemoryBuffer(self, bitoffset // 8, (bitcount+7) // 8, bitcount)
+
+    def view(self, bitoffset:int=0, bitcount:int=None)->memoryview:
+        """
+        @details
+        Function returns read-only `memoryview` of packed bits of device memory starting with `bitoffset`
+        and `bitcount` bits. Unlike `buffer()` it's not a copy: view is placed directly on shared memory
+        with device values, so it always shows current values without any copying.
+        View can't be used to change memory: use `buffer()` and its `commit()` or `set...()` functions.
+
+        @param[in]  bitoffset   Bit offset (0-based), must be multiple of 8.
+        @param[in]  bitcount    Count of bits. If `None` view contains all bits up to the end of memory.
+
+        @note Values can be changed by server while view is being read and own changes are visible
+              only after server applied them (usually next cycle).
+              Raises `IndexError` if `bitoffset` is out of range or `ValueError` if it's not multiple of 8.
+        """
+        if bitoffset < 0 or bitoffset >= self._count:
+            raise IndexError("Memory index out of range")
+        if bitoffset % 8:
+            raise ValueError("Bit offset of the view must be multiple of 8")
+        if bitcount is None or bitoffset+bitcount > self._count:
+            bitcount = self._count - bitoffset
+        return self._view(bitoffset // 8, (bitcount+7) // 8)
+
     def __getitem__(self, index:int)->int:
         """
         @details
@@ -944,14 +1273,149 @@ class _MemoryBlockRegs(_MemoryBlock):
        More details. 
     """
     ## @cond
+    _bitmask = False
+
     def __init__(self, shmid:str, count:int, id:int, byteorder, regorder:int):
         super().__init__(shmid, count*2, id, byteorder, regorder)
         c = self._countbytes // 2
         self._count = count if count <= c else c
-        self._pmem = cast(self._pmembytes,POINTER(c_ushort*1))
-        self._pmask = cast(self._pmaskbytes,POINTER(c_ushort*1))
+
+    def _regpermutation(self, regcount:int):
+        # Note: same register order as in swap32() and swap64()
+        if regcount == 2:
+            if self._registerorder == MB_REGISTERORDER_R3R2R1R0 or self._registerorder == MB_REGISTERORDER_R1R0R3R2:
+                return [1, 0]
+        elif regcount == 4:
+            if   self._registerorder == MB_REGISTERORDER_R3R2R1R0:
+                return [3, 2, 1, 0]
+            elif self._registerorder == MB_REGISTERORDER_R1R0R3R2:
+                return [1, 0, 3, 2]
+            elif self._registerorder == MB_REGISTERORDER_R2R3R0R1:
+                return [2, 3, 0, 1]
+        return list(range(regcount))
+
+    def _numpydtype(self, dt):
+        # Note: returns numpy type that presents memory as is or `None` if it needs conversion
+        size = dt.itemsize
+        if size == 1:
+            return dt
+        regcount = size // 2
+        perm = self._regpermutation(regcount)
+        little = (self._byteorder == 'little')
+        if perm == list(range(regcount)) and (little or regcount == 1):
+            return dt.newbyteorder('<' if little else '>')
+        if perm == list(reversed(range(regcount))) and not little:
+            return dt.newbyteorder('>')
+        return None
+
+    def _numpyarray(self, np, buf:_MemoryBuffer, dtype):
+        data = buf._data
+        dt = np.dtype(dtype)
+        size = dt.itemsize
+        count = len(data) // size
+        ndt = self._numpydtype(dt)
+        if ndt is not None:
+            return np.frombuffer(data, dtype=ndt, count=count), None
+        regcount = size // 2
+        perm = self._regpermutation(regcount)
+        little = (self._byteorder == 'little')
+        # Note: mixed byte and register order can't be presented as numpy type,
+        #       so array is a converted copy which is written back into buffer by commit()
+        raw = np.frombuffer(data, dtype=np.uint8, count=count*size).reshape(count, regcount, 2)
+        ledt = dt.newbyteorder('<')
+        orig = np.empty(count, dtype=ledt)
+        def load(arr):
+            r = raw[:, perm, :]
+            if not little:
+                r = r[:, :, ::-1]
+            orig[:] = np.ascontiguousarray(r).reshape(-1).view(ledt)
+            arr[:] = orig
+        def store(arr):
+            # Note: only changed items are written back, so other views of the buffer are not overwritten
+            cur = np.ascontiguousarray(arr, dtype=ledt)
+            idx = np.flatnonzero((cur.view(np.uint8).reshape(count, size) != orig.view(np.uint8).reshape(count, size)).any(axis=1))
+            if idx.size:
+                r = cur[idx].view(np.uint8).reshape(idx.size, regcount, 2)
+                if not little:
+                    r = r[:, :, ::-1]
+                raw[np.ix_(idx, perm, [0, 1])] = r
+                orig[:] = cur
+        arr = np.empty(count, dtype=dt)
+        load(arr)
+        return arr, (load, store)
     ## @endcond
 
+    def buffer(self, offset:int=0, count:int=None)->_MemoryBuffer:
+        """
+        @details
+        Function returns buffer (`_MemoryBuffer`) with copy of device memory starting with register `offset`
+        and `count` registers. Buffer content is available as `memoryview` or as typed numpy array
+        (`buffer.numpy('uint16')`, `buffer.numpy('int32')`, `buffer.numpy('float32')` etc)
+        with device byte and register order applied. All changes are written into device memory
+        by single `commit()` call:
+
+        ```python
+        with mem4x.buffer(0, 5000) as buf:
+            regs = buf.numpy('uint16')
+            regs += 1
+        ```
+
+        @param[in]  offset  Offset of the first register (0-based).
+        @param[in]  count   Count of registers. If `None` buffer contains all registers up to the end of memory.
+
+        @note Raises `IndexError` if `offset` is out of range.
+        """
+        if offset < 0 or offset >= self._count:
+            raise IndexError("Memory index out of range")
+        if count is None or offset+count > self._count:
+            count = self._count - offset
+        return _MemoryBuffer(self, offset*2, count*2)
+
+    def view(self, offset:int=0, count:int=None)->memoryview:
+        """
+        @details
+        Function returns read-only `memoryview` of device memory bytes starting with register `offset`
+        and `count` registers. Unlike `buffer()` it's not a copy: view is placed directly on shared memory
+        with device values, so it always shows current values without any copying.
+        Bytes are in device memory order (registers are little-endian `uint16`, e.g. `view().cast('H')` on x86).
+        View can't be used to change memory: use `buffer()` and its `commit()` or `set...()` functions.
+
+        @param[in]  offset  Offset of the first register (0-based).
+        @param[in]  count   Count of registers. If `None` view contains all registers up to the end of memory.
+
+        @note Values can be changed by server while view is being read (so multi-register value can be
+              inconsistent) and own changes are visible only after server applied them (usually next cycle).
+              Raises `IndexError` if `offset` is out of range.
+        """
+        if offset < 0 or offset >= self._count:
+            raise IndexError("Memory index out of range")
+        if count is None or offset+count > self._count:
+            count = self._count - offset
+        return self._view(offset*2, count*2)
+
+    def numpyview(self, dtype='uint16', offset:int=0, count:int=None):
+        """
+        @details
+        Returns read-only numpy array of `dtype` items placed directly on device memory (see `view()`),
+        starting with register `offset` and `count` registers.
+
+        @param[in]  dtype   numpy data type, e.g. 'uint16', 'int32', 'float32'.
+        @param[in]  offset  Offset of the first register (0-based).
+        @param[in]  count   Count of registers. If `None` array contains all registers up to the end of memory.
+
+        @note Raises `RuntimeError` if numpy is not installed and `ValueError` if device byte and register order
+              of `dtype` items can't be presented without conversion (use `buffer()` in this case).
+        """
+        np = _numpy()
+        if np is None:
+            raise RuntimeError("numpy is not installed")
+        dt = np.dtype(dtype)
+        ndt = self._numpydtype(dt)
+        if ndt is None:
+            raise ValueError(f"Device byte and register order of '{dt.name}' needs conversion, use buffer() instead")
+        v = self.view(offset, count)
+        return np.frombuffer(v, dtype=ndt, count=len(v) // dt.itemsize)
+
     def __getitem__(self, index:int)->int:
         """
         @details
@@ -988,9 +1452,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         ## @cond
         byteoffset = regoffset * 2
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            value = cast(self._pmembytes[byteoffset], POINTER(c_byte))[0]
-            self._shm.unlock()
+            value = self._getvalue(byteoffset, c_byte)
             return value
         return 0
         ## @endcond
@@ -1031,9 +1493,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         ## @cond
         byteoffset = regoffset * 2
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            r = self._pmembytes[byteoffset][0]
-            self._shm.unlock()
+            r = self._getvalue(byteoffset, c_ubyte)
             return r
         return 0
         ## @endcond
@@ -1057,11 +1517,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         ## @cond
         byteoffset = regoffset * 2
         if 0 <= byteoffset < self._countbytes:
-            self._shm.lock()
-            self._pmembytes [byteoffset][0] = value
-            self._pmaskbytes[byteoffset][0] = 0xFF
-            self._recalcheader(byteoffset, 1)
-            self._shm.unlock()
+            self._setvalue(byteoffset, c_ubyte, value)
         ## @endcond
             
     def getint16(self, offset:int)->int:
@@ -1074,9 +1530,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count:
-            self._shm.lock()
-            value = cast(self._pmem[offset], POINTER(c_short))[0]
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_short)
             if self._byteorder == 'big':
                 value = struct.unpack('<h', struct.pack('>h', value))[0]
             return value
@@ -1095,11 +1549,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         if 0 <= offset < self._count:
             if self._byteorder == 'big':
                 value = struct.unpack('<h', struct.pack('>h', value))[0]
-            self._shm.lock()
-            self._pmem [offset][0] = value
-            self._pmask[offset][0] = 0xFFFF
-            self._recalcheader(offset*2, 2)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_ushort, value)
 
     def getuint16(self, offset:int)->int:
         """
@@ -1111,9 +1561,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count:
-            self._shm.lock()
-            value = self._pmem[offset][0]
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_ushort)
             if self._byteorder == 'big':
                 value = struct.unpack('<H', struct.pack('>H', value))[0]
             return value
@@ -1132,11 +1580,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         if 0 <= offset < self._count:
             if self._byteorder == 'big':
                 value = struct.unpack('<H', struct.pack('>H', value))[0]
-            self._shm.lock()
-            self._pmem [offset][0] = value
-            self._pmask[offset][0] = 0xFFFF
-            self._recalcheader(offset*2, 2)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_ushort, value)
 
     def getint32(self, offset:int)->int:
         """
@@ -1148,9 +1592,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-1:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_int))[0])
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_int)
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
@@ -1171,11 +1613,7 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
-            self._shm.lock()
-            cast(self._pmem [offset], POINTER(c_int))[0] = value
-            cast(self._pmask[offset], POINTER(c_int))[0] = 0xFFFFFFFF
-            self._recalcheader(offset*2, 4)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_int, value)
 
     def getuint32(self, offset:int)->int:
         """
@@ -1187,9 +1625,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-1:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_uint))[0])
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_uint)
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
@@ -1210,11 +1646,7 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(value.to_bytes(4, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
-            self._shm.lock()
-            cast(self._pmem [offset], POINTER(c_uint))[0] = value
-            cast(self._pmask[offset], POINTER(c_uint))[0] = 0xFFFFFFFF
-            self._recalcheader(offset*2, 4)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_uint, value)
 
     def getint64(self, offset:int)->int:
         """
@@ -1227,9 +1659,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-3:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_longlong))[0])
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_longlong)
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
@@ -1251,11 +1681,7 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=True))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=True)
-            self._shm.lock()
-            cast(self._pmem [offset], POINTER(c_longlong))[0] = value
-            cast(self._pmask[offset], POINTER(c_longlong))[0] = 0xFFFFFFFFFFFFFFFF
-            self._recalcheader(offset*2, 8)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_longlong, value)
 
     def getuint64(self, offset:int)->int:
         """
@@ -1268,9 +1694,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-3:
-            self._shm.lock()
-            value = int(cast(self._pmem[offset], POINTER(c_ulonglong))[0])
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_ulonglong)
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
@@ -1292,11 +1716,7 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(value.to_bytes(8, MB_BYTEORDER_DEFAULT, signed=False))
                 value = int.from_bytes(b, byteorder=MB_BYTEORDER_DEFAULT, signed=False)
-            self._shm.lock()
-            cast(self._pmem [offset], POINTER(c_ulonglong))[0] = value
-            cast(self._pmask[offset], POINTER(c_ulonglong))[0] = 0xFFFFFFFFFFFFFFFF
-            self._recalcheader(offset*2, 8)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_ulonglong, value)
 
     def getfloat(self, offset:int)->int:
         """
@@ -1308,9 +1728,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-1:
-            self._shm.lock()
-            value = float(cast(self._pmem[offset], POINTER(c_float))[0])
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_float)
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(struct.pack('<f', value))
                 value = struct.unpack('<f', b)[0]
@@ -1331,11 +1749,7 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap32(struct.pack('<f', value))
                 value = struct.unpack('<f', b)[0]
-            self._shm.lock()
-            cast(self._pmem [offset], POINTER(c_float))[0] = value
-            cast(self._pmask[offset], POINTER(c_uint))[0] = 0xFFFFFFFF
-            self._recalcheader(offset*2, 4)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_float, value)
 
     def getdouble(self, offset:int)->int:
         """
@@ -1347,9 +1761,7 @@ class _MemoryBlockRegs(_MemoryBlock):
         @note If `offset` is out of range, function returns `0`.
         """
         if 0 <= offset < self._count-3:
-            self._shm.lock()
-            value = float(cast(self._pmem[offset], POINTER(c_double))[0])
-            self._shm.unlock()
+            value = self._getvalue(offset*2, c_double)
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(struct.pack('<d', value))
                 value = struct.unpack('<d', b)[0]
@@ -1370,11 +1782,7 @@ class _MemoryBlockRegs(_MemoryBlock):
             if not (self._byteorder == MB_BYTEORDER_DEFAULT and self._registerorder == MB_REGISTERORDER_R0R1R2R3):
                 b = self.swap64(struct.pack('<d', value))
                 value = struct.unpack('<d', b)[0]
-            self._shm.lock()
-            cast(self._pmem [offset], POINTER(c_double))[0] = value
-            cast(self._pmask[offset], POINTER(c_ulonglong))[0] = 0xFFFFFFFFFFFFFFFF
-            self._recalcheader(offset*2, 8)
-            self._shm.unlock()
+            self._setvalue(offset*2, c_double, value)
 
     def getstring(self, regoffset:int, bytecount:int)->str:
         """
@@ -1405,7 +1813,7 @@ class _MbDevice:
        More details. 
     """
     ## @cond
-    def __init__(self, shmidprefix:str, project:str):
+    def __init__(self, shmidprefix:str, project:str, syncpipe:str=""):
         self._libpath = path.dirname(path.abspath(__file__))
         self._projectpath = path.dirname(path.abspath(project))
         self._projectfile = path.basename(project)
@@ -1456,12 +1864,40 @@ class _MbDevice:
         if self._excmem is None:
             self._excmem = self._mem0x
             self._excoffset = 0
+        # Pipe to notify server about memory changes made by script
+        self._syncfd = None
+        self._syncchanges = self._getchanges()
+        if syncpipe:
+            try:
+                self._syncfd = os.open(syncpipe, os.O_WRONLY | os.O_NONBLOCK)
+            except (OSError, AttributeError):
+                self._syncfd = None
 
     def __del__(self):
+        try:
+            if self._syncfd is not None:
+                os.close(self._syncfd)
+        except OSError:
+            pass
         try:
             self._shm.detach()
         except RuntimeError:
             pass
+
+    def _getchanges(self)->int:
+        return (self._mem0x._head.changeCounter + self._mem1x._head.changeCounter +
+                self._mem3x._head.changeCounter + self._mem4x._head.changeCounter) & 0xFFFFFFFF
+
+    def _notifysync(self):
+        if self._syncfd is None:
+            return
+        c = self._getchanges()
+        if c != self._syncchanges:
+            self._syncchanges = c
+            try:
+                os.write(self._syncfd, b'\x01')
+            except OSError:
+                pass # Note: pipe is full, so server is already notified
     
     def _getstring(self, offset:int)->str:
         c = 0
@@ -1523,55 +1959,37 @@ class _MbDevice:
         """
         @details Returns bit flags of the current device as integer.
         """
-        self._shm.lock()
-        r = self._control.flags
-        self._shm.unlock()
-        return r
+        return self._control.flags
 
     def getcycle(self)->int:
         """
         @details Returns count of cycles of Modbus Server app synchronizer.
         """
-        self._shm.lock()
-        r = self._control.cycle
-        self._shm.unlock()
-        return r
+        return self._control.cycle
 
     def getcount0x(self)->int:
         """
         @details Returns count of coils (bits, 0x) of the current device.
         """
-        self._shm.lock()
-        r = self._control.count0x
-        self._shm.unlock()
-        return r
+        return self._control.count0x
 
     def getcount1x(self)->int:
         """
         @details Returns count of discrete inputs (bits, 1x) of the current device.
         """
-        self._shm.lock()
-        r = self._control.count1x
-        self._shm.unlock()
-        return r
+        return self._control.count1x
 
     def getcount3x(self)->int:
         """
         @details Returns count of input regs (16-bit words, 3x) of the current device.
         """
-        self._shm.lock()
-        r = self._control.count3x
-        self._shm.unlock()
-        return r
+        return self._control.count3x
 
     def getcount4x(self)->int:
         """
         @details Returns count of holding regs (16-bit words, 4x) of the current device.
         """
-        self._shm.lock()
-        r = self._control.count4x
-        self._shm.unlock()
-        return r
+        return self._control.count4x
 
     def getexcstatus(self)->int:
         """
@@ -1609,7 +2027,12 @@ class _MbDevice:
     
     ## @cond
     def _incpycycle(self):
+        self._notifysync()
         return self._python.incpycycle()
+
+    def _setfinished(self):
+        self._notifysync()
+        self._python.setfinished()
     ## @endcond
 
     def getmem0x(self)->_MemoryBlockBits:
@@ -1913,15 +2336,13 @@ class _MemoryPythonBlock:
             pass
     
     def getpycycle(self):
-        self._shm.lock()
-        r = self._control.pycycle
-        self._shm.unlock()
-        return r
+        return self._control.pycycle
 
     def incpycycle(self):
         self._cyclecounter += 1
-        self._shm.lock()
         self._control.pycycle = self._cyclecounter
-        self._shm.unlock()
+
+    def setfinished(self):
+        self._control.pyflags |= 1
 ## @endcond
 
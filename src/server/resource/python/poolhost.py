@@ -0,0 +1,145 @@
+#!/usr/bin/python
+
+# Note: host program of the shared Python worker process. It runs Init/Loop/Final scripts
+#       of several devices that are listed in manifest file, so every device doesn't need
+#       its own interpreter process. Devices are scheduled cooperatively within single thread:
+#       'Loop' script of the device is executed when its period is expired.
+
+from os import sys, path
+from time import sleep, time
+import argparse
+import json
+import traceback
+
+_parser = argparse.ArgumentParser()
+_parser.add_argument('-prj', '--project', type=str, default="")
+_parser.add_argument('-imp', '--importpath', type=str, default="")
+_parser.add_argument('-m', '--manifest' , type=str, default="")
+_args = _parser.parse_args()
+
+_pathList = _args.importpath.split(";")
+
+sys.path.insert(0, path.normpath(path.dirname(path.abspath(__file__))))
+sys.path.extend([_p for _p in _pathList if _p not in sys.path])
+
+from PyQt5.QtCore import QSharedMemory
+from ctypes import c_void_p, cast, POINTER
+from mbserver import _MbDevice, CDeviceBlock
+
+# Max time (seconds) to wait for server to prepare shared memory of the device
+_ATTACH_TIMEOUT = 10.0
+
+class _PoolDevice:
+    def __init__(self, cfg:dict):
+        self.name = cfg["name"]
+        self.memid = cfg["memid"]
+        self.syncpipe = cfg.get("syncpipe", "")
+        self.period = cfg.get("period", 100) / 1000
+        self.sources = (cfg.get("init", ""), cfg.get("loop", ""), cfg.get("final", ""))
+        self.codes = None
+        self.device = None
+        self.ns = None
+        self.shm = None
+        self.control = None
+        self.next = 0.0
+        self.started = time()
+        self.done = False
+
+    def _error(self, stage:str):
+        print(f"Device '{self.name}': error in '{stage}' script", file=sys.stderr)
+        traceback.print_exc()
+
+    def _ready(self)->bool:
+        # Note: device control block is ready when server sets 'running' flag, before that
+        #       memory counts and device name can be not initialized yet
+        if self.control is None:
+            shm = QSharedMemory(self.memid + ".device")
+            if not shm.attach():
+                return False
+            self.shm = shm
+            self.control = cast(c_void_p(shm.data().__int__()), POINTER(CDeviceBlock)).contents
+        return bool(self.control.flags & 1)
+
+    def _start(self):
+        try:
+            self.device = _MbDevice(self.memid, _args.project, self.syncpipe)
+        except Exception:
+            self._error("attach")
+            self.done = True
+            return
+        try:
+            self.codes = (compile(self.sources[0], f"<{self.name}:Init>" , "exec"),
+                          compile(self.sources[1], f"<{self.name}:Loop>" , "exec"),
+                          compile(self.sources[2], f"<{self.name}:Final>", "exec"))
+        except SyntaxError:
+            self._error("compile")
+            self._finish(False)
+            return
+        self.ns = { "__name__": "__main__",
+                    "sys"     : sys,
+                    "path"    : path,
+                    "sleep"   : sleep,
+                    "time"    : time,
+                    "mbdevice": self.device,
+                    "mem0x"   : self.device.getmem0x(),
+                    "mem1x"   : self.device.getmem1x(),
+                    "mem3x"   : self.device.getmem3x(),
+                    "mem4x"   : self.device.getmem4x(),
+                    "_mb_time_period": self.period }
+        try:
+            exec(self.codes[0], self.ns)
+        except Exception:
+            self._error("Init")
+            self._finish(False)
+
+    def _finish(self, final:bool=True):
+        if final:
+            try:
+                exec(self.codes[2], self.ns)
+            except Exception:
+                self._error("Final")
+        if self.device is not None:
+            self.device._setfinished()
+        self.done = True
+
+    def process(self, now:float)->float:
+        """Executes one scheduling step of the device and returns the time of its next step"""
+        if self.device is None:
+            if not self._ready():
+                if now - self.started > _ATTACH_TIMEOUT:
+                    print(f"Device '{self.name}': can't attach to shared memory '{self.memid}'", file=sys.stderr)
+                    self.done = True
+                return now + 0.001
+            self._start()
+            if self.done:
+                return now
+        if not (self.control.flags & 1):
+            self._finish()
+            return now
+        if now < self.next:
+            return self.next
+        self.next = now + self.period
+        try:
+            exec(self.codes[1], self.ns)
+        except Exception:
+            self._error("Loop")
+            self._finish(False)
+            return now
+        self.device._incpycycle()
+        return self.next
+
+
+with open(_args.manifest, "r", encoding="utf-8") as _f:
+    _devices = [_PoolDevice(_cfg) for _cfg in json.load(_f)["devices"]]
+
+while _devices:
+    _now = time()
+    _next = _now + 0.001
+    for _d in _devices:
+        _t = _d.process(_now)
+        if _t < _next:
+            _next = _t
+    _devices = [_d for _d in _devices if not _d.done]
+    _wait = _next - time()
+    if _wait > 0:
+        sleep(_wait)
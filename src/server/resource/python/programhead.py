@@ -9,16 +9,18 @@ _parser.add_argument('-prj', '--project', type=str, default="")
 _parser.add_argument('-imp', '--importpath', type=str, default="")
 _parser.add_argument('-i', '--memid' , type=str, default="")
 _parser.add_argument('-p', '--period' , type=int, default=100)
-_args = _parser.parse_args()
+_parser.add_argument('-s', '--syncpipe' , type=str, default="")
+# Note: embedded interpreter passes arguments through '_mb_argv' because 'sys.argv' is shared by all scripts
+_args = _parser.parse_args(globals().get('_mb_argv'))
 
 _pathList = _args.importpath.split(";")
 
 sys.path.insert(0, path.normpath(path.dirname(path.abspath(__file__))))
-sys.path.extend(_pathList)
+sys.path.extend([_p for _p in _pathList if _p not in sys.path])
 
 from mbserver import _MbDevice
 
-mbdevice = _MbDevice(_args.memid, _args.project)
+mbdevice = _MbDevice(_args.memid, _args.project, _args.syncpipe)
 mem0x = mbdevice.getmem0x()
 mem1x = mbdevice.getmem1x()
 mem3x = mbdevice.getmem3x()
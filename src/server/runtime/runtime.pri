@@ -1,17 +1,29 @@
 HEADERS +=                              \
     $$PWD/server_portrunnable.h         \
+    $$PWD/server_replayfile.h           \
+    $$PWD/server_rundelayqueue.h        \
     $$PWD/server_rundevice.h            \
+    $$PWD/server_runimpairment.h        \
+    $$PWD/server_runscriptembedded.h    \
+    $$PWD/server_runscriptpool.h        \
     $$PWD/server_runscriptthread.h      \
     $$PWD/server_runsimaction.h         \
     $$PWD/server_runsimactiontask.h     \
     $$PWD/server_runthread.h            \
+    $$PWD/server_runwaiter.h            \
     $$PWD/server_runtime.h
 
 SOURCES +=                              \
     $$PWD/server_portrunnable.cpp       \
+    $$PWD/server_replayfile.cpp         \
+    $$PWD/server_rundelayqueue.cpp      \
     $$PWD/server_rundevice.cpp          \
+    $$PWD/server_runimpairment.cpp      \
+    $$PWD/server_runscriptembedded.cpp  \
+    $$PWD/server_runscriptpool.cpp      \
     $$PWD/server_runscriptthread.cpp    \
     $$PWD/server_runsimaction.cpp       \
     $$PWD/server_runsimactiontask.cpp   \
     $$PWD/server_runthread.cpp          \
+    $$PWD/server_runwaiter.cpp          \
     $$PWD/server_runtime.cpp
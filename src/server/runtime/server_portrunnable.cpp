@@ -22,22 +22,39 @@
 */
 #include "server_portrunnable.h"
 
+#include <cstring>
+
 #include <ModbusServerPort.h>
 #include <ModbusTcpServer.h>
+#include <ModbusServerResource.h>
+#include <ModbusPort.h>
 
 #include <server.h>
 
 #include <project/server_port.h>
 
 #include "server_rundevice.h"
+#include "server_runimpairment.h"
 
 mbServerPortRunnable::mbServerPortRunnable(mbServerPort *serverPort, const Modbus::Settings &settings, mbServerRunDevice *device, QObject *parent)
     : QObject(parent)
 {
     m_serverPort = serverPort;
     m_stat = m_serverPort->statistic();
+    m_statImpairment = m_serverPort->statImpairment();
+    m_activity = 0;
+    m_logSourceId = 0;
     m_device = device;
-    m_modbusPort = Modbus::createServerPort(device, settings);
+    ModbusInterface *iface = device;
+    mbServerPort::Impairment impairment = serverPort->impairment();
+    if (impairment.isEnabled())
+    {
+        m_impairment = new mbServerRunImpairment(device, impairment, serverPort->type());
+        iface = m_impairment;
+    }
+    else
+        m_impairment = nullptr;
+    m_modbusPort = Modbus::createServerPort(iface, settings);
     m_modbusPort->setBroadcastEnabled(serverPort->isBroadcastEnabled());
 
     // units map
@@ -76,6 +93,7 @@ mbServerPortRunnable::mbServerPortRunnable(mbServerPort *serverPort, const Modbu
 mbServerPortRunnable::~mbServerPortRunnable()
 {
     delete m_modbusPort;
+    delete m_impairment;
 }
 
 void mbServerPortRunnable::setName(const QString &name)
@@ -84,9 +102,38 @@ void mbServerPortRunnable::setName(const QString &name)
     setObjectName(name);
 }
 
+int mbServerPortRunnable::delayTimeout() const
+{
+    int timeout = m_device->delayTimeout();
+    if (m_impairment)
+    {
+        int t = m_impairment->delayTimeout();
+        if ((t >= 0) && ((timeout < 0) || (t < timeout)))
+            timeout = t;
+    }
+    return timeout;
+}
+
 void mbServerPortRunnable::run()
 {
     m_modbusPort->process();
+    if (m_impairment)
+        updateStatImpairment();
+}
+
+bool mbServerPortRunnable::appendHandles(mbServerRunWaiter::Handles_t &handles)
+{
+    // Note: ModbusLib has no public access to the listen and client sockets of TCP server,
+    //       so TCP port is polled
+    if (ModbusServerResource *res = dynamic_cast<ModbusServerResource*>(m_modbusPort))
+    {
+        if (res->isOpen())
+        {
+            handles.append(static_cast<int>((intptr_t)res->port()->handle()));
+            return true;
+        }
+    }
+    return false;
 }
 
 void mbServerPortRunnable::close()
@@ -97,49 +144,92 @@ void mbServerPortRunnable::close()
         m_modbusPort->process();
         QThread::yieldCurrentThread();
     }
+    if (m_impairment)
+    {
+        const mbServerRunImpairment::Statistic &s = m_impairment->statistic();
+        mbServer::LogInfo(name(), QString("Impairment: delayed %1, dropped %2, value corrupted %3 requests").arg(s.delayed).arg(s.dropped).arg(s.corrupted));
+    }
+}
+
+quint16 mbServerPortRunnable::logSourceId(const Modbus::Char *source)
+{
+    // Note: source is the same for most of the frames, so its id is cached to avoid string conversion for every frame
+    if (m_logSource.isNull() || strcmp(source, m_logSource.constData()))
+    {
+        m_logSource = QByteArray(source);
+        m_logSourceId = mbServer::LogSourceId(QString::fromUtf8(m_logSource));
+    }
+    return m_logSourceId;
+}
+
+void mbServerPortRunnable::updateStatImpairment()
+{
+    // Note: statistic of the run is added to the statistic of the port, so counters continue
+    //       from previous run like Tx/Rx counters
+    const mbServerRunImpairment::Statistic &s = m_impairment->statistic();
+    if ((s.delayed   == m_statImpairmentRun.delayed) &&
+        (s.dropped   == m_statImpairmentRun.dropped) &&
+        (s.corrupted == m_statImpairmentRun.corrupted))
+        return;
+    m_statImpairment.delayed   += s.delayed   - m_statImpairmentRun.delayed  ;
+    m_statImpairment.dropped   += s.dropped   - m_statImpairmentRun.dropped  ;
+    m_statImpairment.corrupted += s.corrupted - m_statImpairmentRun.corrupted;
+    m_statImpairmentRun.delayed   = s.delayed  ;
+    m_statImpairmentRun.dropped   = s.dropped  ;
+    m_statImpairmentRun.corrupted = s.corrupted;
+    m_serverPort->setStatImpairment(m_statImpairment);
 }
 
 void mbServerPortRunnable::slotBytesTx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
-    mbServer::LogTx(source, Modbus::bytesToString(buff, size).data());
+    mbServer::LogData(mb::Log_Tx, logSourceId(source), mbCoreLogRecord::Format_Bytes, buff, size);
     m_stat.countTx++;
+    m_activity++;
     m_serverPort->setStatCountTx(m_stat.countTx);
 }
 
 void mbServerPortRunnable::slotBytesRx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
-    mbServer::LogRx(source, Modbus::bytesToString(buff, size).data());
+    mbServer::LogData(mb::Log_Rx, logSourceId(source), mbCoreLogRecord::Format_Bytes, buff, size);
     m_stat.countRx++;
+    m_activity++;
     m_serverPort->setStatCountRx(m_stat.countRx);
 }
 
 void mbServerPortRunnable::slotAsciiTx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
-    mbServer::LogTx(source, Modbus::asciiToString(buff, size).data());
+    mbServer::LogData(mb::Log_Tx, logSourceId(source), mbCoreLogRecord::Format_Ascii, buff, size);
     m_stat.countTx++;
+    m_activity++;
     m_serverPort->setStatCountTx(m_stat.countTx);
 }
 
 void mbServerPortRunnable::slotAsciiRx(const Modbus::Char *source, const uint8_t* buff, uint16_t size)
 {
-    mbServer::LogRx(source, Modbus::asciiToString(buff, size).data());
+    mbServer::LogData(mb::Log_Rx, logSourceId(source), mbCoreLogRecord::Format_Ascii, buff, size);
     m_stat.countRx++;
+    m_activity++;
     m_serverPort->setStatCountRx(m_stat.countRx);
 }
 
 void mbServerPortRunnable::slotError(const Modbus::Char *source, Modbus::StatusCode status, const Modbus::Char *text)
 {
+    // Note: request dropped by impairment is not an error of the port
+    if ((status == mbServerRunImpairment::StatusDropped) && m_impairment)
+        return;
     if (status != Modbus::Status_BadSerialReadTimeout)
         mbServer::LogError(source, QString("Error(0x%1): %2").arg(QString::number(status, 16), text));
 }
 
 void mbServerPortRunnable::slotNewConnection(const Modbus::Char *source)
 {
+    m_activity++;
     mbServer::LogInfo(name(), QStringLiteral("New Connection: ") + source);
 }
 
 void mbServerPortRunnable::slotCloseConnection(const Modbus::Char *source)
 {
+    m_activity++;
     mbServer::LogInfo(name(), QStringLiteral("Close Connection: ") + source);
 }
 
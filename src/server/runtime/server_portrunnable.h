@@ -29,7 +29,10 @@
 
 #include <project/server_port.h>
 
+#include "server_runwaiter.h"
+
 class mbServerRunDevice;
+class mbServerRunImpairment;
 
 class mbServerPortRunnable : public QObject
 {
@@ -40,12 +43,27 @@ public:
 
 public:
     inline QString name() const { return objectName(); }
+    inline mbServerRunDevice *device() const { return m_device; }
     void setName(const QString &name);
+    // Returns time (milliseconds) remaining till the earliest deadline of delayed responses of the port or -1 if there is no delayed response
+    int delayTimeout() const;
     
 public:
     void run();
     void close();
 
+public:
+    // Counter is changed every time port has any Rx/Tx or connection activity
+    inline quint32 activityCounter() const { return m_activity; }
+    // Appends native descriptors of the port that can be used to wait for incoming data (serial port).
+    // Returns 'false' if activity of the port can't be waited on by descriptors
+    // (e.g. TCP port), so the port must be polled
+    bool appendHandles(mbServerRunWaiter::Handles_t &handles);
+
+private:
+    quint16 logSourceId(const Modbus::Char *source);
+    void updateStatImpairment();
+
 private Q_SLOTS:
     void slotBytesTx(const Modbus::Char *source, const uint8_t* buff, uint16_t size);
     void slotBytesRx(const Modbus::Char *source, const uint8_t* buff, uint16_t size);
@@ -58,8 +76,14 @@ private Q_SLOTS:
 private:
     mbServerPort      *m_serverPort;
     mbServerRunDevice *m_device;
+    mbServerRunImpairment *m_impairment;
     ModbusServerPort  *m_modbusPort;
     mbServerPort::Statistic m_stat;
+    mbServerPort::ImpairmentStatistic m_statImpairment;
+    mbServerPort::ImpairmentStatistic m_statImpairmentRun; // last published statistic of the current run
+    quint32 m_activity;
+    QByteArray m_logSource;
+    quint16 m_logSourceId;
 };
 
 #endif // SERVER_PORTRUNNABLE_H
@@ -0,0 +1,358 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_replayfile.h"
+
+#include <cstring>
+#include <climits>
+
+#include <QFileInfo>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define REPLAY_MAGIC "MBREPLAY"
+#define REPLAY_VERSION 1
+#define REPLAY_BINARY_SUFFIX ".mbrec"
+
+static bool parseCsvLine(const QByteArray &line, qint64 &time, QList<QByteArray> &fields)
+{
+    QByteArray s = line.trimmed();
+    if (s.isEmpty())
+        return false;
+    fields = s.split(s.contains(';') ? ';' : ',');
+    bool ok;
+    double t = fields.first().trimmed().toDouble(&ok);
+    if (!ok) // Note: header or comment line
+        return false;
+    time = static_cast<qint64>(t);
+    return true;
+}
+
+// Note: file of 'size' bytes must contain header and 'rows' of timestamp and 'columns' values (8 bytes each).
+//       Header is not trusted, so sizes are compared by division and can't overflow
+static bool isValidDataSize(quint32 columns, quint64 rows, qint64 size, qint64 headerSize)
+{
+    if ((columns < 1) || (columns > INT_MAX) || !rows || (size < headerSize))
+        return false;
+    quint64 cells = static_cast<quint64>(size - headerSize) / sizeof(qint64);
+    return rows <= cells / (static_cast<quint64>(columns) + 1);
+}
+
+QString mbServerReplayFile::binaryFileName(const QString &fileName)
+{
+    if (fileName.endsWith(REPLAY_BINARY_SUFFIX, Qt::CaseInsensitive))
+        return fileName;
+    return fileName + REPLAY_BINARY_SUFFIX;
+}
+
+bool mbServerReplayFile::isImported(const QString &fileName)
+{
+    QString binFileName = binaryFileName(fileName);
+    QFileInfo bin(binFileName);
+    if (!bin.exists())
+        return false;
+    if (binFileName == fileName)
+        return true;
+    QFileInfo src(fileName);
+    return !src.exists() || (bin.lastModified() >= src.lastModified());
+}
+
+// Note: progress is checked every 'REPLAY_PROGRESS_LINES' lines, first pass is 0-50%, second pass is 50-100%
+#define REPLAY_PROGRESS_LINES 4096
+
+static bool convertProgress(mbServerReplayFile::Progress *progress, const QFile &csv, int pass)
+{
+    if (!progress)
+        return true;
+    const qint64 size = csv.size();
+    const int percent = size ? static_cast<int>(csv.pos() * 50 / size) : 50;
+    return progress->setProgress(pass * 50 + percent);
+}
+
+bool mbServerReplayFile::convertCsv(const QString &csvFileName, const QString &binFileName, QString *error, Progress *progress)
+{
+    QFile csv(csvFileName);
+    if (!csv.open(QIODevice::ReadOnly))
+    {
+        if (error)
+            *error = QString("Can't open file '%1': %2").arg(csvFileName, csv.errorString());
+        return false;
+    }
+
+    // Note: first pass only counts rows, so binary file can be allocated once and
+    //       every column can be filled in place without keeping data in memory
+    quint64 rows = 0;
+    int columns = 0;
+    qint64 t;
+    QList<QByteArray> fields;
+    quint64 lines = 0;
+    while (!csv.atEnd())
+    {
+        if (((++lines % REPLAY_PROGRESS_LINES) == 0) && !convertProgress(progress, csv, 0))
+        {
+            if (error)
+                *error = QString("Import of file '%1' is canceled").arg(csvFileName);
+            return false;
+        }
+        if (!parseCsvLine(csv.readLine(), t, fields))
+            continue;
+        if (rows == 0)
+            columns = fields.count()-1;
+        ++rows;
+    }
+    if (!rows || (columns < 1))
+    {
+        if (error)
+            *error = QString("File '%1' doesn't contain data rows (<time>,<value1>,...,<valueN>)").arg(csvFileName);
+        return false;
+    }
+
+    QString tmpFileName = binFileName + QStringLiteral(".tmp");
+    QFile bin(tmpFileName);
+    qint64 size = static_cast<qint64>(sizeof(Header) + rows * sizeof(qint64) * (columns + 1));
+    if (!bin.open(QIODevice::ReadWrite | QIODevice::Truncate) || !bin.resize(size))
+    {
+        if (error)
+            *error = QString("Can't create file '%1': %2").arg(tmpFileName, bin.errorString());
+        return false;
+    }
+    uchar *data = bin.map(0, size);
+    if (!data)
+    {
+        if (error)
+            *error = QString("Can't map file '%1': %2").arg(tmpFileName, bin.errorString());
+        bin.close();
+        bin.remove();
+        return false;
+    }
+
+    Header *h = reinterpret_cast<Header*>(data);
+    memcpy(h->magic, REPLAY_MAGIC, sizeof(h->magic));
+    h->version = REPLAY_VERSION;
+    h->columns = static_cast<quint32>(columns);
+    h->rows = rows;
+    h->reserved = 0;
+    qint64 *times = reinterpret_cast<qint64*>(data + sizeof(Header));
+    double *values = reinterpret_cast<double*>(times + rows);
+
+    csv.seek(0);
+    quint64 row = 0;
+    qint64 first = 0;
+    bool canceled = false;
+    while (!csv.atEnd() && (row < rows))
+    {
+        if (((++lines % REPLAY_PROGRESS_LINES) == 0) && !convertProgress(progress, csv, 1))
+        {
+            canceled = true;
+            break;
+        }
+        if (!parseCsvLine(csv.readLine(), t, fields))
+            continue;
+        if (row == 0)
+            first = t;
+        t -= first;
+        // Note: timestamps must not decrease, otherwise row search doesn't work
+        if (row && (t < times[row-1]))
+            t = times[row-1];
+        times[row] = t;
+        for (int c = 0; c < columns; c++)
+        {
+            double v;
+            bool ok = false;
+            if (c+1 < fields.count())
+                v = fields.at(c+1).trimmed().toDouble(&ok);
+            if (!ok) // Note: missing value repeats previous one
+                v = row ? values[static_cast<quint64>(c)*rows+row-1] : 0.0;
+            values[static_cast<quint64>(c)*rows+row] = v;
+        }
+        ++row;
+    }
+    bin.unmap(data);
+    bin.close();
+    if (canceled)
+    {
+        if (error)
+            *error = QString("Import of file '%1' is canceled").arg(csvFileName);
+        QFile::remove(tmpFileName);
+        return false;
+    }
+    QFile::remove(binFileName);
+    if (!QFile::rename(tmpFileName, binFileName))
+    {
+        if (error)
+            *error = QString("Can't rename file '%1' to '%2'").arg(tmpFileName, binFileName);
+        QFile::remove(tmpFileName);
+        return false;
+    }
+    return true;
+}
+
+mbServerReplayFile::mbServerReplayFile()
+{
+    m_data = nullptr;
+    m_time = nullptr;
+    m_values = nullptr;
+    m_rows = 0;
+    m_columns = 0;
+}
+
+mbServerReplayFile::~mbServerReplayFile()
+{
+    close();
+}
+
+bool mbServerReplayFile::open(const QString &fileName, QString *error)
+{
+    close();
+    QString binFileName = binaryFileName(fileName);
+    if (!isImported(fileName))
+    {
+        if (error)
+            *error = QString("Recorded file '%1' is not imported or it was changed after import. "
+                             "Open settings of the action to import it").arg(fileName);
+        return false;
+    }
+
+    m_file.setFileName(binFileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        if (error)
+            *error = QString("Can't open file '%1': %2").arg(binFileName, m_file.errorString());
+        return false;
+    }
+    qint64 size = m_file.size();
+    uchar *data = (size >= static_cast<qint64>(sizeof(Header))) ? m_file.map(0, size) : nullptr;
+    const Header *h = reinterpret_cast<const Header*>(data);
+    if (!data || memcmp(h->magic, REPLAY_MAGIC, sizeof(h->magic)) || (h->version != REPLAY_VERSION) ||
+        !isValidDataSize(h->columns, h->rows, size, static_cast<qint64>(sizeof(Header))))
+    {
+        if (error)
+            *error = QString("File '%1' is not valid recorded data file").arg(binFileName);
+        if (data)
+            m_file.unmap(data);
+        m_file.close();
+        return false;
+    }
+    m_data = data;
+    m_rows = h->rows;
+    m_columns = static_cast<int>(h->columns);
+    m_time = reinterpret_cast<const qint64*>(m_data + sizeof(Header));
+    m_values = reinterpret_cast<const double*>(m_time + m_rows);
+#ifdef Q_OS_UNIX
+    posix_madvise(m_data, static_cast<size_t>(size), POSIX_MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+void mbServerReplayFile::close()
+{
+    if (m_data)
+    {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_time = nullptr;
+    m_values = nullptr;
+    m_rows = 0;
+    m_columns = 0;
+}
+
+quint64 mbServerReplayFile::findRow(qint64 time, quint64 hint) const
+{
+    if (!m_rows)
+        return 0;
+    if ((hint >= m_rows) || (m_time[hint] > time))
+        hint = 0;
+    // Note: usually time moves forward by few rows, so gallop from 'hint' first and
+    //       then make binary search within found range (it touches only few pages of the file)
+    quint64 lo = hint;
+    quint64 step = 1;
+    quint64 hi = lo + step;
+    while ((hi < m_rows) && (m_time[hi] <= time))
+    {
+        lo = hi;
+        step <<= 1;
+        hi = lo + step;
+    }
+    if (hi > m_rows)
+        hi = m_rows;
+    // invariant: time(lo) <= time, time(hi) > time or hi == rows
+    while (hi - lo > 1)
+    {
+        quint64 mid = lo + (hi - lo) / 2;
+        if (m_time[mid] <= time)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void mbServerReplayFile::prefetch(quint64 row, quint64 count) const
+{
+#ifdef Q_OS_UNIX
+    if (row >= m_rows)
+        return;
+    if (row + count > m_rows)
+        count = m_rows - row;
+    const quintptr pageMask = ~static_cast<quintptr>(sysconf(_SC_PAGESIZE) - 1);
+    for (int c = -1; c < m_columns; c++)
+    {
+        const uchar *begin = (c < 0) ? reinterpret_cast<const uchar*>(m_time + row) :
+                                       reinterpret_cast<const uchar*>(m_values + static_cast<quint64>(c)*m_rows + row);
+        quintptr p = reinterpret_cast<quintptr>(begin) & pageMask;
+        size_t len = static_cast<size_t>(reinterpret_cast<quintptr>(begin) + count * sizeof(qint64) - p);
+        posix_madvise(reinterpret_cast<void*>(p), len, POSIX_MADV_WILLNEED);
+    }
+#else
+    // Note: OS read-ahead of memory-mapped file is used as is
+    Q_UNUSED(row)
+    Q_UNUSED(count)
+#endif
+}
+
+mbServerReplayImport::mbServerReplayImport(const QString &fileName, QObject *parent) : QThread(parent),
+    m_fileName(fileName),
+    m_success(false),
+    m_percent(-1),
+    m_cancel(false)
+{
+}
+
+void mbServerReplayImport::run()
+{
+    m_success = mbServerReplayFile::convertCsv(m_fileName, mbServerReplayFile::binaryFileName(m_fileName), &m_error, this);
+}
+
+bool mbServerReplayImport::setProgress(int percent)
+{
+    if (percent != m_percent)
+    {
+        m_percent = percent;
+        Q_EMIT progressChanged(percent);
+    }
+    return !m_cancel.load();
+}
@@ -0,0 +1,130 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_REPLAYFILE_H
+#define SERVER_REPLAYFILE_H
+
+#include <atomic>
+
+#include <QFile>
+#include <QThread>
+
+// Note: recorded time-series file for 'Replay' simulation action.
+//       Source CSV file (timestamp in milliseconds + value columns) is imported once (see 'mbServerReplayImport')
+//       into compact binary columnar file which is memory-mapped while replaying, so file of any size is not
+//       loaded into RAM: only pages around current row are touched.
+//       Binary file layout:
+//          Header               (32 bytes)
+//          qint64 time[rows]    (milliseconds relative to the first row)
+//          double column0[rows]
+//          ...
+//          double columnN[rows]
+class mbServerReplayFile
+{
+public:
+    struct Header
+    {
+        char    magic[8];
+        quint32 version;
+        quint32 columns;
+        quint64 rows;
+        quint64 reserved;
+    };
+
+    // Receives progress of CSV conversion
+    class Progress
+    {
+    public:
+        virtual ~Progress() {}
+        // Returns 'false' to cancel conversion
+        virtual bool setProgress(int percent) = 0;
+    };
+
+public:
+    // Returns name of the binary file for the given recorded file: CSV file 'name.csv' is converted into 'name.csv.mbrec'
+    static QString binaryFileName(const QString &fileName);
+    // Returns 'true' if binary file of the recorded file exists and it's not older than source CSV file
+    static bool isImported(const QString &fileName);
+    // Converts CSV file into binary columnar file reading source file line by line
+    static bool convertCsv(const QString &csvFileName, const QString &binFileName, QString *error = nullptr, Progress *progress = nullptr);
+
+public:
+    mbServerReplayFile();
+    ~mbServerReplayFile();
+
+public:
+    // Opens imported binary file of the recorded file. File is never converted here (it can take minutes
+    // for big CSV file), so it fails if file is not imported (see 'isImported()')
+    bool open(const QString &fileName, QString *error = nullptr);
+    void close();
+    inline bool isOpen() const { return m_data != nullptr; }
+    inline quint64 rows() const { return m_rows; }
+    inline int columns() const { return m_columns; }
+    inline qint64 duration() const { return m_rows ? m_time[m_rows-1] : 0; }
+    inline qint64 time(quint64 row) const { return m_time[row]; }
+    inline double value(int column, quint64 row) const { return m_values[static_cast<quint64>(column)*m_rows+row]; }
+    // Returns the last row with 'time(row) <= time' starting search from 'hint' row (usually previous found row)
+    quint64 findRow(qint64 time, quint64 hint) const;
+    // Advises OS to read ahead pages of 'count' rows starting from 'row' for timestamps and all columns
+    void prefetch(quint64 row, quint64 count) const;
+
+private:
+    QFile m_file;
+    uchar *m_data;
+    const qint64 *m_time;
+    const double *m_values;
+    quint64 m_rows;
+    int m_columns;
+};
+
+// Note: converts CSV file into binary file of 'mbServerReplayFile' in separate thread,
+//       so caller (GUI) stays responsive and can show progress and cancel conversion
+class mbServerReplayImport : public QThread, public mbServerReplayFile::Progress
+{
+    Q_OBJECT
+public:
+    explicit mbServerReplayImport(const QString &fileName, QObject *parent = nullptr);
+
+public:
+    inline QString fileName() const { return m_fileName; }
+    inline bool isSuccess() const { return m_success; }
+    inline QString errorString() const { return m_error; }
+
+public Q_SLOTS:
+    void cancel() { m_cancel.store(true); }
+
+Q_SIGNALS:
+    void progressChanged(int percent);
+
+protected:
+    void run() override;
+    bool setProgress(int percent) override;
+
+private:
+    QString m_fileName;
+    QString m_error;
+    bool m_success;
+    int m_percent;
+    std::atomic<bool> m_cancel;
+};
+
+#endif // SERVER_REPLAYFILE_H
@@ -0,0 +1,128 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_rundelayqueue.h"
+
+// Time (milliseconds) after which delayed request which is not repeated anymore is removed
+// (e.g. connection was closed while request was delayed)
+#define DELAY_STALE_TIMEOUT 1000
+
+mbServerRunDelayQueue::Key mbServerRunDelayQueue::key(uint8_t unit, uint8_t func, uint16_t p1, uint16_t p2, uint16_t p3, const void *buffer)
+{
+    Key k;
+    k.buffer = buffer;
+    k.params = (static_cast<quint64>(unit) << 56) | (static_cast<quint64>(func) << 48) |
+               (static_cast<quint64>(p1) << 32) | (static_cast<quint64>(p2) << 16) | static_cast<quint64>(p3);
+    return k;
+}
+
+mbServerRunDelayQueue::mbServerRunDelayQueue()
+{
+    m_sweepTime = 0;
+}
+
+mbServerRunDelayQueue::State mbServerRunDelayQueue::state(const Key &key, mb::Timestamp_t now)
+{
+    auto it = m_items.find(key);
+    if (it != m_items.end())
+    {
+        // Note: request left by closed connection must not be served immediately
+        //       when new connection repeats it with the same buffer
+        if ((now - it.value().touched) <= DELAY_STALE_TIMEOUT)
+        {
+            it.value().touched = now;
+            return (now < it.value().deadline) ? Waiting : Elapsed;
+        }
+        eraseDeadline(key, it.value().deadline);
+        m_items.erase(it);
+    }
+    // Note: requests that are not repeated anymore are forgotten not more often than once per stale timeout
+    if ((now - m_sweepTime) > DELAY_STALE_TIMEOUT)
+        sweep(now);
+    return New;
+}
+
+void mbServerRunDelayQueue::insert(const Key &key, mb::Timestamp_t deadline, mb::Timestamp_t now)
+{
+    auto it = m_items.find(key);
+    if (it != m_items.end())
+    {
+        eraseDeadline(key, it.value().deadline);
+        it.value().deadline = deadline;
+        it.value().touched = now;
+    }
+    else
+    {
+        Item item;
+        item.deadline = deadline;
+        item.touched = now;
+        m_items.insert(key, item);
+    }
+    m_deadlines.insert(deadline, key);
+}
+
+void mbServerRunDelayQueue::remove(const Key &key)
+{
+    auto it = m_items.find(key);
+    if (it != m_items.end())
+    {
+        eraseDeadline(key, it.value().deadline);
+        m_items.erase(it);
+    }
+}
+
+int mbServerRunDelayQueue::timeout(mb::Timestamp_t now) const
+{
+    // Note: elapsed requests are not taken into account: thread processes port right after the wait
+    //       anyway, and request can stay elapsed for a long time (e.g. while device delays it too)
+    auto it = m_deadlines.upperBound(now);
+    if (it == m_deadlines.cend())
+        return -1;
+    return static_cast<int>(it.key() - now);
+}
+
+void mbServerRunDelayQueue::eraseDeadline(const Key &key, mb::Timestamp_t deadline)
+{
+    for (auto it = m_deadlines.find(deadline); (it != m_deadlines.end()) && (it.key() == deadline); ++it)
+    {
+        if (it.value() == key)
+        {
+            m_deadlines.erase(it);
+            return;
+        }
+    }
+}
+
+void mbServerRunDelayQueue::sweep(mb::Timestamp_t now)
+{
+    m_sweepTime = now;
+    for (auto it = m_items.begin(); it != m_items.end(); )
+    {
+        if ((now - it.value().touched) > DELAY_STALE_TIMEOUT)
+        {
+            eraseDeadline(it.key(), it.value().deadline);
+            it = m_items.erase(it);
+        }
+        else
+            ++it;
+    }
+}
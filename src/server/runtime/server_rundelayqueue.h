@@ -0,0 +1,89 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNDELAYQUEUE_H
+#define SERVER_RUNDELAYQUEUE_H
+
+#include <QHash>
+#include <QMultiMap>
+
+#include <mbcore.h>
+
+// Note: deadlines of the requests which responses are delayed.
+//       ModbusLib repeats the same call of the interface function (with the same parameters and
+//       the same buffer that belongs to connection) while it gets 'Status_Processing', so request
+//       is identified by its parameters and buffer, and every connection and unit gets its own deadline.
+//       Limitation: ModbusLib doesn't pass connection into interface functions and functions with values
+//       in parameters ('writeSingleCoil', 'writeSingleRegister', 'maskWriteRegister') have no buffer,
+//       so the same such requests of different TCP connections that are delayed at once share one deadline
+class mbServerRunDelayQueue
+{
+public:
+    enum State
+    {
+        New,     // request is not in queue
+        Waiting, // deadline of the request is not reached yet
+        Elapsed  // deadline is reached, request stays in queue till 'remove()'
+    };
+
+    struct Key
+    {
+        const void *buffer;
+        quint64 params; // unit, function and its parameters packed together
+
+        inline bool operator==(const Key &other) const { return (buffer == other.buffer) && (params == other.params); }
+        friend inline uint qHash(const Key &key, uint seed = 0) { return ::qHash(key.buffer, seed) ^ ::qHash(key.params, seed); }
+    };
+
+    static Key key(uint8_t unit, uint8_t func, uint16_t p1, uint16_t p2, uint16_t p3, const void *buffer);
+
+public:
+    mbServerRunDelayQueue();
+
+public:
+    State state(const Key &key, mb::Timestamp_t now);
+    void insert(const Key &key, mb::Timestamp_t deadline, mb::Timestamp_t now);
+    void remove(const Key &key);
+    inline bool isEmpty() const { return m_items.isEmpty(); }
+    // Returns time (milliseconds) remaining till the earliest deadline that is not reached yet or -1 if there is no such request
+    int timeout(mb::Timestamp_t now) const;
+
+private:
+    typedef QMultiMap<mb::Timestamp_t, Key> Deadlines_t;
+
+    struct Item
+    {
+        mb::Timestamp_t deadline;
+        mb::Timestamp_t touched; // time of last repeat of the request (used to remove requests of closed connections)
+    };
+
+    void eraseDeadline(const Key &key, mb::Timestamp_t deadline);
+    void sweep(mb::Timestamp_t now);
+
+private:
+    QHash<Key, Item> m_items;
+    // Note: deadlines are ordered beside the hash, so the earliest deadline is found without scanning of all requests
+    Deadlines_t m_deadlines;
+    mb::Timestamp_t m_sweepTime;
+};
+
+#endif // SERVER_RUNDELAYQUEUE_H
@@ -29,25 +29,20 @@ mbServerRunDevice::mbServerRunDevice()
     const Modbus::Defaults &d = Modbus::Defaults::instance();
     m_settings.isBroadcastEnabled = d.isBroadcastEnabled;
     memset(m_units, 0, sizeof(m_units));
-    m_timestamp = 0;
+    m_random.seed(std::random_device()());
 }
 
 mbServerRunDevice::~mbServerRunDevice()
 {
 }
 
-#define CHECK_DELAY                                                 \
-    uint delay = device->delay();                                   \
-    if (delay > 0)                                                  \
-    {                                                               \
-        if (m_timestamp == 0)                                       \
-        {                                                           \
-            m_timestamp = mb::currentTimestamp();                   \
-            return Modbus::Status_Processing;                       \
-        }                                                           \
-        if ((mb::currentTimestamp()-m_timestamp) < delay)           \
-            return Modbus::Status_Processing;                       \
-        m_timestamp = 0; /* Note: clear timestamp for next use */   \
+// Note: parameters of the request are used to identify the request while it's repeated by ModbusLib.
+//       Functions without buffer pass 'nullptr' (see limitation of 'mbServerRunDelayQueue')
+#define CHECK_DELAY(func, p1, p2, p3, buffer)                                           \
+    if (device->delay() || device->delayJitter())                                       \
+    {                                                                                   \
+        if (!isDelayElapsed(device, unit, func, p1, p2, p3, buffer))                    \
+            return Modbus::Status_Processing;                                           \
     }
 
 Modbus::StatusCode mbServerRunDevice::readCoils(uint8_t unit, uint16_t offset, uint16_t count, void *values)
@@ -61,7 +56,7 @@ Modbus::StatusCode mbServerRunDevice::readCoils(uint8_t unit, uint16_t offset, u
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_READ_COILS, offset, count, 0, values)
         return device->readCoils(offset, count, values);
     }
 }
@@ -77,7 +72,7 @@ Modbus::StatusCode mbServerRunDevice::readDiscreteInputs(uint8_t unit, uint16_t
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_READ_DISCRETE_INPUTS, offset, count, 0, values)
         return device->readDiscreteInputs(offset, count, values);
     }
 }
@@ -93,7 +88,7 @@ Modbus::StatusCode mbServerRunDevice::readHoldingRegisters(uint8_t unit, uint16_
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_READ_HOLDING_REGISTERS, offset, count, 0, values)
         return device->readHoldingRegisters(offset, count, values);
     }
 }
@@ -109,7 +104,7 @@ Modbus::StatusCode mbServerRunDevice::readInputRegisters(uint8_t unit, uint16_t
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_READ_INPUT_REGISTERS, offset, count, 0, values)
         return device->readInputRegisters(offset, count, values);
     }
 }
@@ -127,7 +122,7 @@ Modbus::StatusCode mbServerRunDevice::writeSingleCoil(uint8_t unit, uint16_t off
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_WRITE_SINGLE_COIL, offset, value, 0, nullptr)
         return device->writeSingleCoil(offset, value);
     }
 }
@@ -145,7 +140,7 @@ Modbus::StatusCode mbServerRunDevice::writeSingleRegister(uint8_t unit, uint16_t
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_WRITE_SINGLE_REGISTER, offset, value, 0, nullptr)
         return device->writeSingleRegister(offset, value);
     }
 }
@@ -161,7 +156,7 @@ Modbus::StatusCode mbServerRunDevice::readExceptionStatus(uint8_t unit, uint8_t
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_READ_EXCEPTION_STATUS, 0, 0, 0, status)
         return device->readExceptionStatus(status);
     }
 }
@@ -179,7 +174,7 @@ Modbus::StatusCode mbServerRunDevice::writeMultipleCoils(uint8_t unit, uint16_t
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_WRITE_MULTIPLE_COILS, offset, count, 0, values)
         return device->writeMultipleCoils(offset, count, values);
     }
 }
@@ -197,7 +192,7 @@ Modbus::StatusCode mbServerRunDevice::writeMultipleRegisters(uint8_t unit, uint1
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_WRITE_MULTIPLE_REGISTERS, offset, count, 0, values)
         return device->writeMultipleRegisters(offset, count, values);
     }
 }
@@ -213,7 +208,7 @@ Modbus::StatusCode mbServerRunDevice::reportServerID(uint8_t unit, uint8_t *coun
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_REPORT_SERVER_ID, 0, 0, 0, data)
         return device->reportServerID(count, data);
     }
 }
@@ -231,7 +226,7 @@ Modbus::StatusCode mbServerRunDevice::maskWriteRegister(uint8_t unit, uint16_t o
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
+        CHECK_DELAY(MBF_MASK_WRITE_REGISTER, offset, andMask, orMask, nullptr)
         return device->maskWriteRegister(offset, andMask, orMask);
     }
 }
@@ -251,8 +246,8 @@ Modbus::StatusCode mbServerRunDevice::readWriteMultipleRegisters(uint8_t unit, u
         mbServerDevice *device = this->device(unit);
         if (!device)
             return Modbus::Status_BadGatewayPathUnavailable;
-        CHECK_DELAY
-            return device->readWriteMultipleRegisters(readOffset, readCount, readValues, writeOffset, writeCount, writeValues);
+        CHECK_DELAY(MBF_READ_WRITE_MULTIPLE_REGISTERS, readOffset, readCount, writeOffset, readValues)
+        return device->readWriteMultipleRegisters(readOffset, readCount, readValues, writeOffset, writeCount, writeValues);
     }
 }
 
@@ -262,3 +257,51 @@ void mbServerRunDevice::setDevice(uint8_t unit, mbServerDevice *device)
     m_unitNumbers.insert(unit);
     m_devices.insert(device);
 }
+
+int mbServerRunDevice::delayTimeout() const
+{
+    return m_delayQueue.timeout(mb::currentTimestamp());
+}
+
+bool mbServerRunDevice::isDelayElapsed(mbServerDevice *device, uint8_t unit, uint8_t func, uint16_t p1, uint16_t p2, uint16_t p3, const void *buffer)
+{
+    mbServerRunDelayQueue::Key key = mbServerRunDelayQueue::key(unit, func, p1, p2, p3, buffer);
+    mb::Timestamp_t now = mb::currentTimestamp();
+    switch (m_delayQueue.state(key, now))
+    {
+    case mbServerRunDelayQueue::Waiting:
+        return false;
+    case mbServerRunDelayQueue::Elapsed:
+        m_delayQueue.remove(key);
+        return true;
+    default:
+        break;
+    }
+    mb::Timestamp_t delay = delayValue(device);
+    if (delay <= 0)
+        return true;
+    m_delayQueue.insert(key, now + delay, now);
+    return false;
+}
+
+mb::Timestamp_t mbServerRunDevice::delayValue(mbServerDevice *device)
+{
+    double delay = device->delay();
+    double jitter = device->delayJitter();
+    if (jitter > 0)
+    {
+        switch (device->delayDistribution())
+        {
+        case mbServerDevice::DelayNormal:
+            delay += std::normal_distribution<double>(0, jitter)(m_random);
+            break;
+        case mbServerDevice::DelayExponential:
+            delay += std::exponential_distribution<double>(1.0/jitter)(m_random);
+            break;
+        default:
+            delay += std::uniform_real_distribution<double>(-jitter, jitter)(m_random);
+            break;
+        }
+    }
+    return (delay > 0) ? static_cast<mb::Timestamp_t>(delay + 0.5) : 0;
+}
@@ -23,9 +23,13 @@
 #ifndef SERVER_RUNDEVICE_H
 #define SERVER_RUNDEVICE_H
 
+#include <random>
+
 #include <QSet>
 #include <mbcore.h>
 
+#include "server_rundelayqueue.h"
+
 class mbServerDevice;
 
 class mbServerRunDevice : public ModbusInterface
@@ -59,6 +63,14 @@ public:
     inline mbServerDevice *device(uint8_t unit) const { return m_units[unit]; }
     void setDevice(uint8_t unit, mbServerDevice *device);
 
+public: // delayed responses
+    // Returns time (milliseconds) remaining till the earliest deadline of delayed requests or -1 if there is no delayed request
+    int delayTimeout() const;
+
+private:
+    bool isDelayElapsed(mbServerDevice *device, uint8_t unit, uint8_t func, uint16_t p1, uint16_t p2, uint16_t p3, const void *buffer);
+    mb::Timestamp_t delayValue(mbServerDevice *device);
+
 private:
     struct
     {
@@ -70,7 +82,10 @@ private: // devices
     mbServerDevice *m_units[UnitsSize];
     QSet<mbServerDevice*> m_devices;
     QSet<uint8_t> m_unitNumbers;
-    mb::Timestamp_t m_timestamp;
+
+private: // delayed responses
+    mbServerRunDelayQueue m_delayQueue;
+    std::mt19937 m_random;
 };
 
 #endif // SERVER_RUNDEVICE_H
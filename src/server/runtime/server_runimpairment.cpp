@@ -0,0 +1,197 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runimpairment.h"
+
+// Count of bits that are transferred for every byte of the frame (start bit + 8 data bits + stop bit)
+#define IMPAIR_BITS_PER_BYTE 10
+
+// Note: functions without buffer pass 'nullptr' (see limitation of 'mbServerRunDelayQueue')
+#define IMPAIR_BEGIN(func, p1, p2, p3, buffer, requestPdu, responsePdu)                        \
+    mbServerRunDelayQueue::Key key = mbServerRunDelayQueue::key(unit, func, p1, p2, p3, buffer); \
+    Modbus::StatusCode r = begin(key, requestPdu, responsePdu);                                  \
+    if (r != Modbus::Status_Good)                                                                \
+        return r;
+
+mbServerRunImpairment::mbServerRunImpairment(ModbusInterface *device, const mbServerPort::Impairment &impairment, Modbus::ProtocolType type)
+{
+    m_device = device;
+    m_impairment = impairment;
+    m_type = type;
+    m_linkFree = 0;
+    m_random.seed(std::random_device()());
+}
+
+Modbus::StatusCode mbServerRunImpairment::readCoils(uint8_t unit, uint16_t offset, uint16_t count, void *values)
+{
+    IMPAIR_BEGIN(MBF_READ_COILS, offset, count, 0, values, 5, 2+(count+7)/8)
+    r = m_device->readCoils(unit, offset, count, values);
+    return end(key, r, values, (count+7)/8);
+}
+
+Modbus::StatusCode mbServerRunImpairment::readDiscreteInputs(uint8_t unit, uint16_t offset, uint16_t count, void *values)
+{
+    IMPAIR_BEGIN(MBF_READ_DISCRETE_INPUTS, offset, count, 0, values, 5, 2+(count+7)/8)
+    r = m_device->readDiscreteInputs(unit, offset, count, values);
+    return end(key, r, values, (count+7)/8);
+}
+
+Modbus::StatusCode mbServerRunImpairment::readHoldingRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    IMPAIR_BEGIN(MBF_READ_HOLDING_REGISTERS, offset, count, 0, values, 5, 2+count*2)
+    r = m_device->readHoldingRegisters(unit, offset, count, values);
+    return end(key, r, values, count*2);
+}
+
+Modbus::StatusCode mbServerRunImpairment::readInputRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    IMPAIR_BEGIN(MBF_READ_INPUT_REGISTERS, offset, count, 0, values, 5, 2+count*2)
+    r = m_device->readInputRegisters(unit, offset, count, values);
+    return end(key, r, values, count*2);
+}
+
+Modbus::StatusCode mbServerRunImpairment::writeSingleCoil(uint8_t unit, uint16_t offset, bool value)
+{
+    IMPAIR_BEGIN(MBF_WRITE_SINGLE_COIL, offset, value, 0, nullptr, 5, 5)
+    r = m_device->writeSingleCoil(unit, offset, value);
+    return end(key, r, nullptr, 0);
+}
+
+Modbus::StatusCode mbServerRunImpairment::writeSingleRegister(uint8_t unit, uint16_t offset, uint16_t value)
+{
+    IMPAIR_BEGIN(MBF_WRITE_SINGLE_REGISTER, offset, value, 0, nullptr, 5, 5)
+    r = m_device->writeSingleRegister(unit, offset, value);
+    return end(key, r, nullptr, 0);
+}
+
+Modbus::StatusCode mbServerRunImpairment::readExceptionStatus(uint8_t unit, uint8_t *status)
+{
+    IMPAIR_BEGIN(MBF_READ_EXCEPTION_STATUS, 0, 0, 0, status, 1, 2)
+    r = m_device->readExceptionStatus(unit, status);
+    return end(key, r, status, 1);
+}
+
+Modbus::StatusCode mbServerRunImpairment::writeMultipleCoils(uint8_t unit, uint16_t offset, uint16_t count, const void *values)
+{
+    IMPAIR_BEGIN(MBF_WRITE_MULTIPLE_COILS, offset, count, 0, values, 6+(count+7)/8, 5)
+    r = m_device->writeMultipleCoils(unit, offset, count, values);
+    return end(key, r, nullptr, 0);
+}
+
+Modbus::StatusCode mbServerRunImpairment::writeMultipleRegisters(uint8_t unit, uint16_t offset, uint16_t count, const uint16_t *values)
+{
+    IMPAIR_BEGIN(MBF_WRITE_MULTIPLE_REGISTERS, offset, count, 0, values, 6+count*2, 5)
+    r = m_device->writeMultipleRegisters(unit, offset, count, values);
+    return end(key, r, nullptr, 0);
+}
+
+Modbus::StatusCode mbServerRunImpairment::reportServerID(uint8_t unit, uint8_t *count, uint8_t *data)
+{
+    // Note: size of the response is unknown before device is called, so typical size is used
+    IMPAIR_BEGIN(MBF_REPORT_SERVER_ID, 0, 0, 0, data, 1, 20)
+    r = m_device->reportServerID(unit, count, data);
+    return end(key, r, data, (r == Modbus::Status_Good) ? *count : 0);
+}
+
+Modbus::StatusCode mbServerRunImpairment::maskWriteRegister(uint8_t unit, uint16_t offset, uint16_t andMask, uint16_t orMask)
+{
+    IMPAIR_BEGIN(MBF_MASK_WRITE_REGISTER, offset, andMask, orMask, nullptr, 7, 7)
+    r = m_device->maskWriteRegister(unit, offset, andMask, orMask);
+    return end(key, r, nullptr, 0);
+}
+
+Modbus::StatusCode mbServerRunImpairment::readWriteMultipleRegisters(uint8_t unit, uint16_t readOffset, uint16_t readCount, uint16_t *readValues, uint16_t writeOffset, uint16_t writeCount, const uint16_t *writeValues)
+{
+    IMPAIR_BEGIN(MBF_READ_WRITE_MULTIPLE_REGISTERS, readOffset, readCount, writeOffset, readValues, 10+writeCount*2, 2+readCount*2)
+    r = m_device->readWriteMultipleRegisters(unit, readOffset, readCount, readValues, writeOffset, writeCount, writeValues);
+    return end(key, r, readValues, readCount*2);
+}
+
+Modbus::StatusCode mbServerRunImpairment::begin(const mbServerRunDelayQueue::Key &key, uint requestPdu, uint responsePdu)
+{
+    mb::Timestamp_t now = mb::currentTimestamp();
+    switch (m_queue.state(key, now))
+    {
+    case mbServerRunDelayQueue::Waiting:
+        return Modbus::Status_Processing;
+    case mbServerRunDelayQueue::Elapsed:
+        return Modbus::Status_Good; // Note: request stays in queue while device processes it (device can delay it too)
+    default:
+        break;
+    }
+
+    if (chance(m_impairment.loss))
+    {
+        ++m_stat.dropped;
+        return StatusDropped;
+    }
+
+    double latency = m_impairment.latency;
+    if (m_impairment.jitter)
+        latency += std::uniform_real_distribution<double>(-static_cast<double>(m_impairment.jitter), m_impairment.jitter)(m_random);
+    mb::Timestamp_t deadline = now + ((latency > 0) ? static_cast<mb::Timestamp_t>(latency + 0.5) : 0);
+    if (m_impairment.baudRate)
+    {
+        // Note: emulated link transfers one frame at a time, so frames of all connections
+        //       of the port are queued one after another
+        mb::Timestamp_t start = qMax(now, m_linkFree);
+        m_linkFree = start + transferTime(requestPdu) + transferTime(responsePdu);
+        deadline = qMax(deadline, m_linkFree);
+    }
+    m_queue.insert(key, deadline, now);
+    if (deadline > now)
+    {
+        ++m_stat.delayed;
+        return Modbus::Status_Processing;
+    }
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode mbServerRunImpairment::end(const mbServerRunDelayQueue::Key &key, Modbus::StatusCode status, void *data, uint size)
+{
+    if (status == Modbus::Status_Processing)
+        return status;
+    m_queue.remove(key);
+    if ((status == Modbus::Status_Good) && data && size && chance(m_impairment.corruption))
+    {
+        // Note: this is value corruption, not link error: frame checksum is calculated by ModbusLib
+        //       after device is processed, so client gets valid frame with wrong value.
+        //       ModbusLib gives no access to the framed bytes before they are sent
+        uint8_t *bytes = reinterpret_cast<uint8_t*>(data);
+        uint i = std::uniform_int_distribution<uint>(0, size-1)(m_random);
+        bytes[i] ^= static_cast<uint8_t>(1 << std::uniform_int_distribution<int>(0, 7)(m_random));
+        ++m_stat.corrupted;
+    }
+    return status;
+}
+
+mb::Timestamp_t mbServerRunImpairment::transferTime(uint pduSize) const
+{
+    uint bytes;
+    switch (m_type)
+    {
+    case Modbus::RTU: bytes = 1 + pduSize + 2; break;           // unit + PDU + CRC
+    case Modbus::ASC: bytes = 1 + (1 + pduSize + 1) * 2 + 2; break; // ':' + hex(unit + PDU + LRC) + CRLF
+    default         : bytes = 7 + pduSize; break;               // MBAP header + PDU
+    }
+    return static_cast<mb::Timestamp_t>(bytes) * IMPAIR_BITS_PER_BYTE * 1000 / m_impairment.baudRate;
+}
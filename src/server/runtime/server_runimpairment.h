@@ -0,0 +1,93 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNIMPAIRMENT_H
+#define SERVER_RUNIMPAIRMENT_H
+
+#include <random>
+
+#include <mbcore.h>
+
+#include <project/server_port.h>
+
+#include "server_rundelayqueue.h"
+
+// Note: Modbus interface that stays between server port and its devices and simulates bad network link:
+//       latency with jitter, lost requests, corrupted response values and limited bit rate.
+//       Response is delayed by returning 'Status_Processing' (ModbusLib repeats the call later),
+//       so impaired port never blocks the thread and other ports served by it
+class mbServerRunImpairment : public ModbusInterface
+{
+public:
+    struct Statistic
+    {
+        Statistic() : delayed(0), dropped(0), corrupted(0) {}
+        quint32 delayed;
+        quint32 dropped;
+        quint32 corrupted; // responses with corrupted value
+    };
+
+    // Status returned for the lost request: it's not standard Modbus exception,
+    // so ModbusLib sends no response and client gets timeout
+    static const Modbus::StatusCode StatusDropped = Modbus::Status_BadEmptyResponse;
+
+public:
+    mbServerRunImpairment(ModbusInterface *device, const mbServerPort::Impairment &impairment, Modbus::ProtocolType type);
+
+public:
+    inline const Statistic &statistic() const { return m_stat; }
+    // Returns time (milliseconds) remaining till the earliest deadline of delayed requests or -1 if there is no delayed request
+    inline int delayTimeout() const { return m_queue.timeout(mb::currentTimestamp()); }
+
+public: // Modbus::Interface
+    Modbus::StatusCode readCoils(uint8_t unit, uint16_t offset, uint16_t count, void *values) override;
+    Modbus::StatusCode readDiscreteInputs(uint8_t unit, uint16_t offset, uint16_t count, void *values) override;
+    Modbus::StatusCode readHoldingRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override;
+    Modbus::StatusCode readInputRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override;
+    Modbus::StatusCode writeSingleCoil(uint8_t unit, uint16_t offset, bool value) override;
+    Modbus::StatusCode writeSingleRegister(uint8_t unit, uint16_t offset, uint16_t value) override;
+    Modbus::StatusCode readExceptionStatus(uint8_t unit, uint8_t *status) override;
+    Modbus::StatusCode writeMultipleCoils(uint8_t unit, uint16_t offset, uint16_t count, const void *values) override;
+    Modbus::StatusCode writeMultipleRegisters(uint8_t unit, uint16_t offset, uint16_t count, const uint16_t *values) override;
+    Modbus::StatusCode reportServerID(uint8_t unit, uint8_t *count, uint8_t *data) override;
+    Modbus::StatusCode maskWriteRegister(uint8_t unit, uint16_t offset, uint16_t andMask, uint16_t orMask) override;
+    Modbus::StatusCode readWriteMultipleRegisters(uint8_t unit, uint16_t readOffset, uint16_t readCount, uint16_t *readValues, uint16_t writeOffset, uint16_t writeCount, const uint16_t *writeValues) override;
+
+private:
+    // Returns 'Status_Good' when request can be passed to the device
+    Modbus::StatusCode begin(const mbServerRunDelayQueue::Key &key, uint requestPdu, uint responsePdu);
+    // Completes the request and corrupts value in 'size' bytes of response data if needed
+    Modbus::StatusCode end(const mbServerRunDelayQueue::Key &key, Modbus::StatusCode status, void *data, uint size);
+    mb::Timestamp_t transferTime(uint pduSize) const;
+    inline bool chance(double percent) { return (percent > 0) && (std::uniform_real_distribution<double>(0, 100)(m_random) < percent); }
+
+private:
+    ModbusInterface *m_device;
+    mbServerPort::Impairment m_impairment;
+    Modbus::ProtocolType m_type;
+    mbServerRunDelayQueue m_queue;
+    mb::Timestamp_t m_linkFree; // time when emulated link finishes transfer of previous frames
+    std::mt19937 m_random;
+    Statistic m_stat;
+};
+
+#endif // SERVER_RUNIMPAIRMENT_H
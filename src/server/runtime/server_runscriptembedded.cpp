@@ -0,0 +1,330 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifdef MB_PYTHON_EMBEDDED
+// Note: Python.h must be included before any standard headers
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#endif // MB_PYTHON_EMBEDDED
+
+#include "server_runscriptembedded.h"
+
+#include <QMutex>
+#include <QHash>
+
+#include <server.h>
+
+typedef QHash<QString, mbServerDevice::MemoryBlock*> MemoryBlocks_t;
+
+static QMutex s_memoryBlocksMutex;
+static MemoryBlocks_t s_memoryBlocks;
+
+#ifdef MB_PYTHON_EMBEDDED
+
+static const char *MemoryBlockCapsuleName = "_mbembedded.memblock";
+
+static mbServerDevice::MemoryBlock *capsuleMemoryBlock(PyObject *capsule)
+{
+    return static_cast<mbServerDevice::MemoryBlock*>(PyCapsule_GetPointer(capsule, MemoryBlockCapsuleName));
+}
+
+// memblock(key) -> memory block object (capsule) or None if block with shared memory 'key' is not registered
+static PyObject *mbEmbeddedMemBlock(PyObject *, PyObject *args)
+{
+    const char *key;
+    if (!PyArg_ParseTuple(args, "s", &key))
+        return nullptr;
+    mbServerDevice::MemoryBlock *block;
+    s_memoryBlocksMutex.lock();
+    block = s_memoryBlocks.value(QString::fromUtf8(key));
+    s_memoryBlocksMutex.unlock();
+    if (!block)
+        Py_RETURN_NONE;
+    return PyCapsule_New(block, MemoryBlockCapsuleName, nullptr);
+}
+
+// memget(block, byteoffset, count) -> bytes
+static PyObject *mbEmbeddedMemGet(PyObject *, PyObject *args)
+{
+    PyObject *capsule;
+    Py_ssize_t offset, count;
+    if (!PyArg_ParseTuple(args, "Onn", &capsule, &offset, &count))
+        return nullptr;
+    mbServerDevice::MemoryBlock *block = capsuleMemoryBlock(capsule);
+    if (!block)
+        return nullptr;
+    if (offset < 0 || count < 0)
+    {
+        PyErr_SetString(PyExc_IndexError, "Memory index out of range");
+        return nullptr;
+    }
+    PyObject *res = PyBytes_FromStringAndSize(nullptr, count);
+    if (!res)
+        return nullptr;
+    char *buff = PyBytes_AS_STRING(res);
+    memset(buff, 0, static_cast<size_t>(count)); // Note: part out of memory range is not filled by memGet()
+    Py_BEGIN_ALLOW_THREADS
+    block->memGet(static_cast<uint>(offset), buff, static_cast<size_t>(count));
+    Py_END_ALLOW_THREADS
+    return res;
+}
+
+// memset(block, byteoffset, data, mask=None): writes bits of 'data' that are set in 'mask' (all bits if 'mask' is None)
+static PyObject *mbEmbeddedMemSet(PyObject *, PyObject *args)
+{
+    PyObject *capsule;
+    Py_ssize_t offset;
+    Py_buffer data;
+    PyObject *mask = Py_None;
+    if (!PyArg_ParseTuple(args, "Ony*|O", &capsule, &offset, &data, &mask))
+        return nullptr;
+    mbServerDevice::MemoryBlock *block = capsuleMemoryBlock(capsule);
+    if (!block || offset < 0)
+    {
+        if (block)
+            PyErr_SetString(PyExc_IndexError, "Memory index out of range");
+        PyBuffer_Release(&data);
+        return nullptr;
+    }
+    Py_buffer m;
+    QByteArray fullMask;
+    const void *pmask;
+    const bool hasMask = (mask != Py_None);
+    if (!hasMask)
+    {
+        fullMask.fill('\xFF', static_cast<int>(data.len));
+        pmask = fullMask.constData();
+    }
+    else
+    {
+        if (PyObject_GetBuffer(mask, &m, PyBUF_SIMPLE) < 0)
+        {
+            PyBuffer_Release(&data);
+            return nullptr;
+        }
+        if (m.len < data.len)
+        {
+            PyErr_SetString(PyExc_ValueError, "Mask is shorter than data");
+            PyBuffer_Release(&m);
+            PyBuffer_Release(&data);
+            return nullptr;
+        }
+        pmask = m.buf;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    block->memSetMask(static_cast<uint>(offset), data.buf, pmask, static_cast<size_t>(data.len));
+    Py_END_ALLOW_THREADS
+    if (hasMask)
+        PyBuffer_Release(&m);
+    PyBuffer_Release(&data);
+    Py_RETURN_NONE;
+}
+
+// memcommit(block, byteoffset, value, orig, bitmask): writes only bytes of 'value' that differ from 'orig'
+// (only changed bits if 'bitmask' is true), so concurrent changes of other values are not overwritten
+static PyObject *mbEmbeddedMemCommit(PyObject *, PyObject *args)
+{
+    PyObject *capsule;
+    Py_ssize_t offset;
+    Py_buffer value, orig;
+    int bitmask;
+    if (!PyArg_ParseTuple(args, "Ony*y*p", &capsule, &offset, &value, &orig, &bitmask))
+        return nullptr;
+    mbServerDevice::MemoryBlock *block = capsuleMemoryBlock(capsule);
+    if (!block || offset < 0 || orig.len < value.len)
+    {
+        if (block)
+            PyErr_SetString(PyExc_ValueError, "Invalid memory range");
+        PyBuffer_Release(&orig);
+        PyBuffer_Release(&value);
+        return nullptr;
+    }
+    const uint8_t *v = static_cast<const uint8_t*>(value.buf);
+    const uint8_t *o = static_cast<const uint8_t*>(orig.buf);
+    const Py_ssize_t len = value.len;
+    Py_ssize_t beg = 0;
+    while (beg < len && v[beg] == o[beg])
+        ++beg;
+    Py_ssize_t end = len;
+    while (end > beg && v[end-1] == o[end-1])
+        --end;
+    if (beg < end)
+    {
+        QByteArray mask(static_cast<int>(end-beg), Qt::Uninitialized);
+        uint8_t *m = reinterpret_cast<uint8_t*>(mask.data());
+        for (Py_ssize_t i = beg; i < end; i++)
+        {
+            uint8_t x = v[i] ^ o[i];
+            m[i-beg] = bitmask ? x : (x ? 0xFF : 0);
+        }
+        Py_BEGIN_ALLOW_THREADS
+        block->memSetMask(static_cast<uint>(offset+beg), v+beg, m, static_cast<size_t>(end-beg));
+        Py_END_ALLOW_THREADS
+    }
+    PyBuffer_Release(&orig);
+    PyBuffer_Release(&value);
+    Py_RETURN_NONE;
+}
+
+static PyObject *mbEmbeddedOutput(PyObject *, PyObject *args)
+{
+    const char *text;
+    if (!PyArg_ParseTuple(args, "s", &text))
+        return nullptr;
+    mbServer::OutputMessage(QString::fromUtf8(text));
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef mbEmbeddedMethods[] =
+{
+    {"output"   , mbEmbeddedOutput   , METH_VARARGS, "Print text into server output window"},
+    {"memblock" , mbEmbeddedMemBlock , METH_VARARGS, "Get device memory block by shared memory key"},
+    {"memget"   , mbEmbeddedMemGet   , METH_VARARGS, "Read bytes of device memory"},
+    {"memset"   , mbEmbeddedMemSet   , METH_VARARGS, "Write bytes of device memory by mask"},
+    {"memcommit", mbEmbeddedMemCommit, METH_VARARGS, "Write changed bytes of device memory"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+static PyModuleDef mbEmbeddedModule =
+{
+    PyModuleDef_HEAD_INIT, "_mbembedded", nullptr, -1, mbEmbeddedMethods, nullptr, nullptr, nullptr, nullptr
+};
+
+static PyObject *mbEmbeddedInit()
+{
+    return PyModule_Create(&mbEmbeddedModule);
+}
+
+static void ensureInterpreter()
+{
+    static QMutex mutex;
+    static bool initialized = false;
+
+    QMutexLocker _(&mutex);
+    if (initialized)
+        return;
+    PyImport_AppendInittab("_mbembedded", &mbEmbeddedInit);
+    Py_InitializeEx(0); // Note: signal handlers of the server are not changed
+    // Note: output of all scripts goes into server output window like output of external process
+    PyRun_SimpleString("import sys, _mbembedded\n"
+                       "class _MbEmbeddedOutput:\n"
+                       "    def write(self, s):\n"
+                       "        if s:\n"
+                       "            _mbembedded.output(s)\n"
+                       "        return len(s)\n"
+                       "    def flush(self):\n"
+                       "        pass\n"
+                       "sys.stdout = sys.stderr = _MbEmbeddedOutput()\n");
+    // Note: GIL is released so script threads can take it.
+    //       Interpreter is never finalized because extension modules (e.g. PyQt5) can't be reinitialized
+    PyEval_SaveThread();
+    initialized = true;
+}
+
+#endif // MB_PYTHON_EMBEDDED
+
+mbServerRunScriptEmbedded::mbServerRunScriptEmbedded(const QString &scriptFile, const QStringList &args, QObject *parent) : QThread(parent),
+    m_scriptFile(scriptFile),
+    m_args(args),
+    m_threadId(0)
+{
+}
+
+bool mbServerRunScriptEmbedded::isSupported()
+{
+#ifdef MB_PYTHON_EMBEDDED
+    return true;
+#else
+    return false;
+#endif
+}
+
+void mbServerRunScriptEmbedded::registerMemoryBlock(const QString &key, mbServerDevice::MemoryBlock *block)
+{
+    QMutexLocker _(&s_memoryBlocksMutex);
+    s_memoryBlocks.insert(key, block);
+}
+
+void mbServerRunScriptEmbedded::unregisterMemoryBlock(const QString &key)
+{
+    QMutexLocker _(&s_memoryBlocksMutex);
+    s_memoryBlocks.remove(key);
+}
+
+void mbServerRunScriptEmbedded::interrupt()
+{
+#ifdef MB_PYTHON_EMBEDDED
+    if (!m_threadId.load())
+        return;
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    // Note: thread id is changed only by script thread which holds GIL, so it's stable here
+    unsigned long threadId = m_threadId.load();
+    if (threadId)
+        PyThreadState_SetAsyncExc(threadId, PyExc_SystemExit);
+    PyGILState_Release(gstate);
+#endif
+}
+
+void mbServerRunScriptEmbedded::run()
+{
+#ifdef MB_PYTHON_EMBEDDED
+    ensureInterpreter();
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    m_threadId = PyThread_get_thread_ident();
+
+    // Note: every script has its own global namespace, so scripts of different devices don't interfere.
+    //       Command line arguments are passed through '_mb_argv' because 'sys.argv' is shared
+    PyObject *globals = PyDict_New();
+    PyDict_SetItemString(globals, "__builtins__", PyEval_GetBuiltins());
+    PyObject *v = PyUnicode_FromString("__main__");
+    PyDict_SetItemString(globals, "__name__", v);
+    Py_DECREF(v);
+    v = PyUnicode_FromString(m_scriptFile.toUtf8().constData());
+    PyDict_SetItemString(globals, "__file__", v);
+    Py_DECREF(v);
+    PyObject *argv = PyList_New(0);
+    Q_FOREACH (const QString &arg, m_args)
+    {
+        v = PyUnicode_FromString(arg.toUtf8().constData());
+        PyList_Append(argv, v);
+        Py_DECREF(v);
+    }
+    PyDict_SetItemString(globals, "_mb_argv", argv);
+    Py_DECREF(argv);
+
+    PyObject *r = PyRun_String("exec(compile(open(__file__, encoding='utf-8').read(), __file__, 'exec'))",
+                               Py_file_input, globals, globals);
+    if (r)
+        Py_DECREF(r);
+    else if (PyErr_ExceptionMatches(PyExc_SystemExit))
+        PyErr_Clear(); // Note: PyErr_Print() would exit the whole server process
+    else
+        PyErr_Print();
+    PyDict_Clear(globals);
+    Py_DECREF(globals);
+
+    m_threadId = 0;
+    PyGILState_Release(gstate);
+#else
+    mbServer::LogError("Python", QStringLiteral("Server is built without embedded Python interpreter"));
+#endif
+}
@@ -0,0 +1,66 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSCRIPTEMBEDDED_H
+#define SERVER_RUNSCRIPTEMBEDDED_H
+
+#include <atomic>
+
+#include <QThread>
+#include <QStringList>
+
+#include <project/server_device.h>
+
+// Runs device Python script within the server process using embedded CPython interpreter.
+// Script gets the same command line arguments as external Python process, so it's alternative
+// to start separate 'QProcess' interpreter. Device memory blocks registered by 'registerMemoryBlock()'
+// are accessed by script directly through '_mbembedded' module (see 'mbserver.py'),
+// shared memory is used only for device settings, flags and read-only views.
+// Interpreter is initialized once (on first use) and is shared by all script threads.
+// It's available only when server is built with 'MB_PYTHON_EMBEDDED' definition.
+class mbServerRunScriptEmbedded : public QThread
+{
+public:
+    explicit mbServerRunScriptEmbedded(const QString &scriptFile, const QStringList &args, QObject *parent = nullptr);
+
+public:
+    // Returns 'true' if server is built with embedded Python interpreter
+    static bool isSupported();
+    // Makes device memory block available for embedded scripts by shared memory 'key' of the block.
+    // Block must stay alive while any script that got it is running
+    static void registerMemoryBlock(const QString &key, mbServerDevice::MemoryBlock *block);
+    static void unregisterMemoryBlock(const QString &key);
+
+public:
+    // Raises 'SystemExit' within running script, used when script doesn't finish itself
+    void interrupt();
+
+protected:
+    void run() override;
+
+private:
+    QString m_scriptFile;
+    QStringList m_args;
+    std::atomic<unsigned long> m_threadId;
+};
+
+#endif // SERVER_RUNSCRIPTEMBEDDED_H
@@ -0,0 +1,173 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runscriptpool.h"
+
+#include <QEventLoop>
+#include <QProcess>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <core_filemanager.h>
+
+#include <server.h>
+#include <project/server_project.h>
+
+#include "server_runscriptthread.h"
+
+mbServerRunScriptPool::mbServerRunScriptPool(const QList<mbServerRunScriptThread*> &threads, int workerCount, QObject *parent) : QThread{parent}
+{
+    m_ctrlRun = true;
+    m_pyInterpreter = mbServer::global()->scriptDefaultExecutable();
+    m_project = mbServer::global()->project()->absoluteFilePath();
+    if (threads.count())
+        m_importPath = threads.first()->importPath();
+
+    if (workerCount <= 0)
+        workerCount = QThread::idealThreadCount();
+    if (workerCount > threads.count())
+        workerCount = threads.count();
+
+    // Note: manifests are prepared here (not in 'run') because sources are taken from the script
+    //       threads which belongs to the GUI thread until they are started
+    QVector<QJsonArray> devices(workerCount);
+    for (int i = 0; i < threads.count(); i++)
+    {
+        mbServerRunScriptThread *t = threads.at(i);
+        QJsonObject dev;
+        dev[QStringLiteral("name"    )] = t->device()->name();
+        dev[QStringLiteral("memid"   )] = t->memId();
+        dev[QStringLiteral("syncpipe")] = t->syncPipePath();
+        dev[QStringLiteral("period"  )] = t->scriptLoopPeriod();
+        dev[QStringLiteral("init"    )] = t->scriptInit();
+        dev[QStringLiteral("loop"    )] = t->scriptLoop();
+        dev[QStringLiteral("final"   )] = t->scriptFinal();
+        devices[i % workerCount].append(dev);
+    }
+    for (int i = 0; i < workerCount; i++)
+    {
+        QJsonObject manifest;
+        manifest[QStringLiteral("devices")] = devices.at(i);
+        m_manifests.append(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+    }
+    moveToThread(this);
+}
+
+void mbServerRunScriptPool::run()
+{
+    QEventLoop eloop;
+    mbCoreFileManager *fileManager = mbServer::global()->fileManager();
+
+    QFile hostfile;
+    if (!fileManager->createTemporaryFile(QStringLiteral("poolhost.py"), hostfile, QIODevice::WriteOnly))
+    {
+        mbServer::LogError("Python", QStringLiteral("Can't create file 'poolhost.py' to start Python worker pool"));
+        return;
+    }
+    QFile qrcfile(":/server/python/poolhost.py");
+    qrcfile.open(QIODevice::ReadOnly);
+    hostfile.write(qrcfile.readAll());
+    qrcfile.close();
+    hostfile.close();
+    hostfile.open(QIODevice::ReadOnly); // Note: to prevent file deletion
+    const QString pyscript = QFileInfo(hostfile).absoluteFilePath();
+
+    const mb::Timestamp_t timeoutStartStop = 1000;
+    QList<QFile*> files;
+    QList<QProcess*> workers;
+    for (int i = 0; i < m_manifests.count(); i++)
+    {
+        QString manifestFileName = QString("poolhost_%1.json").arg(i+1);
+        QFile *file = new QFile;
+        files.append(file);
+        if (!fileManager->createTemporaryFile(manifestFileName, *file, QIODevice::WriteOnly))
+        {
+            mbServer::LogError("Python", QString("Can't create manifest file '%1' of Python worker %2").arg(manifestFileName).arg(i+1));
+            continue;
+        }
+        file->write(m_manifests.at(i));
+        file->close();
+        file->open(QIODevice::ReadOnly); // Note: to prevent file deletion
+
+        QStringList args;
+        args << QStringLiteral("-u") << pyscript
+             << "--project"    << m_project
+             << "--importpath" << m_importPath
+             << "--manifest"   << QFileInfo(*file).absoluteFilePath();
+
+        QProcess *py = new QProcess;
+        py->setProcessChannelMode(QProcess::MergedChannels);
+        connect(py, &QProcess::readyReadStandardOutput, py, [py]()
+        {
+            mbServer::OutputMessage(QString::fromUtf8(py->readAllStandardOutput()));
+        });
+        mbServer::LogDebug("Python", QString("Try start worker %1 '%2' with args '%3'").arg(i+1).arg(m_pyInterpreter, args.join(' ')));
+        py->start(m_pyInterpreter, args);
+        workers.append(py);
+    }
+
+    // Wait for start
+    mb::Timestamp_t tm = mb::currentTimestamp();
+    for (int i = 0; i < workers.count(); i++)
+    {
+        QProcess *py = workers.at(i);
+        while (m_ctrlRun && (py->state() == QProcess::Starting) && (mb::currentTimestamp()-tm < timeoutStartStop))
+        {
+            eloop.processEvents();
+            mb::msleep(1);
+        }
+        if (py->state() != QProcess::Running)
+            mbServer::LogError("Python", QString("Can't start Python worker process '%1'").arg(py->program()));
+    }
+    mbServer::LogInfo("Python", QString("Python worker pool started: %1 process(es)").arg(workers.count()));
+
+    // Note: pool thread only forwards output of the workers, so it's enough to check events with small delay
+    while (m_ctrlRun)
+    {
+        eloop.processEvents();
+        mb::msleep(10);
+    }
+
+    // Note: worker exits itself when all of its devices are stopped and their 'Final' scripts are executed
+    tm = mb::currentTimestamp();
+    const mb::Timestamp_t timeoutStop = timeoutStartStop * 2;
+    Q_FOREACH (QProcess *py, workers)
+    {
+        while ((py->state() != QProcess::NotRunning) && (mb::currentTimestamp()-tm < timeoutStop))
+        {
+            eloop.processEvents();
+            mb::msleep(1);
+        }
+        if (py->state() != QProcess::NotRunning)
+        {
+            mbServer::LogError("Python", QString("Can't stop Python worker process '%1'. Killing it").arg(py->program()));
+            py->kill();
+            py->waitForFinished(static_cast<int>(timeoutStartStop));
+        }
+    }
+    eloop.processEvents();
+    qDeleteAll(workers);
+    qDeleteAll(files);
+}
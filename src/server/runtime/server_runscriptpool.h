@@ -0,0 +1,57 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNSCRIPTPOOL_H
+#define SERVER_RUNSCRIPTPOOL_H
+
+#include <QThread>
+#include <QStringList>
+
+class mbServerRunScriptThread;
+
+// Runs Python scripts of many devices within a few shared worker processes instead of
+// separate interpreter process per device. Every worker executes 'poolhost.py' with manifest
+// of its devices (Init, Loop and Final sources, shared memory id, sync pipe and loop period)
+// and schedules them cooperatively. Devices are assigned to workers round-robin.
+// Memory of every device is still synchronized by its own 'mbServerRunScriptThread'
+// which must be switched into pooled mode (see 'mbServerRunScriptThread::setPooled').
+class mbServerRunScriptPool : public QThread
+{
+public:
+    explicit mbServerRunScriptPool(const QList<mbServerRunScriptThread*> &threads, int workerCount, QObject *parent = nullptr);
+
+public:
+    inline int workerCount() const { return m_manifests.count(); }
+    inline void stop() { m_ctrlRun = false; }
+
+protected:
+    void run() override;
+
+private:
+    bool m_ctrlRun;
+    QString m_pyInterpreter;
+    QString m_importPath;
+    QString m_project;
+    QList<QByteArray> m_manifests;
+};
+
+#endif // SERVER_RUNSCRIPTPOOL_H
@@ -6,6 +6,7 @@
 #include <QEventLoop>
 #include <QFile>
 #include <QFileInfo>
+#include <QDir>
 #include <QDebug>
 
 #include <server.h>
@@ -13,6 +14,8 @@
 #include <project/server_project.h>
 #include <project/server_device.h>
 
+#include "server_runscriptembedded.h"
+
 typedef struct
 {
     uint32_t flags;
@@ -32,28 +35,98 @@ typedef struct
 typedef struct
 {
     uint32_t pycycle;
+    uint32_t pyflags; // Note: bit 0 is set by pooled worker when device script is finished
 } PythonBlock;
 
 
+// Note: shared memory block has lock-free layout:
+//       [header][mem: memBytes][out: memBytes][mask: memBytes][pages: pageCount*4][acks: pageCount*4]
+//       'mem' is written only by server (seqlock: 'seq' is odd while 'mem' is being changed).
+//       'out', 'mask', 'pages' and 'changeCounter' are written only by Python script: it puts changed bytes
+//       into 'out' and 'mask', stamps changed pages with new counter value and then publishes the counter.
+//       Page stamp is writer seqlock: counter is always even and page is stamped with odd value while script
+//       changes its 'out' and 'mask', so server skips such page and applies copy of the page only
+//       if its stamp wasn't changed while it was copied (multibyte value is never applied partially).
+//       'acks' is written only by server: page is acknowledged when its changes are applied to device memory
+//       and device memory is copied back into 'mem'.
+//       Python script can't use memory barriers, so lock-free access is used only on x86 (strong memory ordering).
+//       When 'MemoryBlockLocked' flag is set (by server on other CPUs or by script itself) both sides
+//       access memory block under QSharedMemory lock
+enum MemoryBlockFlag
+{
+    MemoryBlockLocked = 0x00000001
+};
+
 typedef struct
 {
+    uint32_t seq;
     uint32_t changeCounter;
-    uint32_t changeByteOffset;
-    uint32_t changeByteCount;
-    uint32_t dummy;
+    uint32_t memBytes;
+    uint32_t pageBytes;
+    uint32_t pageCount;
+    uint32_t flags;
+    uint32_t dummy[2];
 } MemoryBlockHeader;
 
 struct MemWork
 {
     mbServerDevice::MemoryBlock *devMemBlock;
     uint devMemChangeCounter;
+    uint32_t memBytes;
+    uint32_t pageCount;
     QSharedMemory *shm;
     MemoryBlockHeader *shmHeader;
     uint8_t *shmMem;
+    uint8_t *shmOut;
     uint8_t *shmMask;
+    uint32_t *shmPages;
+    uint32_t *shmAcks;
     uint32_t changeCounter;
+    QVector<uint32_t> acks;
+    bool acked;
 };
 
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "std::atomic<uint32_t> must have the same size as uint32_t");
+
+inline std::atomic<uint32_t> &shmAtomic(uint32_t &value)
+{
+    return *reinterpret_cast<std::atomic<uint32_t>*>(&value);
+}
+
+inline size_t shmMemBlockSize(uint32_t memBytes)
+{
+    const uint32_t pageCount = (memBytes + mbServerDevice::MemoryBlock::PageBytes - 1) / mbServerDevice::MemoryBlock::PageBytes;
+    return sizeof(MemoryBlockHeader) + ((memBytes*3 + 3) & ~3u) + pageCount*sizeof(uint32_t)*2;
+}
+
+void initMemWork(MemWork &w, QSharedMemory &shm, mbServerDevice::MemoryBlock *devMemBlock, uint32_t memBytes)
+{
+    const uint32_t pageCount = (memBytes + mbServerDevice::MemoryBlock::PageBytes - 1) / mbServerDevice::MemoryBlock::PageBytes;
+    uint8_t *data = reinterpret_cast<uint8_t*>(shm.data());
+    memset(data, 0, shmMemBlockSize(memBytes)); // Note: shared memory can be left from previous run
+    w.devMemBlock = devMemBlock;
+    w.memBytes = memBytes;
+    w.pageCount = pageCount;
+    w.shm = &shm;
+    w.shmHeader = reinterpret_cast<MemoryBlockHeader*>(data);
+    w.shmMem  = data + sizeof(MemoryBlockHeader);
+    w.shmOut  = w.shmMem + memBytes;
+    w.shmMask = w.shmOut + memBytes;
+    w.shmPages = reinterpret_cast<uint32_t*>(data + sizeof(MemoryBlockHeader) + ((memBytes*3 + 3) & ~3u));
+    w.shmAcks = w.shmPages + pageCount;
+    w.shmHeader->memBytes = memBytes;
+    w.shmHeader->pageBytes = mbServerDevice::MemoryBlock::PageBytes;
+    w.shmHeader->pageCount = pageCount;
+#ifndef Q_PROCESSOR_X86
+    w.shmHeader->flags = MemoryBlockLocked;
+#endif
+    w.changeCounter = 0;
+    w.acks.fill(0, static_cast<int>(pageCount));
+    w.acked = false;
+    w.devMemChangeCounter = devMemBlock->changeCounter();
+    devMemBlock->memGet(0, w.shmMem, memBytes);
+}
+
 QSharedMemory::SharedMemoryError initMem(QSharedMemory &mem, size_t size)
 {
     mem.create(static_cast<int>(size));
@@ -91,22 +164,39 @@ mbServerRunScriptThread::mbServerRunScriptThread(mbServerDevice *device, const M
     const mbServerDevice::Strings &s = mbServerDevice::Strings::instance();
     m_deviceName = m_device->name().toUtf8();
     m_ctrlRun = true;
+    m_waiting = false;
     m_settingImportPath = mbServer::global()->scriptImportPath();
     m_pyInterpreter = mbServer::global()->scriptDefaultExecutable();
     m_scriptUseOptimization = mbServer::global()->scriptUseOptimization();
     m_scriptLoopPeriod = mbServer::global()->scriptLoopPeriod();
+    m_scriptEmbedded = mbServer::global()->scriptEmbedded();
+    m_pooled = false;
+    m_memId = QString("ModbusTools.Server.%1.%2").arg(getProcessIdString(), m_device->name());
+    m_syncPipePath = QDir::temp().filePath(QString("ModbusTools.Server.%1.%2.sync").arg(getProcessIdString()).arg(reinterpret_cast<quintptr>(m_device), 0, 16));
     moveToThread(this);
     m_scriptInit  = scripts.value(s.scriptInit ).toString();
     m_scriptLoop  = scripts.value(s.scriptLoop ).toString();
     m_scriptFinal = scripts.value(s.scriptFinal).toString();
 }
 
+void mbServerRunScriptThread::memoryChanged()
+{
+    // Note: wake up only when thread is going to sleep, so frequent device
+    //       changes don't cost a system call each
+    if (m_waiting.exchange(false))
+        m_waiter.wakeup();
+}
+
+// Max time (milliseconds) to wait for memory changes when Python script can notify
+// about its changes through the pipe. Otherwise script memory is checked every millisecond
+#define SYNC_WAIT_TIMEOUT 10
+
 void mbServerRunScriptThread::run()
 {
     QEventLoop eloop;
     mbCoreFileManager *fileManager = mbServer::global()->fileManager();
 
-    const QString prefix = QString("ModbusTools.Server.%1.%2").arg(getProcessIdString(), m_device->name());
+    const QString &prefix = m_memId;
 
     const QString sMemDev = prefix+QStringLiteral(".device");
     const QString sMemPy  = prefix+QStringLiteral(".python");
@@ -126,10 +216,10 @@ void mbServerRunScriptThread::run()
     int szMemDev = sizeof(DeviceBlock)+szMemDevStringTable;
     initMem(memDev, szMemDev);
     initMem(memPy, sizeof(PythonBlock));
-    initMem(mem0x, sizeof(MemoryBlockHeader)+m_device->count_0x_bytes()*2);
-    initMem(mem1x, sizeof(MemoryBlockHeader)+m_device->count_1x_bytes()*2);
-    initMem(mem3x, sizeof(MemoryBlockHeader)+m_device->count_3x_bytes()*2);
-    initMem(mem4x, sizeof(MemoryBlockHeader)+m_device->count_4x_bytes()*2);
+    initMem(mem0x, shmMemBlockSize(static_cast<uint32_t>(m_device->count_0x_bytes())));
+    initMem(mem1x, shmMemBlockSize(static_cast<uint32_t>(m_device->count_1x_bytes())));
+    initMem(mem3x, shmMemBlockSize(static_cast<uint32_t>(m_device->count_3x_bytes())));
+    initMem(mem4x, shmMemBlockSize(static_cast<uint32_t>(m_device->count_4x_bytes())));
 
     DeviceBlock *devMem = reinterpret_cast<DeviceBlock*>(memDev.data());
     devMem->count0x = m_device->count_0x();
@@ -145,46 +235,28 @@ void mbServerRunScriptThread::run()
     memcpy(ptrDevMemStringTable, m_deviceName.data(), m_deviceName.size());
     ptrDevMemStringTable[m_deviceName.size()] = 0;
 
-    MemWork memWork[4];
-
-    memWork[0].devMemBlock = &m_device->memBlockRef_0x();
-    memWork[1].devMemBlock = &m_device->memBlockRef_1x();
-    memWork[2].devMemBlock = &m_device->memBlockRef_3x();
-    memWork[3].devMemBlock = &m_device->memBlockRef_4x();
-
-    memWork[0].shm = &mem0x;
-    memWork[1].shm = &mem1x;
-    memWork[2].shm = &mem3x;
-    memWork[3].shm = &mem4x;
-
-    memWork[0].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem0x.data());
-    memWork[1].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem1x.data());
-    memWork[2].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem3x.data());
-    memWork[3].shmHeader = reinterpret_cast<MemoryBlockHeader*>(mem4x.data());
-
-    memWork[0].shmMem = reinterpret_cast<uint8_t*>(mem0x.data())+sizeof(MemoryBlockHeader);
-    memWork[1].shmMem = reinterpret_cast<uint8_t*>(mem1x.data())+sizeof(MemoryBlockHeader);
-    memWork[2].shmMem = reinterpret_cast<uint8_t*>(mem3x.data())+sizeof(MemoryBlockHeader);
-    memWork[3].shmMem = reinterpret_cast<uint8_t*>(mem4x.data())+sizeof(MemoryBlockHeader);
-
-    memWork[0].shmMask = reinterpret_cast<uint8_t*>(mem0x.data())+sizeof(MemoryBlockHeader)+m_device->count_0x_bytes();
-    memWork[1].shmMask = reinterpret_cast<uint8_t*>(mem1x.data())+sizeof(MemoryBlockHeader)+m_device->count_1x_bytes();
-    memWork[2].shmMask = reinterpret_cast<uint8_t*>(mem3x.data())+sizeof(MemoryBlockHeader)+m_device->count_3x_bytes();
-    memWork[3].shmMask = reinterpret_cast<uint8_t*>(mem4x.data())+sizeof(MemoryBlockHeader)+m_device->count_4x_bytes();
-
-    memWork[0].changeCounter = memWork[0].shmHeader->changeCounter;
-    memWork[1].changeCounter = memWork[1].shmHeader->changeCounter;
-    memWork[2].changeCounter = memWork[2].shmHeader->changeCounter;
-    memWork[3].changeCounter = memWork[3].shmHeader->changeCounter;
+    PythonBlock *pyMem = reinterpret_cast<PythonBlock*>(memPy.data());
+    pyMem->pycycle = 0;
+    pyMem->pyflags = 0;
 
     // Initialize memory
-    for (int i = 0; i < 4; i++)
+    MemWork memWork[4];
+    initMemWork(memWork[0], mem0x, &m_device->memBlockRef_0x(), static_cast<uint32_t>(m_device->count_0x_bytes()));
+    initMemWork(memWork[1], mem1x, &m_device->memBlockRef_1x(), static_cast<uint32_t>(m_device->count_1x_bytes()));
+    initMemWork(memWork[2], mem3x, &m_device->memBlockRef_3x(), static_cast<uint32_t>(m_device->count_3x_bytes()));
+    initMemWork(memWork[3], mem4x, &m_device->memBlockRef_4x(), static_cast<uint32_t>(m_device->count_4x_bytes()));
+
+    // Pipe which is used by Python script to notify about its memory changes
+    mbServerRunNotifyPipe pipe;
+    mbServerRunWaiter::Handles_t handles;
+    int waitTimeout = 1;
+    if (mbServerRunWaiter::isHandlesSupported())
     {
-        memWork[i].devMemChangeCounter = memWork[i].devMemBlock->changeCounter();
-        QSharedMemory &shm = *memWork[i].shm;
-        shm.lock();
-        memWork[i].devMemBlock->memGet(0, memWork[i].shmMem, memWork[i].devMemBlock->sizeBytes());
-        shm.unlock();
+        if (pipe.open(m_syncPipePath))
+        {
+            handles.append(pipe.handle());
+            waitTimeout = SYNC_WAIT_TIMEOUT;
+        }
     }
 
     qDebug() << "Control: key =" << memDev.key() << " nativeKey =" << memDev.nativeKey();
@@ -193,13 +265,18 @@ void mbServerRunScriptThread::run()
     //devMem->flags = 0;
     m_ctrlRun = true;
 
+    // Note: pooled script is executed by one of the shared worker processes (see mbServerRunScriptPool),
+    //       so this thread only synchronizes device memory with shared memory
     QString scriptFileName = QString("script_%1.py").arg(m_device->name());
     QFile scriptfile;
-    bool res;
-    if (m_scriptUseOptimization)
-        res = fileManager->getFile(scriptFileName, scriptfile, QIODevice::ReadOnly);
-    else
-        res = fileManager->createTemporaryFile(scriptFileName, scriptfile, QIODevice::WriteOnly);
+    bool res = true;
+    if (!m_pooled)
+    {
+        if (m_scriptUseOptimization)
+            res = fileManager->getFile(scriptFileName, scriptfile, QIODevice::ReadOnly);
+        else
+            res = fileManager->createTemporaryFile(scriptFileName, scriptfile, QIODevice::WriteOnly);
+    }
     if (!res)
     {
         mbServer::LogError("Python", QString("Can't create file '%1' to start Python script process").arg(scriptFileName));
@@ -232,74 +309,225 @@ void mbServerRunScriptThread::run()
 
     QString pyscript = QFileInfo(scriptfile).absoluteFilePath();
     QString pyfile = m_pyInterpreter;
-    QString importPath = getImportPath();
+    QString importPath = this->importPath();
     QStringList args;
-    args << "-u"
-         << pyscript
-         << "--project"    << mbServer::global()->project()->absoluteFilePath()
+    args << "--project"    << mbServer::global()->project()->absoluteFilePath()
          << "--importpath" << importPath
          << "--memid"      << prefix
          << "--period"     << QString::number(m_scriptLoopPeriod);
+    if (pipe.isOpen())
+        args << "--syncpipe" << pipe.path();
 
     mb::Timestamp_t tm;
     const mb::Timestamp_t timeoutStartStop = 1000;
+    const mb::Timestamp_t tmStart = mb::currentTimestamp();
+    mb::Timestamp_t tmFirstCycle = 0;
+    const QString mode = m_pooled ? QStringLiteral("pool") : (m_scriptEmbedded ? QStringLiteral("embedded") : QStringLiteral("process"));
 
     QProcess py;
     m_py = &py;
-    //py.setProcessChannelMode(QProcess::ForwardedChannels);
-
-    py.setProcessChannelMode(QProcess::MergedChannels);
-    connect(m_py, &QProcess::readyReadStandardOutput, this, &mbServerRunScriptThread::readPyStdOut);
-    mbServer::LogDebug("Python", QString("Try start process '%1' with args '%2'").arg(pyfile, args.join(' ')));
-    py.start(pyfile, args);
-
-    // Wait for start
-    tm = mb::currentTimestamp();
-    while (m_ctrlRun && (py.state() != QProcess::Running) && (mb::currentTimestamp()-tm < timeoutStartStop))
+    mbServerRunScriptEmbedded *embedded = nullptr;
+    const QString memKeys[4] = { sMem0x, sMem1x, sMem3x, sMem4x };
+    if (m_pooled)
+        mbServer::LogDebug("Python", QString("Script of device '%1' is executed by worker pool").arg(m_device->name()));
+    else if (m_scriptEmbedded)
     {
-        eloop.processEvents();
-        mb::msleep(1);
+        mbServer::LogDebug("Python", QString("Try start embedded script '%1' with args '%2'").arg(pyscript, args.join(' ')));
+        if (mbServerRunScriptEmbedded::isSupported())
+        {
+            // Note: embedded script reads and writes device memory directly,
+            //       shared memory blocks are still updated for read-only views of the script
+            for (int i = 0; i < 4; i++)
+                mbServerRunScriptEmbedded::registerMemoryBlock(memKeys[i], memWork[i].devMemBlock);
+            embedded = new mbServerRunScriptEmbedded(pyscript, args);
+            embedded->start();
+        }
+        else
+        {
+            mbServer::LogError("Python", QStringLiteral("Server is built without embedded Python interpreter"));
+            m_ctrlRun = false;
+        }
     }
-
-    if (py.state() != QProcess::Running)
+    else
     {
-        mbServer::LogError("Python", QString("Can't start process '%1'").arg(py.program()));
-        m_ctrlRun = false;
+        //py.setProcessChannelMode(QProcess::ForwardedChannels);
+        py.setProcessChannelMode(QProcess::MergedChannels);
+        connect(m_py, &QProcess::readyReadStandardOutput, this, &mbServerRunScriptThread::readPyStdOut);
+        args.prepend(pyscript);
+        args.prepend(QStringLiteral("-u"));
+        mbServer::LogDebug("Python", QString("Try start process '%1' with args '%2'").arg(pyfile, args.join(' ')));
+        py.start(pyfile, args);
+
+        // Wait for start
+        tm = mb::currentTimestamp();
+        while (m_ctrlRun && (py.state() != QProcess::Running) && (mb::currentTimestamp()-tm < timeoutStartStop))
+        {
+            eloop.processEvents();
+            mb::msleep(1);
+        }
+
+        if (py.state() != QProcess::Running)
+        {
+            mbServer::LogError("Python", QString("Can't start process '%1'").arg(py.program()));
+            m_ctrlRun = false;
+        }
     }
 
+    for (int i = 0; i < 4; i++)
+        memWork[i].devMemBlock->setListener(this);
+
     // Main Loop
+    // Note: only changed memory ranges are copied in both directions. Thread sleeps until device memory
+    //       is changed, Python script notifies about its changes through the pipe or timeout is expired.
+    //       Shared memory is not locked on x86: every region has single writer (see MemoryBlockHeader)
     while (m_ctrlRun)
     {
         eloop.processEvents();
         for (int i = 0; i < 4; i++)
         {
-            QSharedMemory &shm = *memWork[i].shm;
-            MemoryBlockHeader *head = memWork[i].shmHeader;
-            shm.lock();
-            if (memWork[i].changeCounter != head->changeCounter)
+            MemWork &w = memWork[i];
+            MemoryBlockHeader *head = w.shmHeader;
+            const bool locked = shmAtomic(head->flags).load(std::memory_order_acquire) & MemoryBlockLocked;
+            if (locked)
+                w.shm->lock();
+            uint32_t changeCounter = shmAtomic(head->changeCounter).load(std::memory_order_acquire);
+            if (w.changeCounter != changeCounter)
+            {
+                bool busy = false;
+                for (uint32_t p = 0; p < w.pageCount; p++)
+                {
+                    std::atomic<uint32_t> &stamp = shmAtomic(w.shmPages[p]);
+                    uint32_t gen = stamp.load(std::memory_order_acquire);
+                    if (gen == w.acks[p])
+                        continue;
+                    if (gen & 1)
+                    {
+                        busy = true; // Note: page is being written by script, it's applied on the next cycle
+                        continue;
+                    }
+                    uint32_t byteOffset = p * mbServerDevice::MemoryBlock::PageBytes;
+                    uint32_t c = mbServerDevice::MemoryBlock::PageBytes;
+                    if (byteOffset + c > w.memBytes)
+                        c = w.memBytes - byteOffset;
+                    uint8_t out[mbServerDevice::MemoryBlock::PageBytes];
+                    uint8_t mask[mbServerDevice::MemoryBlock::PageBytes];
+                    memcpy(out, w.shmOut+byteOffset, c);
+                    memcpy(mask, w.shmMask+byteOffset, c);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (stamp.load(std::memory_order_relaxed) != gen)
+                    {
+                        busy = true;
+                        continue;
+                    }
+                    w.devMemBlock->memSetMask(byteOffset, out, mask, c);
+                    w.acks[p] = gen;
+                    w.acked = true;
+                }
+                if (!busy)
+                    w.changeCounter = changeCounter;
+            }
+            if (w.devMemChangeCounter != w.devMemBlock->changeCounter())
             {
-                //qDebug() << "New Header:" << head->changeCounter << ". Offset:" << head->changeByteOffset << ". Count: " << head->changeByteCount;
-                uint32_t byteOffset = head->changeByteOffset;
-                memWork[i].devMemBlock->memSetMask(byteOffset, memWork[i].shmMem+byteOffset, memWork[i].shmMask+byteOffset, head->changeByteCount);
-                memset(memWork[i].shmMask+byteOffset, 0, head->changeByteCount);
-                head->changeByteOffset = 0xFFFFFFFF;
-                head->changeByteCount = 0;
-                memWork[i].changeCounter = head->changeCounter;
+                mbServerDevice::MemoryBlock::Ranges_t ranges = w.devMemBlock->changedRanges(w.devMemChangeCounter, &w.devMemChangeCounter);
+                std::atomic<uint32_t> &seq = shmAtomic(head->seq);
+                uint32_t s = seq.load(std::memory_order_relaxed);
+                seq.store(s + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                Q_FOREACH (const mbServerDevice::MemoryBlock::Range &r, ranges)
+                {
+                    if (r.offset >= w.memBytes)
+                        break;
+                    uint32_t c = r.count;
+                    if (r.offset + c > w.memBytes)
+                        c = w.memBytes - r.offset;
+                    w.devMemBlock->memGet(r.offset, w.shmMem+r.offset, c);
+                }
+                seq.store(s + 2, std::memory_order_release);
             }
-            if (memWork[i].devMemChangeCounter != memWork[i].devMemBlock->changeCounter())
+            // Note: pages are acknowledged only after 'mem' already contains applied values,
+            //       so Python script never reads its own change as rolled back
+            if (w.acked)
             {
-                memWork[i].devMemChangeCounter = memWork[i].devMemBlock->changeCounter();
-                memWork[i].devMemBlock->memGet(0, memWork[i].shmMem, memWork[i].devMemBlock->sizeBytes());
+                for (uint32_t p = 0; p < w.pageCount; p++)
+                {
+                    if (w.shmAcks[p] != w.acks[p])
+                        shmAtomic(w.shmAcks[p]).store(w.acks[p], std::memory_order_release);
+                }
+                w.acked = false;
             }
-            shm.unlock();
+            if (locked)
+                w.shm->unlock();
         }
         devMem->cycle++;
-        mb::msleep(1);
+        if (!tmFirstCycle && pyMem->pycycle)
+        {
+            // Note: startup time includes interpreter start, imports and 'Init' script
+            tmFirstCycle = mb::currentTimestamp();
+            mbServer::LogInfo("Python", QString("Script of device '%1' (%2) started in %3 ms").arg(m_device->name(), mode).arg(tmFirstCycle-tmStart));
+        }
+
+        m_waiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool changed = false;
+        for (int i = 0; i < 4; i++)
+        {
+            if ((memWork[i].devMemChangeCounter != memWork[i].devMemBlock->changeCounter()) ||
+                (memWork[i].changeCounter != shmAtomic(memWork[i].shmHeader->changeCounter).load(std::memory_order_acquire)))
+            {
+                changed = true;
+                break;
+            }
+        }
+        if (!changed && m_ctrlRun)
+            m_waiter.wait(handles, waitTimeout);
+        m_waiting.store(false);
+        pipe.drain();
+    }
+    for (int i = 0; i < 4; i++)
+        memWork[i].devMemBlock->setListener(nullptr);
+
+    if (tmFirstCycle)
+    {
+        mb::Timestamp_t tmLoop = mb::currentTimestamp()-tmFirstCycle;
+        uint32_t cycles = pyMem->pycycle;
+        mbServer::LogInfo("Python", QString("Script of device '%1' (%2): %3 cycles, average cycle %4 ms")
+                                        .arg(m_device->name(), mode)
+                                        .arg(cycles)
+                                        .arg(cycles > 1 ? static_cast<double>(tmLoop)/(cycles-1) : 0.0, 0, 'f', 3));
     }
 
     // Finish process
     devMem->flags &= (~1);
-    if (py.state() != QProcess::NotRunning)
+    if (m_pooled)
+    {
+        // Note: keep shared memory alive until worker executes 'Final' script of the device
+        tm = mb::currentTimestamp();
+        while (!(pyMem->pyflags & 1) && (mb::currentTimestamp()-tm < timeoutStartStop))
+            mb::msleep(1);
+    }
+    else if (embedded)
+    {
+        if (!embedded->wait(timeoutStartStop))
+        {
+            mbServer::LogError("Python", QString("Can't stop embedded script of device '%1'. Interrupting it").arg(m_device->name()));
+            embedded->interrupt();
+        }
+        // Note: interruption is delivered only between Python bytecodes, so script blocked within C code
+        //       can't be stopped and thread can't be killed. Such thread is abandoned and deleted when finished
+        if (embedded->isFinished() || embedded->wait(timeoutStartStop))
+            delete embedded;
+        else
+        {
+            mbServer::LogError("Python", QString("Embedded script of device '%1' doesn't respond to interruption. Its thread is abandoned").arg(m_device->name()));
+            embedded->moveToThread(QCoreApplication::instance()->thread());
+            connect(embedded, &QThread::finished, embedded, &QObject::deleteLater);
+            if (embedded->isFinished()) // Note: finished before connection
+                embedded->deleteLater();
+        }
+        for (int i = 0; i < 4; i++)
+            mbServerRunScriptEmbedded::unregisterMemoryBlock(memKeys[i]);
+    }
+    else if (py.state() != QProcess::NotRunning)
     {
         tm = mb::currentTimestamp();
         Modbus::msleep(1);
@@ -323,7 +551,7 @@ void mbServerRunScriptThread::readPyStdOut()
     mbServer::OutputMessage(QString::fromUtf8(m_py->readAllStandardOutput()));
 }
 
-QString mbServerRunScriptThread::getImportPath()
+QString mbServerRunScriptThread::importPath() const
 {
     QStringList pathList;
     mbServerProject *project = mbServer::global()->project();
@@ -1,20 +1,40 @@
 #ifndef SERVER_RUNSCRIPTTHREAD_H
 #define SERVER_RUNSCRIPTTHREAD_H
 
+#include <atomic>
+
 #include <QThread>
 #include <mbcore.h>
 
+#include <project/server_device.h>
+
+#include "server_runwaiter.h"
+
 class QProcess;
-class mbServerDevice;
 
-class mbServerRunScriptThread : public QThread
+class mbServerRunScriptThread : public QThread, public mbServerDevice::MemoryBlock::Listener
 {
     Q_OBJECT
 public:
     explicit mbServerRunScriptThread(mbServerDevice *device, const MBSETTINGS &scripts, QObject *parent = nullptr);
 
 public:
-    inline void stop() { m_ctrlRun = false; }
+    inline mbServerDevice *device() const { return m_device; }
+    inline QString memId() const { return m_memId; }
+    inline QString syncPipePath() const { return m_syncPipePath; }
+    inline int scriptLoopPeriod() const { return m_scriptLoopPeriod; }
+    inline QString scriptInit() const { return m_scriptInit; }
+    inline QString scriptLoop() const { return m_scriptLoop; }
+    inline QString scriptFinal() const { return m_scriptFinal; }
+    inline bool isPooled() const { return m_pooled; }
+    inline void setPooled(bool pooled) { m_pooled = pooled; }
+    QString importPath() const;
+
+public:
+    inline void stop() { m_ctrlRun = false; m_waiter.wakeup(); }
+
+public: // mbServerDevice::MemoryBlock::Listener
+    void memoryChanged() override;
 
 protected:
     void run() override;
@@ -23,7 +43,6 @@ private Q_SLOTS:
     void readPyStdOut();
 
 private:
-    QString getImportPath();
     QString getScriptInit();
     QString getScriptLoop();
     QString getScriptFinal();
@@ -31,6 +50,8 @@ private:
 
 private:
     bool m_ctrlRun;
+    mbServerRunWaiter m_waiter;
+    std::atomic<bool> m_waiting;
 
 private:
     mbServerDevice *m_device;
@@ -39,6 +60,10 @@ private:
     QString m_pyInterpreter;
     bool m_scriptUseOptimization;
     int m_scriptLoopPeriod;
+    bool m_scriptEmbedded;
+    bool m_pooled;
+    QString m_memId;
+    QString m_syncPipePath;
     QString m_scriptInit ;
     QString m_scriptLoop ;
     QString m_scriptFinal;
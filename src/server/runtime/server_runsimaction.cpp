@@ -22,7 +22,10 @@
 */
 #include "server_runsimaction.h"
 
-#include <project/server_device.h>
+#include <QDir>
+
+#include <server.h>
+#include <project/server_project.h>
 
 mbServerRunSimAction::mbServerRunSimAction(const MBSETTINGS &settings)
 {
@@ -32,6 +35,12 @@ mbServerRunSimAction::mbServerRunSimAction(const MBSETTINGS &settings)
     m_period  = settings.value(sAction.period).toInt();
     m_byteOrder = mb::getByteOrder(m_device, mb::enumDataOrderValue(settings.value(sAction.byteOrder), mb::LessSignifiedFirst));
     m_registerOrder = mb::getRegisterOrder(m_device, mb::toRegisterOrder(settings.value(sAction.registerOrder), mb::R0R1R2R3));
+    m_mem = nullptr;
+    m_offset = 0;
+    m_bitCount = 0;
+    m_swapped = false;
+    for (int i = 0; i < 8; i++)
+        m_perm[i] = static_cast<quint8>(i);
 }
 
 mbServerRunSimAction::~mbServerRunSimAction()
@@ -51,7 +60,6 @@ void mbServerRunSimAction::setValue(const QVariant &value)
 
 void mbServerRunSimAction::trySwap(void *d, int size)
 {
-    // TODO: resolve this conditions in compiling stage
     if ((size > 1) && (m_byteOrder == mb::MostSignifiedFirst))
         mb::changeByteOrder(d, size);
     switch (size)
@@ -66,6 +74,47 @@ void mbServerRunSimAction::trySwap(void *d, int size)
     }
 }
 
+void mbServerRunSimAction::compileOrder(int size)
+{
+    // Note: 'trySwap' only moves bytes, so its result for byte indexes is the permutation itself
+    quint8 perm[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    trySwap(perm, size);
+    m_swapped = false;
+    for (int i = 0; i < size; i++)
+    {
+        m_perm[i] = perm[i];
+        if (perm[i] != i)
+            m_swapped = true;
+    }
+}
+
+void mbServerRunSimAction::compileAccess(mb::DataType dataType, int size)
+{
+    uint offset = m_address.offset();
+    switch (m_address.type())
+    {
+    case Modbus::Memory_0x:
+    case Modbus::Memory_1x:
+        m_mem = (m_address.type() == Modbus::Memory_0x) ? &m_device->memBlockRef_0x() : &m_device->memBlockRef_1x();
+        m_offset = offset;
+        m_bitCount = (dataType == mb::Bit) ? 1 : static_cast<uint>(size) * MB_BYTE_SZ_BITES;
+        break;
+    default:
+        m_mem = (m_address.type() == Modbus::Memory_3x) ? &m_device->memBlockRef_3x() : &m_device->memBlockRef_4x();
+        if (dataType == mb::Bit)
+        {
+            m_offset = offset * MB_REGE_SZ_BITES;
+            m_bitCount = 1;
+        }
+        else
+        {
+            m_offset = offset * MB_REGE_SZ_BYTES;
+            m_bitCount = 0;
+        }
+        break;
+    }
+}
+
 int mbServerRunSimAction::init(qint64 time)
 {
     m_last = time;
@@ -144,6 +193,73 @@ mbServerRunSimAction *createRunActionCopy(const MBSETTINGS &settings)
     return new mbServerRunSimActionCopy(settings);
 }
 
+mbServerRunSimAction *createRunActionWaveform(mb::DataType dataType, const MBSETTINGS &settings)
+{
+    // Note: bank of single bits is not supported, 'Copy' or 'Random' action can be used for it
+    if (dataType == mb::Bit)
+    {
+        mbServer::LogWarning("Simulation", QStringLiteral("'Waveform' action doesn't support 'Bit' data type"));
+        return nullptr;
+    }
+    switch (dataType)
+    {
+    case mb::Int8    : return new mbServerRunSimActionWaveform<qint8>  (settings);
+    case mb::UInt8   : return new mbServerRunSimActionWaveform<quint8> (settings);
+    case mb::Int16   : return new mbServerRunSimActionWaveform<qint16> (settings);
+    case mb::UInt16  : return new mbServerRunSimActionWaveform<quint16>(settings);
+    case mb::Int32   : return new mbServerRunSimActionWaveform<qint32> (settings);
+    case mb::UInt32  : return new mbServerRunSimActionWaveform<quint32>(settings);
+    case mb::Int64   : return new mbServerRunSimActionWaveform<qint64> (settings);
+    case mb::UInt64  : return new mbServerRunSimActionWaveform<quint64>(settings);
+    case mb::Float32 : return new mbServerRunSimActionWaveform<float>  (settings);
+    case mb::Double64: return new mbServerRunSimActionWaveform<double> (settings);
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+mbServerRunSimAction *createRunActionReplay(mb::DataType dataType, const MBSETTINGS &settings)
+{
+    const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
+    if (dataType == mb::Bit)
+    {
+        mbServer::LogWarning("Simulation", QStringLiteral("'Replay' action doesn't support 'Bit' data type"));
+        return nullptr;
+    }
+    QString fileName = settings.value(s.replayFile).toString();
+    mbServerProject *project = mbServer::global()->project();
+    if (project)
+        fileName = QDir(project->absoluteDirPath()).absoluteFilePath(fileName);
+    // Note: only binary file prepared by import (see 'mbServerReplayImport') is opened here,
+    //       so runtime start isn't blocked by conversion and sim thread works with memory-mapped file
+    mbServerReplayFile *file = new mbServerReplayFile();
+    QString error;
+    if (!file->open(fileName, &error))
+    {
+        mbServer::LogError("Simulation", error);
+        delete file;
+        return nullptr;
+    }
+    switch (dataType)
+    {
+    case mb::Int8    : return new mbServerRunSimActionReplay<qint8>  (settings, file);
+    case mb::UInt8   : return new mbServerRunSimActionReplay<quint8> (settings, file);
+    case mb::Int16   : return new mbServerRunSimActionReplay<qint16> (settings, file);
+    case mb::UInt16  : return new mbServerRunSimActionReplay<quint16>(settings, file);
+    case mb::Int32   : return new mbServerRunSimActionReplay<qint32> (settings, file);
+    case mb::UInt32  : return new mbServerRunSimActionReplay<quint32>(settings, file);
+    case mb::Int64   : return new mbServerRunSimActionReplay<qint64> (settings, file);
+    case mb::UInt64  : return new mbServerRunSimActionReplay<quint64>(settings, file);
+    case mb::Float32 : return new mbServerRunSimActionReplay<float>  (settings, file);
+    case mb::Double64: return new mbServerRunSimActionReplay<double> (settings, file);
+    default:
+        break;
+    }
+    delete file;
+    return nullptr;
+}
+
 mbServerRunSimActionCopy::mbServerRunSimActionCopy(const MBSETTINGS &settings) : mbServerRunSimAction(settings)
 {
     const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
@@ -153,68 +269,37 @@ mbServerRunSimActionCopy::mbServerRunSimActionCopy(const MBSETTINGS &settings) :
     switch (m_dataType)
     {
     case mb::Bit:
-        m_srcCount = count;
-        m_dstCount = count;
-        m_buffer.resize((count+7)/8);
-        switch (sourceAddress.type())
-        {
-        case Modbus::Memory_0x: m_methodRead = &mbServerDevice::read_0x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_1x: m_methodRead = &mbServerDevice::read_1x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_3x: m_methodRead = &mbServerDevice::read_3x_bit; m_src = sourceAddress.offset()*16; break;
-        default               : m_methodRead = &mbServerDevice::read_4x_bit; m_src = sourceAddress.offset()*16; break;
-        }
-
-        switch (m_address.type())
-        {
-        case Modbus::Memory_0x: m_methodWrite = &mbServerDevice::write_0x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_1x: m_methodWrite = &mbServerDevice::write_1x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_3x: m_methodWrite = &mbServerDevice::write_3x_bit; m_dst = m_address.offset()*16; break;
-        default               : m_methodWrite = &mbServerDevice::write_4x_bit; m_dst = m_address.offset()*16; break;
-        }
+        m_count = count;
         break;
     case mb::Int8:
     case mb::UInt8:
-        m_srcCount = count * 8;
-        m_dstCount = count * 8;
-        m_buffer.resize(count);
-        switch (sourceAddress.type())
-        {
-        case Modbus::Memory_0x: m_methodRead = &mbServerDevice::read_0x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_1x: m_methodRead = &mbServerDevice::read_1x    ; m_src = sourceAddress.offset()   ; break;
-        case Modbus::Memory_3x: m_methodRead = &mbServerDevice::read_3x_bit; m_src = sourceAddress.offset()*16; break;
-        default               : m_methodRead = &mbServerDevice::read_4x_bit; m_src = sourceAddress.offset()*16; break;
-        }
-
-        switch (m_address.type())
-        {
-        case Modbus::Memory_0x: m_methodWrite = &mbServerDevice::write_0x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_1x: m_methodWrite = &mbServerDevice::write_1x    ; m_dst = m_address.offset()   ; break;
-        case Modbus::Memory_3x: m_methodWrite = &mbServerDevice::write_3x_bit; m_dst = m_address.offset()*16; break;
-        default               : m_methodWrite = &mbServerDevice::write_4x_bit; m_dst = m_address.offset()*16; break;
-        }
+        m_count = count * MB_BYTE_SZ_BITES;
         break;
     default:
+        m_count = static_cast<uint>(mb::sizeOfDataType(m_dataType)) * count * MB_BYTE_SZ_BITES;
+        break;
+    }
+    // Note: registers are accessed as bits when source or destination memory is bit memory
+    m_srcMem = m_device->memBlock(sourceAddress.type());
+    switch (sourceAddress.type())
     {
-        uint sz = mb::sizeOfDataType(m_dataType) * count;
+    case Modbus::Memory_0x:
+    case Modbus::Memory_1x:
         m_src = sourceAddress.offset();
-        m_dst = m_address.offset();
-        m_buffer.resize(sz);
-        switch (sourceAddress.type())
-        {
-        case Modbus::Memory_0x: m_methodRead = &mbServerDevice::read_0x; m_srcCount = sz*8; break;
-        case Modbus::Memory_1x: m_methodRead = &mbServerDevice::read_1x; m_srcCount = sz*8; break;
-        case Modbus::Memory_3x: m_methodRead = &mbServerDevice::read_3x; m_srcCount = sz/2; break;
-        default               : m_methodRead = &mbServerDevice::read_4x; m_srcCount = sz/2; break;
-        }
-
-        switch (m_address.type())
-        {
-        case Modbus::Memory_0x: m_methodWrite = &mbServerDevice::write_0x; m_dstCount = sz*8; break;
-        case Modbus::Memory_1x: m_methodWrite = &mbServerDevice::write_1x; m_dstCount = sz*8; break;
-        case Modbus::Memory_3x: m_methodWrite = &mbServerDevice::write_3x; m_dstCount = sz/2; break;
-        default               : m_methodWrite = &mbServerDevice::write_4x; m_dstCount = sz/2; break;
-        }
+        break;
+    default:
+        m_src = sourceAddress.offset() * MB_REGE_SZ_BITES;
+        break;
     }
+    m_mem = m_device->memBlock(m_address.type());
+    switch (m_address.type())
+    {
+    case Modbus::Memory_0x:
+    case Modbus::Memory_1x:
+        m_dst = m_address.offset();
+        break;
+    default:
+        m_dst = m_address.offset() * MB_REGE_SZ_BITES;
         break;
     }
 }
@@ -223,8 +308,9 @@ int mbServerRunSimActionCopy::exec(qint64 time)
 {
     if (((time-this->m_last) >= this->m_period))
     {
-        (m_device->*m_methodRead )(m_src, m_srcCount, m_buffer.data(), nullptr);
-        (m_device->*m_methodWrite)(m_dst, m_dstCount, m_buffer.data(), nullptr);
+        if (m_mem && m_srcMem)
+            m_mem->copyBits(m_dst, m_srcMem, m_src, m_count);
+        this->m_last = time;
     }
     return 0;
 }
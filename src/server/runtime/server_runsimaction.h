@@ -23,13 +23,17 @@
 #ifndef SERVER_RUNSIMACTION_H
 #define SERVER_RUNSIMACTION_H
 
+#include <cmath>
+#include <vector>
+
 #include <QtMath>
 #include <QVariant>
 
 #include <mbcore.h>
 #include <project/server_simaction.h>
+#include <project/server_device.h>
 
-class mbServerDevice;
+#include "server_replayfile.h"
 
 class mbServerRunSimAction
 {
@@ -42,15 +46,25 @@ public:
     inline mb::Address address() const { return m_address; }
     virtual mb::DataType dataType() const = 0;
     inline int period() const { return m_period; }
+    inline qint64 nextTime() const { return m_last + m_period; }
     QVariant value() const;
     void setValue(const QVariant &value);
-    void trySwap(void *d, int size);
 
 public:
     virtual int init(qint64 time);
     virtual int exec(qint64 time);
     virtual int final(qint64 time);
 
+protected:
+    // Note: byte and register order of the value is resolved once into permutation of its bytes
+    //       (the same as 'trySwap' makes) and memory block with offset of the value are resolved once too,
+    //       so typed action reads and writes device memory directly without 'QVariant' conversion
+    void compileOrder(int size);
+    void compileAccess(mb::DataType dataType, int size);
+
+private:
+    void trySwap(void *d, int size);
+
 protected:
     mbServerDevice *m_device;
     mb::Address m_address;
@@ -58,14 +72,54 @@ protected:
     qint64 m_last;
     mb::DataOrder m_byteOrder;
     mb::RegisterOrder m_registerOrder;
+    mbServerDevice::MemoryBlock *m_mem;
+    uint m_offset;   // bit offset if 'm_bitCount' is not 0, byte offset otherwise
+    uint m_bitCount;
+    bool m_swapped;
+    quint8 m_perm[8];
 };
 
 template <typename T>
 class mbServerRunSimActionT : public mbServerRunSimAction
 {
 public:
-    mbServerRunSimActionT(const MBSETTINGS &settings) : mbServerRunSimAction(settings) {}
+    mbServerRunSimActionT(const MBSETTINGS &settings) : mbServerRunSimAction(settings)
+    {
+        compileOrder(sizeof(T));
+        compileAccess(mb::dataTypeFromT<T>(), sizeof(T));
+    }
     mb::DataType dataType() const override { return mb::dataTypeFromT<T>(); }
+
+protected:
+    inline T get() const
+    {
+        T v = T();
+        if (m_bitCount)
+            m_mem->readBits(m_offset, m_bitCount, &v);
+        else
+            m_mem->read(m_offset, sizeof(T), &v);
+        return v;
+    }
+
+    inline void set(T v)
+    {
+        if (m_bitCount)
+            m_mem->writeBits(m_offset, m_bitCount, &v);
+        else
+            m_mem->write(m_offset, sizeof(T), &v);
+    }
+
+    inline T swapped(T v) const
+    {
+        if (!m_swapped)
+            return v;
+        T r;
+        const quint8 *s = reinterpret_cast<const quint8*>(&v);
+        quint8 *d = reinterpret_cast<quint8*>(&r);
+        for (size_t i = 0; i < sizeof(T); i++)
+            d[i] = s[m_perm[i]];
+        return r;
+    }
 };
 
 
@@ -85,14 +139,11 @@ public:
     {
         if (time-this->m_last >= this->m_period)
         {
-            QVariant v = this->value();
-            T t = v.value<T>();
-            mbServerRunSimAction::trySwap(&t, sizeof(t));
+            T t = this->swapped(this->get());
             t += m_increment;
             if ((t < m_min) || (t > m_max))
                 t = m_min;
-            mbServerRunSimAction::trySwap(&t, sizeof(t));
-            this->setValue(t);
+            this->set(this->swapped(t));
             this->m_last = time;
         }
         return 0;
@@ -126,8 +177,7 @@ public:
         {
             qreal x = static_cast<qreal>(time-m_phaseShift)/m_sinePeriod;
             T v = static_cast<T>(m_amplitude*qSin(x*2*M_PI)+m_verticalShift);
-            mbServerRunSimAction::trySwap(&v, sizeof(v));
-            this->setValue(v);
+            this->set(this->swapped(v));
             this->m_last = time;
         }
         return 0;
@@ -158,8 +208,7 @@ public:
         {
             qreal x = static_cast<qreal>(RAND_MAX-qrand())/static_cast<qreal>(RAND_MAX); // koef is [0;1]
             T v = static_cast<T>(x*m_range+m_min);
-            mbServerRunSimAction::trySwap(&v, sizeof(v));
-            this->setValue(v);
+            this->set(this->swapped(v));
             this->m_last = time;
         }
         return 0;
@@ -170,6 +219,276 @@ private:
     qreal m_range;
 };
 
+// Note: generator of the bank of values (channels) that follow each other in device memory.
+//       Values of the whole bank are calculated in plain loops over contiguous arrays (so compiler
+//       can vectorize them) and written into memory by single call under single memory lock
+template <typename T>
+class mbServerRunSimActionWaveform : public mbServerRunSimActionT<T>
+{
+public:
+    mbServerRunSimActionWaveform(const MBSETTINGS &settings) : mbServerRunSimActionT<T>(settings)
+    {
+        const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
+        m_waveformType = mb::enumValue<mbServerSimAction::WaveformType>(settings.value(s.waveformType), mbServerSimAction::WaveformSine);
+        int channels = settings.value(s.waveformChannels).toInt();
+        if (channels < 1)
+            channels = 1;
+        m_waveformPeriod = settings.value(s.waveformPeriod).toDouble();
+        if (m_waveformPeriod < 1.0)
+            m_waveformPeriod = 1.0;
+        m_phaseStep = settings.value(s.waveformPhaseStep).toDouble();
+        m_amplitude = settings.value(s.waveformAmplitude).toDouble();
+        m_offset    = settings.value(s.waveformOffset   ).toDouble();
+        const QStringList table = settings.value(s.waveformTable).toString().split(' ', Qt::SkipEmptyParts);
+        Q_FOREACH (const QString &v, table)
+            m_table.push_back(v.toDouble());
+        if (m_table.empty())
+            m_table.push_back(m_offset);
+        m_values.resize(channels);
+        m_buffer.resize(channels);
+        m_seed = static_cast<quint64>(reinterpret_cast<quintptr>(this)) | 1;
+        this->m_bitCount *= channels;
+    }
+
+public:
+    int exec(qint64 time) override
+    {
+        if ((time-this->m_last) >= this->m_period)
+        {
+            // Note: position inside period is calculated in 'double' which keeps milliseconds since epoch exactly
+            const qreal pos = std::fmod(static_cast<qreal>(time), m_waveformPeriod)/m_waveformPeriod; // [0;1)
+            switch (m_waveformType)
+            {
+            case mbServerSimAction::WaveformRamp : fillRamp (pos); break;
+            case mbServerSimAction::WaveformNoise: fillNoise()   ; break;
+            case mbServerSimAction::WaveformTable: fillTable(pos); break;
+            default                              : fillSine (pos); break;
+            }
+            const size_t count = m_values.size();
+            const qreal *v = m_values.data();
+            T *b = m_buffer.data();
+            for (size_t i = 0; i < count; i++)
+                b[i] = static_cast<T>(v[i]);
+            if (this->m_swapped)
+            {
+                for (size_t i = 0; i < count; i++)
+                    b[i] = this->swapped(b[i]);
+            }
+            if (this->m_bitCount)
+                this->m_mem->writeBits(this->m_offset, this->m_bitCount, b);
+            else
+                this->m_mem->write(this->m_offset, static_cast<uint>(count * sizeof(T)), b);
+            this->m_last = time;
+        }
+        return 0;
+    }
+
+private:
+    void fillSine(qreal pos)
+    {
+        // Note: channel 'i' is 'sin(2*pi*(time-i*phaseStep)/period)'. Instead of calling 'sin' for every channel
+        //       the pair (sin, cos) is rotated by constant angle. Channels are split into 'Lanes' interleaved
+        //       sequences (channel 'j' belongs to lane 'j % Lanes') rotated by 'Lanes*d' independently of each other,
+        //       so inner loop has no dependency chain between lanes (it's also vectorizable when auto-vectorization
+        //       of the compiler is enabled, e.g. '-O3', no special instruction set is required).
+        //       Exact values are recalculated every 'SyncStep' channels to prevent accumulation of rounding error
+        const int Lanes = 8;
+        const int SyncStep = 256;
+        const qreal x = 2*M_PI*pos;
+        const qreal d = -2*M_PI*m_phaseStep/m_waveformPeriod;
+        const qreal sd = qSin(d*Lanes);
+        const qreal cd = qCos(d*Lanes);
+        const qreal amplitude = m_amplitude;
+        const qreal offset = m_offset;
+        const int count = static_cast<int>(m_values.size());
+        qreal *v = m_values.data();
+        for (int i = 0; i < count; i += SyncStep)
+        {
+            qreal sn[Lanes], cs[Lanes];
+            for (int k = 0; k < Lanes; k++)
+            {
+                sn[k] = qSin(x+d*(i+k));
+                cs[k] = qCos(x+d*(i+k));
+            }
+            const int end = qMin(i+SyncStep, count);
+            int j = i;
+            for (; j+Lanes <= end; j += Lanes)
+            {
+                for (int k = 0; k < Lanes; k++)
+                {
+                    v[j+k] = amplitude*sn[k]+offset;
+                    const qreal t = sn[k]*cd+cs[k]*sd;
+                    cs[k] = cs[k]*cd-sn[k]*sd;
+                    sn[k] = t;
+                }
+            }
+            for (int k = 0; j < end; j++, k++)
+                v[j] = amplitude*sn[k]+offset;
+        }
+    }
+
+    void fillRamp(qreal pos)
+    {
+        // Note: saw from 'offset-amplitude' to 'offset+amplitude'
+        const qreal d = m_phaseStep/m_waveformPeriod;
+        const size_t count = m_values.size();
+        qreal *v = m_values.data();
+        for (size_t i = 0; i < count; i++)
+        {
+            qreal p = pos-d*static_cast<qreal>(i);
+            p -= std::floor(p);
+            v[i] = m_offset+m_amplitude*(2*p-1);
+        }
+    }
+
+    void fillNoise()
+    {
+        // Note: xorshift64* generator is used instead of 'qrand()' which is not thread-safe and has small range
+        const size_t count = m_values.size();
+        qreal *v = m_values.data();
+        quint64 s = m_seed;
+        for (size_t i = 0; i < count; i++)
+        {
+            s ^= s >> 12;
+            s ^= s << 25;
+            s ^= s >> 27;
+            const qreal x = static_cast<qreal>((s * 0x2545F4914F6CDD1DULL) >> 11) * (1.0/9007199254740992.0); // [0;1)
+            v[i] = m_offset+m_amplitude*(2*x-1);
+        }
+        m_seed = s;
+    }
+
+    void fillTable(qreal pos)
+    {
+        // Note: table is one period of the signal, amplitude and offset are not applied to its values
+        const qreal n = static_cast<qreal>(m_table.size());
+        const qreal d = m_phaseStep/m_waveformPeriod;
+        const size_t count = m_values.size();
+        const size_t last = m_table.size()-1;
+        const qreal *tb = m_table.data();
+        qreal *v = m_values.data();
+        for (size_t i = 0; i < count; i++)
+        {
+            qreal p = pos-d*static_cast<qreal>(i);
+            p -= std::floor(p);
+            const size_t k = static_cast<size_t>(p*n);
+            v[i] = tb[k < last ? k : last];
+        }
+    }
+
+private:
+    mbServerSimAction::WaveformType m_waveformType;
+    qreal m_waveformPeriod;
+    qreal m_phaseStep;
+    qreal m_amplitude;
+    qreal m_offset;
+    quint64 m_seed;
+    std::vector<qreal> m_table;
+    std::vector<qreal> m_values;
+    std::vector<T> m_buffer;
+};
+
+// Note: replays recorded time-series file into the bank of values (channels) that follow each other
+//       in device memory. File is memory-mapped, so sim thread only touches pages of current rows,
+//       and pages of next rows are requested from OS in advance to avoid page faults while replaying
+template <typename T>
+class mbServerRunSimActionReplay : public mbServerRunSimActionT<T>
+{
+public:
+    // Note: action takes ownership of opened 'file'
+    mbServerRunSimActionReplay(const MBSETTINGS &settings, mbServerReplayFile *file) : mbServerRunSimActionT<T>(settings)
+    {
+        const mbServerSimAction::Strings &s = mbServerSimAction::Strings::instance();
+        m_file = file;
+        int channels = settings.value(s.replayChannels).toInt();
+        if ((channels < 1) || (channels > m_file->columns()))
+            channels = m_file->columns();
+        m_speed = settings.value(s.replaySpeed).toDouble();
+        if (m_speed <= 0.0)
+            m_speed = 1.0;
+        m_loop = settings.value(s.replayLoop).toBool();
+        m_buffer.resize(channels);
+        m_start = 0;
+        m_row = 0;
+        m_window = 0;
+        m_written = false;
+        this->m_bitCount *= channels;
+    }
+
+    ~mbServerRunSimActionReplay()
+    {
+        delete m_file;
+    }
+
+public:
+    int init(qint64 time) override
+    {
+        mbServerRunSimActionT<T>::init(time);
+        m_start = time;
+        m_row = 0;
+        m_window = 0;
+        m_written = false;
+        m_file->prefetch(0, 2*PrefetchRows);
+        return 0;
+    }
+
+    int exec(qint64 time) override
+    {
+        if ((time-this->m_last) >= this->m_period)
+        {
+            qint64 t = static_cast<qint64>(static_cast<qreal>(time-m_start)*m_speed);
+            if (m_loop && (t > m_file->duration()))
+            {
+                m_start = time;
+                m_row = 0;
+                m_written = false;
+                t = 0;
+            }
+            quint64 row = m_file->findRow(t, m_row);
+            if ((row != m_row) || !m_written)
+            {
+                m_row = row;
+                m_written = true;
+                writeRow(row);
+            }
+            quint64 window = row / PrefetchRows;
+            if (window != m_window)
+            {
+                m_window = window;
+                m_file->prefetch((window+1)*PrefetchRows, PrefetchRows);
+            }
+            this->m_last = time;
+        }
+        return 0;
+    }
+
+private:
+    void writeRow(quint64 row)
+    {
+        const int count = static_cast<int>(m_buffer.size());
+        T *b = m_buffer.data();
+        for (int c = 0; c < count; c++)
+            b[c] = this->swapped(static_cast<T>(m_file->value(c, row)));
+        if (this->m_bitCount)
+            this->m_mem->writeBits(this->m_offset, this->m_bitCount, b);
+        else
+            this->m_mem->write(this->m_offset, static_cast<uint>(count * sizeof(T)), b);
+    }
+
+private:
+    // Note: count of rows (64 KB of every column) read ahead at once
+    static const quint64 PrefetchRows = 8192;
+
+    mbServerReplayFile *m_file;
+    qreal m_speed;
+    bool m_loop;
+    qint64 m_start;
+    quint64 m_row;
+    quint64 m_window;
+    bool m_written;
+    std::vector<T> m_buffer;
+};
+
 class mbServerRunSimActionCopy : public mbServerRunSimAction
 {
 public:
@@ -180,21 +499,19 @@ public:
     int exec(qint64 time) override;
 
 private:
-    typedef Modbus::StatusCode (mbServerDevice::*MethodRead )(uint bitOffset, uint bitCount, void* bites, uint *fact) const;
-    typedef Modbus::StatusCode (mbServerDevice::*MethodWrite)(uint bitOffset, uint bitCount, const void* bites, uint *fact);
-    MethodRead  m_methodRead;
-    MethodWrite m_methodWrite;
+    // Note: any copy is made as bit transfer from 'm_srcMem' into 'm_mem' under single lock of both blocks
+    mbServerDevice::MemoryBlock *m_srcMem;
     mb::DataType m_dataType;
-    uint m_dst;
-    uint m_src;
-    uint m_dstCount;
-    uint m_srcCount;
-    QByteArray m_buffer;
+    uint m_dst;   // bit offset
+    uint m_src;   // bit offset
+    uint m_count; // bit count
 };
 
 mbServerRunSimAction *createRunActionIncrement(mb::DataType dataType, const MBSETTINGS &settings);
 mbServerRunSimAction *createRunActionSine     (mb::DataType dataType, const MBSETTINGS &settings);
 mbServerRunSimAction *createRunActionRandom   (mb::DataType dataType, const MBSETTINGS &settings);
 mbServerRunSimAction *createRunActionCopy     (const MBSETTINGS &settings);
+mbServerRunSimAction *createRunActionWaveform (mb::DataType dataType, const MBSETTINGS &settings);
+mbServerRunSimAction *createRunActionReplay   (mb::DataType dataType, const MBSETTINGS &settings);
 
 #endif // SERVER_RUNSIMACTION_H
@@ -22,14 +22,23 @@
 */
 #include "server_runsimactiontask.h"
 
+#include <algorithm>
+
 #include <QDateTime>
 
+#include <server.h>
+
 #include "server_runsimaction.h"
 
 #include <project/server_simaction.h>
 
 mbServerRunSimActionTask::mbServerRunSimActionTask(QObject *parent) : mbCoreTask(parent)
 {
+    m_shard = 0;
+    m_nextLoopTimeout = 0;
+    m_overrunCount = 0;
+    m_execCount = 0;
+    m_maxLateness = 0;
 }
 
 mbServerRunSimActionTask::~mbServerRunSimActionTask()
@@ -60,6 +69,12 @@ void mbServerRunSimActionTask::setActions(const QList<mbServerSimAction *> &acti
         case mbServerSimAction::Copy:
             item = createRunActionCopy(s);
             break;
+        case mbServerSimAction::Waveform:
+            item = createRunActionWaveform(i->dataType(), s);
+            break;
+        case mbServerSimAction::Replay:
+            item = createRunActionReplay(i->dataType(), s);
+            break;
         }
         if (item)
             m_actions.append(item);
@@ -69,23 +84,84 @@ void mbServerRunSimActionTask::setActions(const QList<mbServerSimAction *> &acti
 int mbServerRunSimActionTask::init()
 {
     qint64 time = QDateTime::currentMSecsSinceEpoch();
-    Q_FOREACH(mbServerRunSimAction *i, m_actions)
-        i->init(time);
+    m_queue.clear();
+    m_queue.reserve(m_actions.count());
+    for (int i = 0; i < m_actions.count(); i++)
+    {
+        mbServerRunSimAction *a = m_actions.at(i);
+        a->init(time);
+        Schedule s;
+        s.time = a->nextTime();
+        s.index = i;
+        m_queue.push_back(s);
+    }
+    std::make_heap(m_queue.begin(), m_queue.end());
     return 0;
 }
 
+// Max time (milliseconds) to sleep when there are no actions
+#define SIMACTION_IDLE_TIMEOUT 100
+
 int mbServerRunSimActionTask::loop()
 {
+    if (m_queue.empty())
+    {
+        m_nextLoopTimeout = SIMACTION_IDLE_TIMEOUT;
+        return 0;
+    }
     qint64 time = QDateTime::currentMSecsSinceEpoch();
-    Q_FOREACH(mbServerRunSimAction *i, m_actions)
-        i->exec(time);
+    quint64 execs = 0;
+    quint64 overruns = 0;
+    qint64 maxLateness = m_maxLateness.load(std::memory_order_relaxed);
+    while (m_queue.front().time <= time)
+    {
+        std::pop_heap(m_queue.begin(), m_queue.end());
+        Schedule &s = m_queue.back();
+        mbServerRunSimAction *a = m_actions.at(s.index);
+        qint64 lateness = time - s.time;
+        if ((a->period() > 0) && (lateness >= a->period()))
+            ++overruns;
+        if (lateness > maxLateness)
+            maxLateness = lateness;
+        ++execs;
+        a->exec(time);
+        // Note: action with zero period (or not executed) is rescheduled for the next millisecond
+        s.time = qMax(a->nextTime(), time+1);
+        std::push_heap(m_queue.begin(), m_queue.end());
+    }
+    if (execs)
+    {
+        m_execCount.fetch_add(execs, std::memory_order_relaxed);
+        m_overrunCount.fetch_add(overruns, std::memory_order_relaxed);
+        m_maxLateness.store(maxLateness, std::memory_order_relaxed);
+    }
+    qint64 sleep = m_queue.front().time - time;
+    m_nextLoopTimeout = static_cast<int>(qMin<qint64>(sleep, SIMACTION_IDLE_TIMEOUT));
     return 0;
 }
 
+int mbServerRunSimActionTask::nextLoopTimeout()
+{
+    return m_nextLoopTimeout;
+}
+
 int mbServerRunSimActionTask::final()
 {
     qint64 time = QDateTime::currentMSecsSinceEpoch();
     Q_FOREACH(mbServerRunSimAction *i, m_actions)
         i->final(time);
+    if (m_actions.count())
+    {
+        QString text = QString("Shard %1: %2 action(s), %3 execution(s), %4 overrun(s), max lateness %5 ms")
+                           .arg(m_shard)
+                           .arg(m_actions.count())
+                           .arg(execCount())
+                           .arg(overrunCount())
+                           .arg(maxLateness());
+        if (overrunCount())
+            mbServer::LogWarning("Simulation", text);
+        else
+            mbServer::LogDebug("Simulation", text);
+    }
     return 0;
 }
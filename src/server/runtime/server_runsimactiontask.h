@@ -23,6 +23,9 @@
 #ifndef SERVER_RUNSIMACTIONTASK_H
 #define SERVER_RUNSIMACTIONTASK_H
 
+#include <atomic>
+#include <vector>
+
 #include <mbcore_task.h>
 
 class mbServerSimAction;
@@ -35,17 +38,44 @@ public:
     ~mbServerRunSimActionTask();
 
 public:
+    inline int shard() const { return m_shard; }
+    inline void setShard(int shard) { m_shard = shard; }
     void setActions(const QList<mbServerSimAction*> &actions);
+    inline int actionCount() const { return m_actions.count(); }
+
+public: // statistics
+    // Count of action executions which were late at least for one whole period of the action
+    inline quint64 overrunCount() const { return m_overrunCount.load(std::memory_order_relaxed); }
+    inline quint64 execCount() const { return m_execCount.load(std::memory_order_relaxed); }
+    inline qint64 maxLateness() const { return m_maxLateness.load(std::memory_order_relaxed); }
 
 public: // task interface
     virtual int init() override;
     virtual int loop() override;
     virtual int final() override;
+    virtual int nextLoopTimeout() override;
 
 private:
     typedef QList<mbServerRunSimAction*> Actions_t;
 
     Actions_t m_actions;
+
+    // Note: actions are scheduled by min-heap of their due time, so every loop touches only due actions.
+    //       Index of the action is used as secondary key to keep original order of actions due at the same time
+    struct Schedule
+    {
+        qint64 time;
+        int index;
+        inline bool operator<(const Schedule &other) const { return (time > other.time) || ((time == other.time) && (index > other.index)); }
+    };
+    typedef std::vector<Schedule> Queue_t;
+
+    Queue_t m_queue;
+    int m_shard;
+    int m_nextLoopTimeout;
+    std::atomic<quint64> m_overrunCount;
+    std::atomic<quint64> m_execCount;
+    std::atomic<qint64> m_maxLateness;
 };
 
 #endif // SERVER_RUNSIMACTIONTASK_H
@@ -33,32 +33,162 @@
 #include "server_portrunnable.h"
 #include "server_rundevice.h"
 
+mbServerRunThread::mbServerRunThread(QObject *parent)
+    : QThread(parent)
+{
+    m_ctrlRun = true;
+    m_runMode = mbServerPort::EventDriven;
+}
+
 mbServerRunThread::mbServerRunThread(mbServerPort *serverPort, mbServerRunDevice *device, QObject *parent)
     : QThread(parent)
 {
-    m_serverPort = serverPort;
     m_ctrlRun = true;
-    m_device = device;
-    m_settings = serverPort->settings();
+    // Note: own thread of the port keeps previous polling loop unless event-driven mode is set explicitly
+    m_runMode = (serverPort->runMode() == mbServerPort::EventDriven) ? mbServerPort::EventDriven : mbServerPort::Polling;
+    addPort(serverPort, device);
 }
 
 mbServerRunThread::~mbServerRunThread()
 {
-    delete m_device;
+    Q_FOREACH (const Item &item, m_items)
+        delete item.device;
 }
 
+void mbServerRunThread::addPort(mbServerPort *serverPort, mbServerRunDevice *device)
+{
+    Item item;
+    item.serverPort = serverPort;
+    item.device = device;
+    item.settings = serverPort->settings();
+    m_items.append(item);
+}
+
+// Count of cycles without any port activity after which event-driven loop starts to sleep
+#define HOT_CYCLES 64
+
+// Max time (milliseconds) to wait when port native handles are available.
+// Port will be woken earlier by incoming data or by 'stop()'
+#define IDLE_WAIT_HANDLES 100
+
+// Max time (milliseconds) to wait when some port can't be waited on by native handles
+// (e.g. TCP port), so such port is polled as often as in polling mode
+#define IDLE_WAIT_NO_HANDLES 1
+
 void mbServerRunThread::run()
 {
-    QEventLoop loop;
-    mbServerPortRunnable port(m_serverPort, m_settings, m_device);
+    Ports_t ports;
+    Q_FOREACH (const Item &item, m_items)
+    {
+        mbServerPortRunnable *port = new mbServerPortRunnable(item.serverPort, item.settings, item.device);
+        ports.append(port);
+        mbServer::LogInfo(port->name(), QStringLiteral("Start"));
+    }
     m_ctrlRun = true;
-    mbServer::LogInfo(port.name(), QStringLiteral("Start"));
+    m_stat = Statistic();
+    switch (m_runMode)
+    {
+    case mbServerPort::EventDriven:
+        runEventDriven(ports);
+        break;
+    default:
+        runPolling(ports);
+        break;
+    }
+    Q_FOREACH (mbServerPortRunnable *port, ports)
+    {
+        port->close();
+        mbServer::LogInfo(port->name(), QStringLiteral("Stop"));
+    }
+    qDeleteAll(ports);
+    mbServerRunWaiter::contextSwitches(&m_stat.csVoluntary, &m_stat.csInvoluntary);
+    logStatistic();
+}
+
+void mbServerRunThread::runPolling(const Ports_t &ports)
+{
+    QEventLoop loop;
     while (m_ctrlRun)
     {
         loop.processEvents();
-        port.run();
+        Q_FOREACH (mbServerPortRunnable *port, ports)
+            port->run();
+        ++m_stat.cycles;
+        ++m_stat.waits;
         Modbus::msleep(1);
     }
-    port.close();
-    mbServer::LogInfo(port.name(), QStringLiteral("Stop"));
+}
+
+void mbServerRunThread::runEventDriven(const Ports_t &ports)
+{
+    QEventLoop loop;
+    quint32 activity = 0;
+    int idle = 0;
+    mbServerRunWaiter::Handles_t handles;
+    while (m_ctrlRun)
+    {
+        loop.processEvents();
+        quint32 current = 0;
+        Q_FOREACH (mbServerPortRunnable *port, ports)
+        {
+            port->run();
+            current += port->activityCounter();
+        }
+        ++m_stat.cycles;
+        if (activity != current)
+        {
+            activity = current;
+            idle = 0;
+            continue; // Note: some port is in the middle of exchange, process it immediately
+        }
+        if (idle < HOT_CYCLES)
+        {
+            ++idle;
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        // Note: wait time grows gradually while ports stay idle, so timeouts of the ports
+        //       (e.g. inter-byte timeout of serial port) are still processed in time
+        int maxWait = mbServerRunWaiter::isHandlesSupported() ? IDLE_WAIT_HANDLES : IDLE_WAIT_NO_HANDLES;
+        handles.clear();
+        Q_FOREACH (mbServerPortRunnable *port, ports)
+        {
+            if (!port->appendHandles(handles))
+                maxWait = IDLE_WAIT_NO_HANDLES; // Note: port can't be waited on, so it must be polled
+        }
+        int msec = idle - HOT_CYCLES + 1;
+        if (msec < maxWait)
+            ++idle;
+        else
+            msec = maxWait;
+        // Note: delayed response must be sent at its deadline, not at the end of idle wait
+        Q_FOREACH (mbServerPortRunnable *port, ports)
+        {
+            int timeout = port->delayTimeout();
+            if ((timeout >= 0) && (timeout < msec))
+                msec = timeout;
+        }
+        ++m_stat.waits;
+        if (m_waiter.wait(handles, msec))
+        {
+            ++m_stat.wakeups;
+            idle = 0; // Note: new data is available or thread was woken
+        }
+    }
+}
+
+void mbServerRunThread::logStatistic()
+{
+    QString name;
+    if (m_items.count() == 1)
+        name = m_items.first().serverPort->name();
+    else
+        name = objectName();
+    mbServer::LogInfo(name, QString("Ports: %1, cycles: %2, waits: %3, wakeups: %4, context switches (voluntary/involuntary): %5/%6")
+                                .arg(m_items.count())
+                                .arg(m_stat.cycles)
+                                .arg(m_stat.waits)
+                                .arg(m_stat.wakeups)
+                                .arg(m_stat.csVoluntary)
+                                .arg(m_stat.csInvoluntary));
 }
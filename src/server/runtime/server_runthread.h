@@ -27,28 +27,78 @@
 
 #include <ModbusQt.h>
 
+#include <project/server_port.h>
+
+#include "server_runwaiter.h"
+
 class mbServerPort;
 class mbServerRunDevice;
+class mbServerPortRunnable;
 
+// Runtime thread that drives one or several server ports from one loop.
+// By default runtime creates one thread per port. When worker pool is enabled
+// ports are distributed between fixed count of such threads.
 class mbServerRunThread : public QThread
 {
 public:
+    struct Statistic
+    {
+        Statistic()
+        {
+            cycles = 0;
+            waits = 0;
+            wakeups = 0;
+            csVoluntary = 0;
+            csInvoluntary = 0;
+        }
+        quint64 cycles       ; // count of loop cycles
+        quint64 waits        ; // count of times the thread was blocked in waiter or sleep
+        quint64 wakeups      ; // count of waits interrupted by port readiness or 'stop()'
+        quint64 csVoluntary  ; // voluntary context switches of the thread (if supported by OS)
+        quint64 csInvoluntary; // involuntary context switches of the thread (if supported by OS)
+    };
+
+public:
+    explicit mbServerRunThread(QObject *parent = nullptr);
     explicit mbServerRunThread(mbServerPort *serverPort, mbServerRunDevice *device, QObject *parent = nullptr);
     ~mbServerRunThread();
 
 public:
-    inline void stop() { m_ctrlRun = false; }
+    inline int portCount() const { return m_items.count(); }
+    void addPort(mbServerPort *serverPort, mbServerRunDevice *device);
+    // Note: must be called only when thread is finished
+    inline Statistic statistic() const { return m_stat; }
+
+public:
+    inline void stop() { m_ctrlRun = false; m_waiter.wakeup(); }
 
 protected:
     void run() override;
 
+private:
+    typedef QList<mbServerPortRunnable*> Ports_t;
+    void runPolling(const Ports_t &ports);
+    void runEventDriven(const Ports_t &ports);
+    // Note: statistic is diagnostic of the thread scheduling and it's intentionally written only into the log
+    //       when thread stops: counters are not shared with other threads and context switches of the thread
+    //       can be read only by the thread itself
+    void logStatistic();
+
 private:
     bool m_ctrlRun;
+    mbServerRunWaiter m_waiter;
+    Statistic m_stat;
 
 private:
-    mbServerPort *m_serverPort;
-    mbServerRunDevice *m_device;
-    Modbus::Settings m_settings;
+    struct Item
+    {
+        mbServerPort *serverPort;
+        mbServerRunDevice *device;
+        Modbus::Settings settings;
+    };
+    typedef QList<Item> Items_t;
+    Items_t m_items;
+    mbServerPort::RunMode m_runMode;
 };
 
 #endif // SERVER_RUNTHREAD_H
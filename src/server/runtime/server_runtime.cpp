@@ -22,6 +22,8 @@
 */
 #include "server_runtime.h"
 
+#include <algorithm>
+
 #include <QCoreApplication>
 
 #include <core_filemanager.h>
@@ -32,6 +34,7 @@
 #include <project/server_port.h>
 #include <project/server_deviceref.h>
 #include <project/server_scriptmodule.h>
+#include <project/server_simaction.h>
 
 #include <runtime/core_runtaskthread.h>
 
@@ -44,23 +47,26 @@
 #include "server_runsimactiontask.h"
 
 #include "server_runscriptthread.h"
+#include "server_runscriptpool.h"
 
 mbServerRuntime::mbServerRuntime(QObject *parent)
     : mbCoreRuntime{parent}
 {
+    m_scriptPool = nullptr;
 }
 
 void mbServerRuntime::createComponents()
 {
-    mbCoreRuntime::createComponents();
+    // Note: no other thread reads device memory yet, so buffers left by resize of the memory
+    //       (e.g. default memory size of new device) can be freed
+    Q_FOREACH (mbServerDevice *dev, project()->devices())
+        dev->releaseRetiredMemory();
+    createMemoryAliases();
 
-    mbServerRunSimActionTask *simActionTask = new mbServerRunSimActionTask;
-    simActionTask->setActions(project()->simActions());
-    mbCoreRunTaskThread *simActionThread = new mbCoreRunTaskThread(simActionTask);
-    m_taskThreads.append(simActionThread);
+    mbCoreRuntime::createComponents();
 
-    Q_FOREACH (mbServerPort *port, project()->ports())
-        createRunThread(port);
+    createSimActionThreads();
+    createRunThreads();
 
     if (mbServer::global()->scriptEnable())
     {
@@ -82,8 +88,20 @@ void mbServerRuntime::createComponents()
                 scriptfile.close();
             }
         }
+        QList<mbServerRunScriptThread*> scriptThreads;
         Q_FOREACH (mbServerDevice *dev, project()->devices())
-            createScriptThread(dev);
+        {
+            if (mbServerRunScriptThread *t = createScriptThread(dev))
+                scriptThreads.append(t);
+        }
+        // Note: embedded interpreter already runs all scripts within server process,
+        //       so worker pool is used only for external Python processes
+        if (mbServer::global()->scriptWorkerPool() && !mbServer::global()->scriptEmbedded() && scriptThreads.count())
+        {
+            Q_FOREACH (mbServerRunScriptThread *t, scriptThreads)
+                t->setPooled(true);
+            m_scriptPool = new mbServerRunScriptPool(scriptThreads, mbServer::global()->scriptWorkerCount());
+        }
     }
 }
 
@@ -95,6 +113,8 @@ void mbServerRuntime::startComponents()
 
     Q_FOREACH (mbServerRunScriptThread *t, m_scriptThreads)
         t->start();
+    if (m_scriptPool)
+        m_scriptPool->start();
 }
 
 void mbServerRuntime::beginStopComponents()
@@ -105,6 +125,8 @@ void mbServerRuntime::beginStopComponents()
 
     Q_FOREACH (mbServerRunScriptThread *t, m_scriptThreads)
         t->stop();
+    if (m_scriptPool)
+        m_scriptPool->stop();
 }
 
 bool mbServerRuntime::tryStopComponents()
@@ -123,21 +145,308 @@ bool mbServerRuntime::tryStopComponents()
         if (t->isRunning())
             return false;
     }
+    if (m_scriptPool && m_scriptPool->isRunning())
+        return false;
     return true;
 }
 
 void mbServerRuntime::clearComponents()
 {
     mbCoreRuntime::clearComponents();
+    m_simActionTasks.clear();
 
     qDeleteAll(m_threads);
     m_threads.clear();
 
     qDeleteAll(m_scriptThreads);
     m_scriptThreads.clear();
+
+    delete m_scriptPool;
+    m_scriptPool = nullptr;
+
+    clearMemoryAliases();
+}
+
+void mbServerRuntime::createMemoryAliases()
+{
+    struct Item
+    {
+        mbServerDevice *device;
+        QString text;
+        mbServerDevice::MemoryBlock::Alias alias;
+    };
+    typedef QList<Item> Items_t;
+
+    QHash<mbServerDevice::MemoryBlock*, Items_t> blocks;
+    Q_FOREACH (mbServerDevice *dev, project()->devices())
+    {
+        const QStringList entries = dev->memoryAliases().split(';', Qt::SkipEmptyParts);
+        Q_FOREACH (const QString &entry, entries)
+        {
+            // Note: device name is the rest of the entry, so it can contain commas
+            QString text = entry.trimmed();
+            QStringList parts = text.split(',');
+            if (parts.count() < 4)
+            {
+                mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: expected 'address,count,targetAddress,targetDevice'").arg(text));
+                continue;
+            }
+            mb::Address address = mb::toAddress(parts.at(0).trimmed());
+            bool ok;
+            int count = parts.at(1).trimmed().toInt(&ok);
+            mb::Address targetAddress = mb::toAddress(parts.at(2).trimmed());
+            QString targetName = parts.mid(3).join(',').trimmed();
+            mbServerDevice *target = project()->device(targetName);
+            if (!target)
+            {
+                mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: device '%2' not found").arg(text, targetName));
+                continue;
+            }
+            if (!ok || (count <= 0))
+            {
+                mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: invalid count").arg(text));
+                continue;
+            }
+            mbServerDevice::MemoryBlock *mem = dev->memBlock(address.type());
+            mbServerDevice::MemoryBlock *targetMem = target->memBlock(targetAddress.type());
+            bool isBits = (address.type() == Modbus::Memory_0x) || (address.type() == Modbus::Memory_1x);
+            bool isTargetBits = (targetAddress.type() == Modbus::Memory_0x) || (targetAddress.type() == Modbus::Memory_1x);
+            if (!mem || !targetMem || (isBits != isTargetBits))
+            {
+                mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: addresses must be both bits (0x, 1x) or both registers (3x, 4x)").arg(text));
+                continue;
+            }
+            if (mem == targetMem)
+            {
+                mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: alias can't target its own memory").arg(text));
+                continue;
+            }
+            uint offset = address.offset();
+            uint targetOffset = targetAddress.offset();
+            uint c = static_cast<uint>(count);
+            if (isBits)
+            {
+                // Note: aliases are applied to bytes of memory, so bit ranges must be aligned to byte
+                if ((offset % MB_BYTE_SZ_BITES) || (targetOffset % MB_BYTE_SZ_BITES) || (c % MB_BYTE_SZ_BITES))
+                {
+                    mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: bit offsets and count must be multiple of %2").arg(text).arg(MB_BYTE_SZ_BITES));
+                    continue;
+                }
+                offset /= MB_BYTE_SZ_BITES;
+                targetOffset /= MB_BYTE_SZ_BITES;
+                c /= MB_BYTE_SZ_BITES;
+            }
+            else
+            {
+                offset *= MB_REGE_SZ_BYTES;
+                targetOffset *= MB_REGE_SZ_BYTES;
+                c *= MB_REGE_SZ_BYTES;
+            }
+            if (((offset + c) > static_cast<uint>(mem->sizeBytes())) || ((targetOffset + c) > static_cast<uint>(targetMem->sizeBytes())))
+            {
+                mbServer::LogWarning(dev->name(), QString("Memory alias '%1' is ignored: range is out of memory").arg(text));
+                continue;
+            }
+            Item item;
+            item.device = dev;
+            item.text = text;
+            item.alias.offset = offset;
+            item.alias.count = c;
+            item.alias.target = targetMem;
+            item.alias.targetOffset = targetOffset;
+            blocks[mem].append(item);
+        }
+    }
+
+    for (auto it = blocks.begin(); it != blocks.end(); ++it)
+    {
+        Items_t &items = it.value();
+        std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) { return a.alias.offset < b.alias.offset; });
+        Items_t valid;
+        Q_FOREACH (const Item &item, items)
+        {
+            const mbServerDevice::MemoryBlock::Alias &a = item.alias;
+            bool overlap = false;
+            Q_FOREACH (const Item &v, valid)
+            {
+                const mbServerDevice::MemoryBlock::Alias &b = v.alias;
+                if (((a.offset < (b.offset + b.count)) && (b.offset < (a.offset + a.count))) ||
+                    ((a.target == b.target) && (a.targetOffset < (b.targetOffset + b.count)) && (b.targetOffset < (a.targetOffset + a.count))))
+                {
+                    overlap = true;
+                    break;
+                }
+            }
+            if (overlap)
+            {
+                mbServer::LogWarning(item.device->name(), QString("Memory alias '%1' is ignored: it overlaps other alias").arg(item.text));
+                continue;
+            }
+            valid.append(item);
+        }
+        items = valid;
+    }
+
+    // Note: forwarding is single-level, so target range can't be forwarded again
+    for (auto it = blocks.begin(); it != blocks.end(); ++it)
+    {
+        Items_t valid;
+        Q_FOREACH (const Item &item, it.value())
+        {
+            const mbServerDevice::MemoryBlock::Alias &a = item.alias;
+            bool chained = false;
+            Q_FOREACH (const Item &t, blocks.value(a.target))
+            {
+                const mbServerDevice::MemoryBlock::Alias &b = t.alias;
+                if ((a.targetOffset < (b.offset + b.count)) && (b.offset < (a.targetOffset + a.count)))
+                {
+                    chained = true;
+                    break;
+                }
+            }
+            if (chained)
+            {
+                mbServer::LogWarning(item.device->name(), QString("Memory alias '%1' is ignored: target range is aliased itself").arg(item.text));
+                continue;
+            }
+            valid.append(item);
+        }
+        if (valid.isEmpty())
+            continue;
+        mbServerDevice::MemoryBlock::Aliases_t aliases;
+        Q_FOREACH (const Item &item, valid)
+            aliases.append(item.alias);
+        it.key()->setAliases(aliases);
+        m_aliasedBlocks.append(it.key());
+    }
+}
+
+void mbServerRuntime::clearMemoryAliases()
+{
+    Q_FOREACH (mbServerDevice::MemoryBlock *mem, m_aliasedBlocks)
+        mem->clearAliases();
+    m_aliasedBlocks.clear();
+}
+
+void mbServerRuntime::createRunThreads()
+{
+    QList<mbServerPort*> ports = project()->ports();
+    if (!mbServer::global()->runtimeWorkerPool())
+    {
+        Q_FOREACH (mbServerPort *port, ports)
+            m_threads.append(new mbServerRunThread(port, createRunDevice(port)));
+        return;
+    }
+    QList<mbServerPort*> pooled;
+    Q_FOREACH (mbServerPort *port, ports)
+    {
+        // Note: polling port would make the whole worker to poll, so it gets its own thread
+        if (port->runMode() == mbServerPort::Polling)
+        {
+            mbServer::LogWarning(port->name(), QStringLiteral("Port has 'Polling' run mode so it's served by its own thread instead of worker pool"));
+            m_threads.append(new mbServerRunThread(port, createRunDevice(port)));
+        }
+        else
+            pooled.append(port);
+    }
+    if (pooled.isEmpty())
+        return;
+    int count = mbServer::global()->runtimeWorkerCount();
+    if (count <= 0)
+        count = QThread::idealThreadCount();
+    if (count > pooled.count())
+        count = pooled.count();
+    for (int i = 0; i < count; i++)
+    {
+        mbServerRunThread *t = new mbServerRunThread();
+        t->setObjectName(QString("Worker %1").arg(i+1));
+        m_threads.append(t);
+    }
+    // Note: ports are distributed round-robin so every worker gets nearly equal part of the ports
+    int first = m_threads.count() - count;
+    for (int i = 0; i < pooled.count(); i++)
+    {
+        mbServerPort *port = pooled.at(i);
+        m_threads.at(first + (i % count))->addPort(port, createRunDevice(port));
+    }
+}
+
+void mbServerRuntime::createSimActionThreads()
+{
+    QList<mbServerSimAction*> actions = project()->simActions();
+    QList<mbServerDevice*> devices;
+    QHash<mbServerDevice*, QList<mbServerSimAction*> > deviceActions;
+    Q_FOREACH (mbServerSimAction *a, actions)
+    {
+        mbServerDevice *dev = a->device();
+        if (!dev)
+            continue;
+        if (!deviceActions.contains(dev))
+            devices.append(dev);
+        deviceActions[dev].append(a);
+    }
+
+    int count = mbServer::global()->runtimeSimActionThreads();
+    if (count <= 0)
+        count = QThread::idealThreadCount();
+    if (count > devices.count())
+        count = devices.count();
+    if (count < 1)
+        count = 1;
+
+    QVector<QList<mbServerSimAction*> > shards(count);
+    if (count == 1)
+        shards[0] = actions;
+    else
+    {
+        // Note: every device belongs to the single shard, so actions of different shards never
+        //       access the same device memory. Device with most actions goes to the least loaded shard
+        std::stable_sort(devices.begin(), devices.end(), [&deviceActions](mbServerDevice *a, mbServerDevice *b)
+        {
+            return deviceActions.value(a).count() > deviceActions.value(b).count();
+        });
+        QVector<int> load(count, 0);
+        Q_FOREACH (mbServerDevice *dev, devices)
+        {
+            int shard = 0;
+            for (int i = 1; i < count; i++)
+            {
+                if (load.at(i) < load.at(shard))
+                    shard = i;
+            }
+            const QList<mbServerSimAction*> &ls = deviceActions[dev];
+            shards[shard].append(ls);
+            load[shard] += ls.count();
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        mbServerRunSimActionTask *simActionTask = new mbServerRunSimActionTask;
+        simActionTask->setShard(i+1);
+        simActionTask->setActions(shards.at(i));
+        mbCoreRunTaskThread *simActionThread = new mbCoreRunTaskThread(simActionTask);
+        simActionThread->setObjectName(QString("SimAction %1").arg(i+1));
+        m_taskThreads.append(simActionThread);
+        m_simActionTasks.append(simActionTask);
+    }
+}
+
+mbServerRuntime::SimActionStatistic mbServerRuntime::simActionStatistic() const
+{
+    SimActionStatistic r;
+    Q_FOREACH (mbServerRunSimActionTask *task, m_simActionTasks)
+    {
+        r.actions      += task->actionCount();
+        r.execCount    += task->execCount();
+        r.overrunCount += task->overrunCount();
+        if (task->maxLateness() > r.maxLateness)
+            r.maxLateness = task->maxLateness();
+    }
+    return r;
 }
 
-mbServerRunThread *mbServerRuntime::createRunThread(mbServerPort *port)
+mbServerRunDevice *mbServerRuntime::createRunDevice(mbServerPort *port)
 {
     mbServerRunDevice *device = new mbServerRunDevice();
     device->setBroadcastEnabled(port->isBroadcastEnabled());
@@ -147,9 +456,7 @@ mbServerRunThread *mbServerRuntime::createRunThread(mbServerPort *port)
         if (ref)
             device->setDevice(static_cast<quint8>(unit), ref->device());
     }
-    mbServerRunThread *t = new mbServerRunThread(port, device);
-    m_threads.insert(port, t);
-    return t;
+    return device;
 }
 
 mbServerRunScriptThread *mbServerRuntime::createScriptThread(mbServerDevice *device)
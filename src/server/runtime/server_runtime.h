@@ -25,16 +25,37 @@
 
 #include <server_global.h>
 #include <project/server_project.h>
+#include <project/server_device.h>
 #include <runtime/core_runtime.h>
 
 class mbServerProject;
 class mbServerPort;
 class mbServerDevice;
 class mbServerRunThread;
+class mbServerRunDevice;
 class mbServerRunScriptThread;
+class mbServerRunScriptPool;
+class mbServerRunSimActionTask;
 
 class mbServerRuntime : public mbCoreRuntime
 {
+public:
+    // Summary statistic of all simulation action shards of the current run
+    struct SimActionStatistic
+    {
+        SimActionStatistic()
+        {
+            actions = 0;
+            execCount = 0;
+            overrunCount = 0;
+            maxLateness = 0;
+        }
+        int     actions     ;
+        quint64 execCount   ;
+        quint64 overrunCount; // executions which were late at least for one whole period of the action
+        qint64  maxLateness ; // milliseconds
+    };
+
 public:
     explicit mbServerRuntime(QObject *parent = nullptr);
 
@@ -46,6 +67,10 @@ public:
     void start();
     void stop();
 
+public: // statistic
+    // Note: counters of the shards are atomic, so statistic can be read while simulation is running
+    SimActionStatistic simActionStatistic() const;
+
 private:
     void createComponents() override;
     void startComponents() override;
@@ -54,15 +79,26 @@ private:
     void clearComponents() override;
 
 private:
-    mbServerRunThread *createRunThread(mbServerPort *port);
+    void createMemoryAliases();
+    void clearMemoryAliases();
+    void createRunThreads();
+    void createSimActionThreads();
+    mbServerRunDevice *createRunDevice(mbServerPort *port);
     mbServerRunScriptThread *createScriptThread(mbServerDevice *device);
 
 private: // threads
-    typedef QHash<mbServerPort*, mbServerRunThread*> Threads_t;
+    typedef QList<mbServerRunThread*> Threads_t;
     Threads_t m_threads;
 
+    typedef QList<mbServerRunSimActionTask*> SimActionTasks_t;
+    SimActionTasks_t m_simActionTasks; // owned by task threads
+
     typedef QHash<mbServerDevice*, mbServerRunScriptThread*> ScriptThreads_t;
     ScriptThreads_t m_scriptThreads;
+    mbServerRunScriptPool *m_scriptPool;
+
+private: // memory
+    QList<mbServerDevice::MemoryBlock*> m_aliasedBlocks;
 };
 
 #endif // SERVER_RUNTIME_H
@@ -0,0 +1,190 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_runwaiter.h"
+
+#ifdef Q_OS_LINUX
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <QFile>
+#include <QVarLengthArray>
+#endif
+
+mbServerRunWaiter::mbServerRunWaiter()
+{
+#ifdef Q_OS_LINUX
+    m_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+mbServerRunWaiter::~mbServerRunWaiter()
+{
+#ifdef Q_OS_LINUX
+    if (m_eventfd >= 0)
+        ::close(m_eventfd);
+#endif
+}
+
+bool mbServerRunWaiter::isHandlesSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool mbServerRunWaiter::contextSwitches(quint64 *voluntary, quint64 *involuntary)
+{
+#ifdef Q_OS_LINUX
+    struct rusage u;
+    if (getrusage(RUSAGE_THREAD, &u) == 0)
+    {
+        *voluntary = static_cast<quint64>(u.ru_nvcsw);
+        *involuntary = static_cast<quint64>(u.ru_nivcsw);
+        return true;
+    }
+    return false;
+#else
+    Q_UNUSED(voluntary)
+    Q_UNUSED(involuntary)
+    return false;
+#endif
+}
+
+void mbServerRunWaiter::wakeup()
+{
+#ifdef Q_OS_LINUX
+    if (m_eventfd >= 0)
+    {
+        uint64_t v = 1;
+        ssize_t r = ::write(m_eventfd, &v, sizeof(v));
+        Q_UNUSED(r)
+    }
+#else
+    if (m_sem.available() == 0)
+        m_sem.release();
+#endif
+}
+
+bool mbServerRunWaiter::wait(const Handles_t &handles, int msec)
+{
+#ifdef Q_OS_LINUX
+    // Note: worker thread can serve many ports with many connections, so count of descriptors is not limited
+    QVarLengthArray<struct pollfd, 64> fds(handles.count() + 1);
+    nfds_t c = 0;
+    if (m_eventfd >= 0)
+    {
+        fds[c].fd = m_eventfd;
+        fds[c].events = POLLIN;
+        fds[c].revents = 0;
+        ++c;
+    }
+    for (int i = 0; i < handles.count(); i++)
+    {
+        if (handles.at(i) < 0)
+            continue;
+        fds[c].fd = handles.at(i);
+        fds[c].events = POLLIN;
+        fds[c].revents = 0;
+        ++c;
+    }
+    int r = poll(fds.data(), c, msec);
+    if (r <= 0)
+        return false;
+    if ((m_eventfd >= 0) && (fds[0].revents & POLLIN))
+    {
+        uint64_t v;
+        ssize_t rd = ::read(m_eventfd, &v, sizeof(v)); // Note: reset eventfd counter
+        Q_UNUSED(rd)
+    }
+    return true;
+#else
+    Q_UNUSED(handles)
+    return m_sem.tryAcquire(1, msec);
+#endif
+}
+
+mbServerRunNotifyPipe::mbServerRunNotifyPipe()
+{
+    m_fdRead = -1;
+    m_fdWrite = -1;
+}
+
+mbServerRunNotifyPipe::~mbServerRunNotifyPipe()
+{
+    close();
+}
+
+bool mbServerRunNotifyPipe::open(const QString &path)
+{
+    close();
+#ifdef Q_OS_LINUX
+    QByteArray p = QFile::encodeName(path);
+    ::unlink(p.constData());
+    if (mkfifo(p.constData(), 0600) != 0)
+        return false;
+    m_path = path;
+    m_fdRead = ::open(p.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fdRead < 0)
+    {
+        close();
+        return false;
+    }
+    // Note: own write end keeps the pipe from signaling hang up when writer process is closed
+    m_fdWrite = ::open(p.constData(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    return true;
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
+void mbServerRunNotifyPipe::close()
+{
+#ifdef Q_OS_LINUX
+    if (m_fdWrite >= 0)
+        ::close(m_fdWrite);
+    if (m_fdRead >= 0)
+        ::close(m_fdRead);
+    if (m_path.count())
+        ::unlink(QFile::encodeName(m_path).constData());
+#endif
+    m_fdRead = -1;
+    m_fdWrite = -1;
+    m_path.clear();
+}
+
+void mbServerRunNotifyPipe::drain()
+{
+#ifdef Q_OS_LINUX
+    if (m_fdRead < 0)
+        return;
+    char buff[64];
+    while (::read(m_fdRead, buff, sizeof(buff)) > 0)
+        ;
+#endif
+}
@@ -0,0 +1,91 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_RUNWAITER_H
+#define SERVER_RUNWAITER_H
+
+#include <QVector>
+#include <QSemaphore>
+#include <QString>
+
+// Blocks the calling runtime thread until one of the given file descriptors
+// becomes readable, 'wakeup()' is called from another thread or timeout expires.
+// On Linux it's implemented with 'poll()' over the descriptors and an 'eventfd'
+// used as wakeup channel. On other systems descriptors are ignored and the
+// waiter sleeps on a semaphore which is released by 'wakeup()'.
+class mbServerRunWaiter
+{
+public:
+    typedef QVector<int> Handles_t;
+
+public:
+    mbServerRunWaiter();
+    ~mbServerRunWaiter();
+
+public:
+    // Returns 'true' if descriptors can be used to wait for port readiness
+    static bool isHandlesSupported();
+    // Gets count of context switches of the calling thread.
+    // Returns 'false' if it's not supported by OS (values are not changed)
+    static bool contextSwitches(quint64 *voluntary, quint64 *involuntary);
+
+public:
+    void wakeup();
+    // Returns 'true' if waiter was woken by descriptor readiness or by 'wakeup()'
+    // and 'false' if timeout is expired
+    bool wait(const Handles_t &handles, int msec);
+    inline bool wait(int msec) { return wait(Handles_t(), msec); }
+
+private:
+#ifdef Q_OS_LINUX
+    int m_eventfd;
+#else
+    QSemaphore m_sem;
+#endif
+};
+
+// Named pipe (FIFO) that lets another process (e.g. Python script) to wake up
+// runtime thread: process writes any byte into the pipe and thread waiting for
+// the 'handle()' with 'mbServerRunWaiter' is woken.
+// It's available only when 'mbServerRunWaiter::isHandlesSupported()' is true.
+class mbServerRunNotifyPipe
+{
+public:
+    mbServerRunNotifyPipe();
+    ~mbServerRunNotifyPipe();
+
+public:
+    inline bool isOpen() const { return m_fdRead >= 0; }
+    inline QString path() const { return m_path; }
+    inline int handle() const { return m_fdRead; }
+    bool open(const QString &path);
+    void close();
+    // Reads all pending notifications so the next wait is not woken by them
+    void drain();
+
+private:
+    QString m_path;
+    int m_fdRead;
+    int m_fdWrite;
+};
+
+#endif // SERVER_RUNWAITER_H
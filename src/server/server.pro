@@ -33,6 +33,16 @@ RESOURCES += \
 LIBS  += -L../../bin -lcore
 LIBS  += -L../../bin -lmodbus
 
+# Embedded Python interpreter to run device scripts within server process:
+# qmake "CONFIG+=mb_python_embedded"
+mb_python_embedded {
+    DEFINES += MB_PYTHON_EMBEDDED
+    unix {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += python3-embed
+    }
+}
+
 RC_ICONS = gui/icons/server.ico
 
 DISTFILES += \
@@ -0,0 +1,298 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// Benchmark of 'mbServerDevice::MemoryBlock'.
+// 1. Bit and bool access functions: current implementation (64-bit word kernels) is compared with
+//    previous byte/bit loops that are kept here as reference. Note that reference loops access plain
+//    memory directly, while current functions are measured through 'MemoryBlock' API including its synchronization.
+// 2. Readers scaling: seqlock of 'MemoryBlock' is compared with 'QReadWriteLock' that was used before
+//    for 1, 4 and 16 reader threads while one writer thread changes the memory all the time.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <QReadWriteLock>
+
+#include <project/server_device.h>
+
+typedef mbServerDevice::MemoryBlock MemoryBlock;
+
+// Count of bits (coils) per call and their offset within memory
+#define BENCH_BIT_COUNT  2000
+#define BENCH_BIT_OFFSET 3
+#define BENCH_ITERATIONS 200000
+// Count of registers per read (max count of Modbus request) and duration (milliseconds) of every readers test
+#define BENCH_READ_REGS    125
+#define BENCH_READ_MSEC    500
+
+namespace legacy {
+
+static void readBits(const quint8 *mem, uint bitOffset, uint c, quint8 *buff)
+{
+    mem += bitOffset/MB_BYTE_SZ_BITES;
+    uint bytes = c/MB_BYTE_SZ_BITES;
+    uint shift = bitOffset%MB_BYTE_SZ_BITES;
+    if (shift)
+    {
+        for (uint i = 0; i < bytes; i++)
+        {
+            quint16 v;
+            memcpy(&v, &mem[i], sizeof(v));
+            buff[i] = static_cast<quint8>(v >> shift);
+        }
+        if (quint16 resid = c%MB_BYTE_SZ_BITES)
+        {
+            quint8 mask = static_cast<quint8>((1 << resid) - 1);
+            quint16 v;
+            memcpy(&v, &mem[bytes], sizeof(v));
+            buff[bytes] = static_cast<quint8>(v >> shift) & mask;
+        }
+    }
+    else
+    {
+        memcpy(buff, mem, bytes);
+        if (quint16 resid = c%MB_BYTE_SZ_BITES)
+            buff[bytes] = mem[bytes] & static_cast<quint8>((1 << resid) - 1);
+    }
+}
+
+static void writeBits(quint8 *mem, uint bitOffset, uint c, const quint8 *buff)
+{
+    mem += bitOffset/MB_BYTE_SZ_BITES;
+    uint bytes = c/MB_BYTE_SZ_BITES;
+    uint shift = bitOffset%MB_BYTE_SZ_BITES;
+    if (shift)
+    {
+        for (uint i = 0; i < bytes; i++)
+        {
+            quint16 mask = static_cast<quint16>(0x00FF) << shift;
+            quint16 v = static_cast<quint16>(buff[i]) << shift;
+            quint16 m;
+            memcpy(&m, &mem[i], sizeof(m));
+            m = (m & ~mask) | v;
+            memcpy(&mem[i], &m, sizeof(m));
+        }
+        if (quint16 resid = c%MB_BYTE_SZ_BITES)
+        {
+            quint16 mask = static_cast<quint16>(((1 << resid) - 1) << shift);
+            quint16 v = (static_cast<quint16>(buff[bytes]) << shift) & mask;
+            quint16 m;
+            memcpy(&m, &mem[bytes], sizeof(m));
+            m = (m & ~mask) | v;
+            memcpy(&mem[bytes], &m, sizeof(m));
+        }
+    }
+    else
+    {
+        memcpy(mem, buff, bytes);
+        if (quint16 resid = c%MB_BYTE_SZ_BITES)
+        {
+            quint8 mask = static_cast<quint8>((1 << resid) - 1);
+            mem[bytes] = (mem[bytes] & ~mask) | (buff[bytes] & mask);
+        }
+    }
+}
+
+static void readBools(const quint8 *mem, uint bitOffset, uint c, bool *values)
+{
+    mem += bitOffset/MB_BYTE_SZ_BITES;
+    uint bit = bitOffset%MB_BYTE_SZ_BITES;
+    for (uint by = 0, i = 0; i < c; by++)
+    {
+        for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
+            values[i] = (mem[by] & (1<<bi)) != 0;
+        bit = 0;
+    }
+}
+
+static void writeBools(quint8 *mem, uint bitOffset, uint c, const bool *values)
+{
+    mem += bitOffset/MB_BYTE_SZ_BITES;
+    uint bit = bitOffset%MB_BYTE_SZ_BITES;
+    for (uint by = 0, i = 0; i < c; by++)
+    {
+        for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
+        {
+            if (values[i])
+                mem[by] |= (1<<bi);
+            else
+                mem[by] &= ~(1<<bi);
+        }
+        bit = 0;
+    }
+}
+
+} // namespace legacy
+
+static volatile int s_sink = 0;
+
+// Returns average time (nanoseconds) of single call of 'f'
+template <class F>
+static double measure(F f)
+{
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t).count() / BENCH_ITERATIONS;
+}
+
+static void print(const char *name, double legacyTime, double currentTime)
+{
+    printf("%-11s %9.0f ns %9.0f ns %7.1fx\n", name, legacyTime, currentTime, legacyTime / currentTime);
+}
+
+static void benchBits(bool sparse)
+{
+    const uint bytes = 8192;
+    MemoryBlock mem;
+    mem.setSparse(sparse);
+    mem.resize(bytes);
+    std::vector<quint8> plain(bytes + 1, 0);
+    std::vector<quint8> buff(BENCH_BIT_COUNT/8 + 1);
+    std::vector<char> bools(BENCH_BIT_COUNT);
+    for (size_t i = 0; i < bools.size(); i++)
+        bools[i] = (i % 3) == 0;
+    for (size_t i = 0; i < buff.size(); i++)
+        buff[i] = static_cast<quint8>(i * 37);
+    // Note: memory is filled, so sparse block has all its pages allocated
+    mem.writeBits(0, bytes * 8, plain.data());
+    mem.writeBits(BENCH_BIT_OFFSET, BENCH_BIT_COUNT, buff.data());
+    legacy::writeBits(plain.data(), BENCH_BIT_OFFSET, BENCH_BIT_COUNT, buff.data());
+    bool *values = reinterpret_cast<bool*>(bools.data());
+
+    printf("\n%s memory, %d bits at bit offset %d:\n", sparse ? "Sparse" : "Dense", BENCH_BIT_COUNT, BENCH_BIT_OFFSET);
+    printf("%-11s %12s %12s %8s\n", "function", "previous", "current", "speedup");
+    print("readBits",
+          measure([&]() { legacy::readBits(plain.data(), BENCH_BIT_OFFSET, BENCH_BIT_COUNT, buff.data()); s_sink += buff[5]; }),
+          measure([&]() { mem.readBits(BENCH_BIT_OFFSET, BENCH_BIT_COUNT, buff.data()); s_sink += buff[5]; }));
+    print("writeBits",
+          measure([&]() { legacy::writeBits(plain.data(), BENCH_BIT_OFFSET, BENCH_BIT_COUNT, buff.data()); }),
+          measure([&]() { mem.writeBits(BENCH_BIT_OFFSET, BENCH_BIT_COUNT, buff.data()); }));
+    print("readBools",
+          measure([&]() { legacy::readBools(plain.data(), BENCH_BIT_OFFSET, BENCH_BIT_COUNT, values); s_sink += bools[7]; }),
+          measure([&]() { mem.readBools(BENCH_BIT_OFFSET, BENCH_BIT_COUNT, values); s_sink += bools[7]; }));
+    print("writeBools",
+          measure([&]() { legacy::writeBools(plain.data(), BENCH_BIT_OFFSET, BENCH_BIT_COUNT, values); }),
+          measure([&]() { mem.writeBools(BENCH_BIT_OFFSET, BENCH_BIT_COUNT, values); }));
+}
+
+// Memory protected by 'QReadWriteLock' the same way as 'MemoryBlock' was before seqlock
+class LockedMemory
+{
+public:
+    LockedMemory(int regs) : m_data(static_cast<size_t>(regs), 0) {}
+
+public:
+    void readRegs(uint offset, uint count, quint16 *values)
+    {
+        m_lock.lockForRead();
+        memcpy(values, &m_data[offset], count * sizeof(quint16));
+        m_lock.unlock();
+    }
+
+    void writeRegs(uint offset, uint count, const quint16 *values)
+    {
+        m_lock.lockForWrite();
+        memcpy(&m_data[offset], values, count * sizeof(quint16));
+        m_lock.unlock();
+    }
+
+private:
+    QReadWriteLock m_lock;
+    std::vector<quint16> m_data;
+};
+
+// Runs 'threads' readers and one writer of 'mem' during 'BENCH_READ_MSEC'.
+// Returns count of reads per second (all readers)
+template <class Memory>
+static double measureReaders(Memory &mem, int threads)
+{
+    std::atomic<bool> run(true);
+    std::atomic<quint64> reads(0);
+    std::atomic<uint> sink(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; t++)
+    {
+        readers.emplace_back([&, t]()
+        {
+            quint16 values[BENCH_READ_REGS];
+            quint64 c = 0;
+            uint check = 0;
+            uint offset = static_cast<uint>(t % 8) * BENCH_READ_REGS;
+            while (run.load(std::memory_order_relaxed))
+            {
+                mem.readRegs(offset, BENCH_READ_REGS, values);
+                check += values[0];
+                ++c;
+            }
+            reads.fetch_add(c);
+            sink.fetch_add(check); // Note: result of reading is used, so it's not optimized out
+        });
+    }
+    std::thread writer([&]()
+    {
+        quint16 v = 0;
+        while (run.load(std::memory_order_relaxed))
+        {
+            mem.writeRegs(v % 1000, 1, &v);
+            ++v;
+        }
+    });
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_READ_MSEC));
+    run.store(false);
+    for (size_t i = 0; i < readers.size(); i++)
+        readers[i].join();
+    writer.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+    s_sink += static_cast<int>(sink.load());
+    return reads.load() / sec;
+}
+
+static void benchReaders()
+{
+    printf("\nReaders of %d registers with one writer, reads per second (all readers):\n", BENCH_READ_REGS);
+    printf("%-8s %14s %14s %8s\n", "readers", "QReadWriteLock", "seqlock", "speedup");
+    const int threads[] = { 1, 4, 16 };
+    for (size_t i = 0; i < sizeof(threads)/sizeof(threads[0]); i++)
+    {
+        LockedMemory locked(8 * BENCH_READ_REGS);
+        MemoryBlock mem;
+        mem.resizeRegs(8 * BENCH_READ_REGS);
+        double lockedRate = measureReaders(locked, threads[i]);
+        double seqlockRate = measureReaders(mem, threads[i]);
+        printf("%-8d %14.0f %14.0f %7.1fx\n", threads[i], lockedRate, seqlockRate, seqlockRate / lockedRate);
+    }
+    printf("Hardware threads: %u\n", std::thread::hardware_concurrency());
+}
+
+int main()
+{
+    benchBits(false);
+    benchBits(true);
+    benchReaders();
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// Checks 'mbServerDevice::MemoryBlock' bit and bool access functions against simple bit model
+// for all bit offsets within 64-bit word and all lengths up to several words on dense and sparse memory.
+// Also checks that lock-free readers never see partially written data.
+// Returns 0 if all checks passed.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <project/server_device.h>
+
+typedef mbServerDevice::MemoryBlock MemoryBlock;
+typedef std::vector<quint8> Bytes;
+
+// Max bit offset (exclusive) and bit count of checked ranges
+#define TEST_MAX_OFFSET 64
+#define TEST_MAX_COUNT  520
+// Size (bytes) of tested memory block
+#define TEST_BLOCK_SIZE 160
+// Count of registers written at once and count of write operations of the concurrency test
+#define TEST_CONCURRENT_REGS   125
+#define TEST_CONCURRENT_WRITES 200000
+#define TEST_CONCURRENT_READERS 4
+
+static int s_errors = 0;
+
+#define TEST_CHECK(cond, ...)                       \
+    if (!(cond))                                    \
+    {                                               \
+        fprintf(stderr, "FAILED: " __VA_ARGS__);    \
+        fprintf(stderr, "\n");                      \
+        if (++s_errors > 20)                        \
+            return;                                 \
+    }
+
+static inline bool getBit(const Bytes &v, uint i)
+{
+    return (v[i/8] >> (i%8)) & 1;
+}
+
+static inline void setBit(Bytes &v, uint i, bool value)
+{
+    if (value)
+        v[i/8] |= static_cast<quint8>(1 << (i%8));
+    else
+        v[i/8] &= static_cast<quint8>(~(1 << (i%8)));
+}
+
+static Bytes dump(MemoryBlock &mem)
+{
+    Bytes v(static_cast<size_t>(mem.size()));
+    mem.memGet(0, v.data(), v.size());
+    return v;
+}
+
+static Bytes randomBytes(std::mt19937 &rng, size_t size)
+{
+    Bytes v(size);
+    for (size_t i = 0; i < size; i++)
+        v[i] = static_cast<quint8>(rng());
+    return v;
+}
+
+static void testBits(bool sparse)
+{
+    const char *kind = sparse ? "sparse" : "dense";
+    std::mt19937 rng(1);
+    MemoryBlock mem;
+    mem.setSparse(sparse);
+    mem.resize(TEST_BLOCK_SIZE);
+    for (uint offset = 0; offset < TEST_MAX_OFFSET; offset++)
+    {
+        for (uint count = 0; count <= TEST_MAX_COUNT; count++)
+        {
+            Bytes model = randomBytes(rng, TEST_BLOCK_SIZE);
+            mem.write(0, TEST_BLOCK_SIZE, model.data());
+            uint fact;
+            Modbus::StatusCode status;
+
+            // readBits: unused bits of the last byte must be zero
+            Bytes bits(TEST_MAX_COUNT/8 + 2, 0xAA);
+            fact = 0;
+            status = mem.readBits(offset, count, bits.data(), &fact);
+            if (count)
+            {
+                TEST_CHECK(status == Modbus::Status_Good, "%s readBits status offset=%u count=%u", kind, offset, count);
+                TEST_CHECK(fact == count, "%s readBits fact offset=%u count=%u", kind, offset, count);
+            }
+            for (uint i = 0; i < count; i++)
+                TEST_CHECK(getBit(bits, i) == getBit(model, offset+i), "%s readBits offset=%u count=%u bit=%u", kind, offset, count, i);
+            for (uint i = count; i < (count+7)/8*8; i++)
+                TEST_CHECK(!getBit(bits, i), "%s readBits tail offset=%u count=%u bit=%u", kind, offset, count, i);
+
+            // readBools: values after the range must not be changed
+            std::vector<char> bools(count + 8, 5);
+            status = mem.readBools(offset, count, reinterpret_cast<bool*>(bools.data()));
+            if (count)
+                TEST_CHECK(status == Modbus::Status_Good, "%s readBools status offset=%u count=%u", kind, offset, count);
+            for (uint i = 0; i < count; i++)
+                TEST_CHECK(bools[i] == static_cast<char>(getBit(model, offset+i)), "%s readBools offset=%u count=%u bool=%u", kind, offset, count, i);
+            TEST_CHECK(bools[count] == 5, "%s readBools overrun offset=%u count=%u", kind, offset, count);
+
+            // writeBits: bits outside of the range must be kept
+            Bytes src = randomBytes(rng, TEST_MAX_COUNT/8 + 2);
+            status = mem.writeBits(offset, count, src.data());
+            if (count)
+                TEST_CHECK(status == Modbus::Status_Good, "%s writeBits status offset=%u count=%u", kind, offset, count);
+            for (uint i = 0; i < count; i++)
+                setBit(model, offset+i, getBit(src, i));
+            TEST_CHECK(dump(mem) == model, "%s writeBits offset=%u count=%u", kind, offset, count);
+
+            // writeBools
+            for (uint i = 0; i < count; i++)
+                bools[i] = static_cast<char>(rng() % 2);
+            status = mem.writeBools(offset, count, reinterpret_cast<const bool*>(bools.data()));
+            if (count)
+                TEST_CHECK(status == Modbus::Status_Good, "%s writeBools status offset=%u count=%u", kind, offset, count);
+            for (uint i = 0; i < count; i++)
+                setBit(model, offset+i, bools[i] != 0);
+            TEST_CHECK(dump(mem) == model, "%s writeBools offset=%u count=%u", kind, offset, count);
+        }
+    }
+}
+
+static void testCopyBits(bool dstSparse, bool srcSparse)
+{
+    const char *dstKind = dstSparse ? "sparse" : "dense";
+    const char *srcKind = srcSparse ? "sparse" : "dense";
+    std::mt19937 rng(2);
+    MemoryBlock dst, src;
+    dst.setSparse(dstSparse);
+    src.setSparse(srcSparse);
+    dst.resize(TEST_BLOCK_SIZE);
+    src.resize(TEST_BLOCK_SIZE);
+    const uint sizeBits = TEST_BLOCK_SIZE * 8;
+    for (uint srcShift = 0; srcShift < 8; srcShift++)
+    {
+        for (uint dstShift = 0; dstShift < 8; dstShift++)
+        {
+            for (uint count = 1; count <= TEST_MAX_COUNT; count++)
+            {
+                for (int same = 0; same < 2; same++)
+                {
+                    Bytes modelDst = randomBytes(rng, TEST_BLOCK_SIZE);
+                    Bytes modelSrc = randomBytes(rng, TEST_BLOCK_SIZE);
+                    dst.write(0, TEST_BLOCK_SIZE, modelDst.data());
+                    src.write(0, TEST_BLOCK_SIZE, modelSrc.data());
+                    MemoryBlock *from = same ? &dst : &src;
+                    const Bytes &modelFrom = same ? modelDst : modelSrc;
+                    uint srcOffset = srcShift + 8 * (rng() % 32);
+                    uint dstOffset = dstShift + 8 * (rng() % 32);
+                    uint c = count;
+                    if (c > sizeBits - srcOffset)
+                        c = sizeBits - srcOffset;
+                    if (c > sizeBits - dstOffset)
+                        c = sizeBits - dstOffset;
+                    // Note: source is read before destination is written, so ranges can overlap
+                    std::vector<bool> copied(c);
+                    for (uint i = 0; i < c; i++)
+                        copied[i] = getBit(modelFrom, srcOffset+i);
+                    for (uint i = 0; i < c; i++)
+                        setBit(modelDst, dstOffset+i, copied[i]);
+                    uint fact = 0;
+                    dst.copyBits(dstOffset, from, srcOffset, count, &fact);
+                    TEST_CHECK(fact == c, "copyBits %s<-%s fact dst=%u src=%u count=%u same=%d", dstKind, srcKind, dstOffset, srcOffset, count, same);
+                    TEST_CHECK(dump(dst) == modelDst, "copyBits %s<-%s dst=%u src=%u count=%u same=%d", dstKind, srcKind, dstOffset, srcOffset, count, same);
+                    if (!same)
+                        TEST_CHECK(dump(src) == modelSrc, "copyBits %s<-%s source changed", dstKind, srcKind);
+                }
+            }
+        }
+    }
+}
+
+// Writer fills the range of registers with the same value while readers check
+// that all registers of every read have the same value (seqlock never returns torn data)
+static void testConcurrentRead(bool sparse)
+{
+    const char *kind = sparse ? "sparse" : "dense";
+    MemoryBlock mem;
+    mem.setSparse(sparse);
+    mem.resizeRegs(1024);
+    const uint offset = 300; // Note: range crosses page boundaries of sparse memory
+    std::atomic<bool> run(true);
+    std::atomic<int> torn(0);
+    std::atomic<quint64> reads(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < TEST_CONCURRENT_READERS; t++)
+    {
+        readers.emplace_back([&]()
+        {
+            quint16 values[TEST_CONCURRENT_REGS];
+            quint64 c = 0;
+            while (run.load(std::memory_order_relaxed))
+            {
+                mem.readRegs(offset, TEST_CONCURRENT_REGS, values);
+                for (int i = 1; i < TEST_CONCURRENT_REGS; i++)
+                {
+                    if (values[i] != values[0])
+                    {
+                        torn.fetch_add(1);
+                        break;
+                    }
+                }
+                ++c;
+            }
+            reads.fetch_add(c);
+        });
+    }
+    quint16 values[TEST_CONCURRENT_REGS];
+    for (int w = 0; w < TEST_CONCURRENT_WRITES; w++)
+    {
+        // Note: the first value is zero, so pages of sparse memory are allocated while readers are active
+        quint16 v = static_cast<quint16>(w % 7);
+        for (int i = 0; i < TEST_CONCURRENT_REGS; i++)
+            values[i] = v;
+        mem.writeRegs(offset, TEST_CONCURRENT_REGS, values);
+    }
+    run.store(false);
+    for (size_t t = 0; t < readers.size(); t++)
+        readers[t].join();
+    TEST_CHECK(torn.load() == 0, "%s concurrent read: %d torn reads of %llu", kind, torn.load(), static_cast<unsigned long long>(reads.load()));
+}
+
+int main()
+{
+    testBits(false);
+    testBits(true);
+    testCopyBits(false, false);
+    testCopyBits(false, true);
+    testCopyBits(true, false);
+    testCopyBits(true, true);
+    testConcurrentRead(false);
+    testConcurrentRead(true);
+    if (s_errors)
+    {
+        fprintf(stderr, "server_memoryblock_test: %d check(s) failed\n", s_errors);
+        return 1;
+    }
+    printf("server_memoryblock_test: all checks passed\n");
+    return 0;
+}